@@ -2,6 +2,10 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     QLepp2DLib \
-    QLepp2DGui
+    QLepp2DGui \
+    QLepp2DCli \
+    QLepp2DBench
 
 QLepp2DGui.depends = QLepp2DLib
+QLepp2DCli.depends = QLepp2DLib
+QLepp2DBench.depends = QLepp2DLib
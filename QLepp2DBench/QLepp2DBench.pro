@@ -0,0 +1,55 @@
+QT       += core
+QT       -= gui
+
+TARGET = qlepp2d-bench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# Benchmarks must not pay for the debug output of the engines
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp \
+        allocationbenchmark.cpp \
+        allocationhooks.cpp \
+        benchmark.cpp \
+        independencebenchmark.cpp \
+        meshgenerator.cpp \
+        phasebenchmark.cpp \
+        regressionbenchmark.cpp \
+        scalingbenchmark.cpp
+
+HEADERS += \
+        allocationbenchmark.h \
+        benchmark.h \
+        independencebenchmark.h \
+        meshgenerator.h \
+        phasebenchmark.h \
+        regressionbenchmark.h \
+        scalingbenchmark.h
+
+unix:!macx {
+    LIBS += -lOpenCL
+}
+
+macx: {
+    LIBS += -framework OpenCL
+}
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../QLepp2DLib/release/ -lqlepp2d-lib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../QLepp2DLib/debug/ -lqlepp2d-lib
+else:unix: LIBS += -L$$OUT_PWD/../QLepp2DLib/ -lqlepp2d-lib
+
+INCLUDEPATH += $$PWD $$PWD/../QLepp2DLib
+DEPENDPATH += $$PWD/../QLepp2DLib
+
+# Useful when not installing the app, but testing it in a local environment
+QMAKE_LFLAGS += -Wl,-rpath,$$OUT_PWD/../QLepp2DLib/
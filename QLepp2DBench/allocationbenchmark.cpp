@@ -0,0 +1,141 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QDir>
+#include <QFile>
+
+#include <cstdio>
+#include <memory>
+
+#include <allocationbenchmark.h>
+#include <filehandlers/offhandler.h>
+
+AllocationBenchmark::AllocationBenchmark(float angle, QString workdir)
+    : m_angle(angle),
+      m_workdir(workdir)
+{
+}
+
+QStringList AllocationBenchmark::columns()
+{
+    return QStringList() << "engine" << "threads" << "triangles" << "call" << "round"
+                         << "phase" << "allocations" << "bytes";
+}
+
+bool AllocationBenchmark::run(QString name,
+                              std::function<Engine*()> factory,
+                              const Mesh &mesh,
+                              const std::vector<unsigned int> &threads,
+                              Report &report) const
+{
+    // Saved before counting, so loading is measured from the file like in the applications
+    OFFHandler handler;
+    std::string filepath = QDir(m_workdir).filePath(
+        QString("qlepp2d-allocations-%1.off").arg(mesh.triangles.size())).toStdString();
+    Mesh input(mesh);
+    if (not handler.save(filepath, input.vertices, input.edges, input.triangles))
+    {
+        fprintf(stderr, "Could not write \"%s\".\n", filepath.c_str());
+        return false;
+    }
+
+    bool ok(true);
+    for (unsigned int count : threads)
+    {
+        std::unique_ptr<Engine> engine(factory());
+        if (not engine)
+        {
+            ok = false;
+            break;
+        }
+
+        // Engines without threads only run once
+        bool threaded = engine->setThreadCount(count);
+        if (not threaded and count != threads.front())
+        {
+            continue;
+        }
+        unsigned int used = threaded ? count : 1;
+        fprintf(stderr, "  %s with %u threads:\n", qPrintable(name), used);
+
+        Mesh work;
+        AllocationTracker::reset();
+        AllocationTracker::setEnabled(true);
+
+        handler.load(filepath, work.vertices, work.edges, work.triangles);
+        summarize(name, used, work, "load", 0, report);
+
+        engine->detectBadTriangles(m_angle, work.vertices, work.triangles);
+        summarize(name, used, work, "detectBadTriangles", 0, report);
+
+        for (unsigned long round(1); ; round++)
+        {
+            if (not engine->improveTriangulation(work.vertices, work.edges, work.triangles))
+            {
+                ok = false;
+                break;
+            }
+            summarize(name, used, work, "improveTriangulation", round, report);
+
+            if (work.vertices.size() == engine->getChanges().firstVertex)
+            {
+                break;
+            }
+        }
+
+        AllocationTracker::setEnabled(false);
+    }
+
+    QFile::remove(QString::fromStdString(filepath));
+    return ok;
+}
+
+void AllocationBenchmark::summarize(QString name,
+                                    unsigned int threads,
+                                    const Mesh &mesh,
+                                    QString call,
+                                    unsigned long round,
+                                    Report &report) const
+{
+    // Counting stops while printing, as the report allocates too
+    AllocationTracker::setEnabled(false);
+    std::vector<AllocationTracker::PhaseAllocations> allocations = AllocationTracker::getAllocations();
+
+    fprintf(stderr, "    %s", qPrintable(call));
+    if (round > 0)
+    {
+        fprintf(stderr, " (round %lu)", round);
+    }
+    fprintf(stderr, ":");
+    for (const AllocationTracker::PhaseAllocations &phase : allocations)
+    {
+        fprintf(stderr, " %s %llu (%.1f KB)", phase.phase.c_str(), phase.allocations, phase.bytes / 1024.0);
+        report.add(QVariantList() << name
+                                  << threads
+                                  << static_cast<qulonglong>(mesh.triangles.size())
+                                  << call
+                                  << static_cast<qulonglong>(round)
+                                  << QString::fromStdString(phase.phase)
+                                  << static_cast<qulonglong>(phase.allocations)
+                                  << static_cast<qulonglong>(phase.bytes));
+    }
+    fprintf(stderr, "\n");
+
+    AllocationTracker::reset();
+    AllocationTracker::setEnabled(true);
+}
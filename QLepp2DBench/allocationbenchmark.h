@@ -0,0 +1,92 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ALLOCATIONBENCHMARK_H
+#define ALLOCATIONBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <vector>
+
+#include <benchmark.h>
+#include <meshgenerator.h>
+#include <engine/engine.h>
+#include <metrics/allocationtracker.h>
+
+/**
+* @brief Counts the heap allocations (and their bytes) of each library phase
+* while a mesh is loaded from an OFF file, its bad triangles are detected and
+* it's improved until no centroid can be inserted. A summary of the phases is
+* printed after each call.
+*
+* Allocations are seen through the allocator hooks of the benchmark.
+*
+*/
+class AllocationBenchmark
+{
+public:
+    /**
+    * @brief Constructor of AllocationBenchmark.
+    *
+    * @param angle p_angle: Minimum angle of the refinement.
+    * @param workdir p_workdir: Directory of the temporary OFF files.
+    */
+    AllocationBenchmark(float angle, QString workdir);
+
+    /**
+    * @brief Columns of the rows added by this benchmark.
+    *
+    */
+    static QStringList columns();
+
+    /**
+    * @brief Refines a mesh with each thread count, adding a row for each
+    * phase of each call.
+    *
+    * @param name p_name: Name of the engine in the report.
+    * @param factory p_factory: Creates a new engine.
+    * @param mesh p_mesh: Mesh to refine.
+    * @param threads p_threads: Thread counts.
+    * @param report p_report: Where rows are added.
+    * @return False if the engine can't be set up or the OFF file can't be written.
+    */
+    bool run(QString name,
+             std::function<Engine*()> factory,
+             const Mesh &mesh,
+             const std::vector<unsigned int> &threads,
+             Report &report) const;
+
+private:
+    /**
+    * @brief Prints and adds the allocations since the last reset, and resets them.
+    *
+    */
+    void summarize(QString name,
+                   unsigned int threads,
+                   const Mesh &mesh,
+                   QString call,
+                   unsigned long round,
+                   Report &report) const;
+
+    float m_angle;
+    QString m_workdir;
+};
+
+#endif // ALLOCATIONBENCHMARK_H
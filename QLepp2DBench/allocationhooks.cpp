@@ -0,0 +1,159 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include <metrics/allocationtracker.h>
+
+/* Replaces the allocator of the whole benchmark process, so AllocationTracker
+ * sees every allocation of the library. Qt containers (QString, QVector,
+ * QMap...) call malloc and realloc directly, so with glibc the C allocator is
+ * interposed (operator new also ends up there). That includes the aligned
+ * functions, which glibc doesn't route through malloc and which the aligned
+ * operator new uses. Elsewhere only operator new is replaced, and the
+ * allocations of Qt (and the aligned ones) aren't counted.
+ */
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+    void *__libc_malloc(std::size_t size);
+    void *__libc_calloc(std::size_t count, std::size_t size);
+    void *__libc_realloc(void *pointer, std::size_t size);
+    void *__libc_memalign(std::size_t alignment, std::size_t size);
+    void *__libc_valloc(std::size_t size);
+    void *__libc_pvalloc(std::size_t size);
+
+    void *malloc(std::size_t size)
+    {
+        AllocationTracker::record(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(std::size_t count, std::size_t size)
+    {
+        AllocationTracker::record(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *pointer, std::size_t size)
+    {
+        AllocationTracker::record(size);
+        return __libc_realloc(pointer, size);
+    }
+
+    void *memalign(std::size_t alignment, std::size_t size)
+    {
+        AllocationTracker::record(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    // glibc doesn't export these two, so they're built on memalign with the checks of POSIX and C11
+    int posix_memalign(void **pointer, std::size_t alignment, std::size_t size)
+    {
+        if (alignment == 0 or alignment % sizeof(void*) != 0 or (alignment & (alignment - 1)) != 0)
+        {
+            return EINVAL;
+        }
+        AllocationTracker::record(size);
+        void *result = __libc_memalign(alignment, size);
+        if (result == nullptr)
+        {
+            return ENOMEM;
+        }
+        *pointer = result;
+        return 0;
+    }
+
+    void *aligned_alloc(std::size_t alignment, std::size_t size)
+    {
+        if (alignment == 0 or (alignment & (alignment - 1)) != 0)
+        {
+            errno = EINVAL;
+            return nullptr;
+        }
+        AllocationTracker::record(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *valloc(std::size_t size)
+    {
+        AllocationTracker::record(size);
+        return __libc_valloc(size);
+    }
+
+    void *pvalloc(std::size_t size)
+    {
+        AllocationTracker::record(size);
+        return __libc_pvalloc(size);
+    }
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    AllocationTracker::record(size);
+    void *pointer = std::malloc(size > 0 ? size : 1);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    AllocationTracker::record(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
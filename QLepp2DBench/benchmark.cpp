@@ -0,0 +1,206 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+#include <benchmark.h>
+
+Statistics Statistics::of(std::vector<long long> &samples)
+{
+    Statistics stats;
+    if (samples.empty())
+    {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    // Nearest-rank percentiles
+    auto percentile = [&samples](double p) {
+        unsigned long rank = static_cast<unsigned long>(p * samples.size() + 0.999999);
+        return samples.at(std::min(std::max(rank, 1ul), samples.size()) - 1);
+    };
+
+    stats.samples = samples.size();
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.median = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    return stats;
+}
+
+Runner::Runner(unsigned int warmup, unsigned int repetitions)
+    : m_warmup(warmup),
+      m_repetitions(repetitions > 0 ? repetitions : 1)
+{
+}
+
+std::vector<long long> Runner::run(std::function<long long()> iteration) const
+{
+    for (unsigned int i(0); i < m_warmup; i++)
+    {
+        iteration();
+    }
+
+    std::vector<long long> samples;
+    samples.reserve(m_repetitions);
+    for (unsigned int i(0); i < m_repetitions; i++)
+    {
+        samples.push_back(iteration());
+    }
+    return samples;
+}
+
+unsigned int Runner::warmup() const
+{
+    return m_warmup;
+}
+
+unsigned int Runner::repetitions() const
+{
+    return m_repetitions;
+}
+
+Report::Report(QStringList columns)
+    : m_columns(columns)
+{
+}
+
+void Report::add(QVariantList values)
+{
+    m_rows.append(values);
+}
+
+bool Report::write(QString path, QString format) const
+{
+    QString text;
+    if (format == "csv")
+    {
+        text = toCsv();
+    }
+    else if (format == "json")
+    {
+        text = toJson();
+    }
+    else
+    {
+        text = toTable();
+    }
+
+    QFile file(path);
+    bool opened = (path == "-") ?
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text) :
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+
+    if (not opened)
+    {
+        return false;
+    }
+    file.write(text.toUtf8());
+    return true;
+}
+
+QString Report::toCsv() const
+{
+    QString text(m_columns.join(",") + "\n");
+    for (const QVariantList &row : m_rows)
+    {
+        QStringList cells;
+        for (const QVariant &value : row)
+        {
+            cells << value.toString();
+        }
+        text += cells.join(",") + "\n";
+    }
+    return text;
+}
+
+QString Report::toJson() const
+{
+    QJsonArray rows;
+    for (const QVariantList &row : m_rows)
+    {
+        QJsonObject object;
+        for (int i(0); i < m_columns.size() and i < row.size(); i++)
+        {
+            object.insert(m_columns.at(i), QJsonValue::fromVariant(row.at(i)));
+        }
+        rows.append(object);
+    }
+    return QString::fromUtf8(QJsonDocument(rows).toJson());
+}
+
+QString Report::toTable() const
+{
+    // Width of each column, so values are right-aligned under their names
+    QVector<int> widths;
+    for (const QString &column : m_columns)
+    {
+        widths.append(column.size());
+    }
+    for (const QVariantList &row : m_rows)
+    {
+        for (int i(0); i < row.size() and i < widths.size(); i++)
+        {
+            widths[i] = std::max(widths[i], row.at(i).toString().size());
+        }
+    }
+
+    QString text;
+    for (int i(0); i < m_columns.size(); i++)
+    {
+        text += m_columns.at(i).rightJustified(widths.at(i) + 2);
+    }
+    text += "\n";
+    for (const QVariantList &row : m_rows)
+    {
+        for (int i(0); i < row.size() and i < widths.size(); i++)
+        {
+            text += row.at(i).toString().rightJustified(widths.at(i) + 2);
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+bool pinToCpu(int cpu)
+{
+#ifdef Q_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    Q_UNUSED(cpu);
+    return false;
+#endif
+}
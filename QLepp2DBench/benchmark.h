@@ -0,0 +1,134 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#include <functional>
+#include <vector>
+
+/**
+* @brief Summary of the samples of a measurement, in nanoseconds.
+*
+*/
+struct Statistics
+{
+    unsigned long samples = 0;
+    long long min = 0;
+    long long median = 0;
+    double mean = 0;
+    long long p90 = 0;
+    long long p99 = 0;
+    long long max = 0;
+
+    /**
+    * @brief Summarizes a set of samples.
+    *
+    * @param samples p_samples: Measured times. Sorted in place.
+    * @return Statistics of the samples.
+    */
+    static Statistics of(std::vector<long long> &samples);
+};
+
+/**
+* @brief Runs a measurement several times, discarding the first (warmup) runs,
+* so caches, page tables and OpenCL runtimes are already warm when timing.
+*
+*/
+class Runner
+{
+public:
+    /**
+    * @brief Constructor of Runner.
+    *
+    * @param warmup p_warmup: Discarded runs.
+    * @param repetitions p_repetitions: Measured runs.
+    */
+    Runner(unsigned int warmup, unsigned int repetitions);
+
+    /**
+    * @brief Runs an iteration warmup + repetitions times. Each iteration does
+    * its own (untimed) setup and returns the time of the measured part.
+    *
+    * @param iteration p_iteration: Function that returns nanoseconds.
+    * @return Times of the measured runs.
+    */
+    std::vector<long long> run(std::function<long long()> iteration) const;
+
+    unsigned int warmup() const;
+    unsigned int repetitions() const;
+
+private:
+    unsigned int m_warmup;
+    unsigned int m_repetitions;
+};
+
+/**
+* @brief Table of results, written as CSV, JSON or aligned text.
+*
+*/
+class Report
+{
+public:
+    /**
+    * @brief Constructor of Report.
+    *
+    * @param columns p_columns: Names of the columns.
+    */
+    explicit Report(QStringList columns);
+
+    /**
+    * @brief Adds a row. Must have a value for each column.
+    *
+    * @param values p_values: Values of the row.
+    */
+    void add(QVariantList values);
+
+    /**
+    * @brief Writes the report.
+    *
+    * @param path p_path: File path. "-" writes to stdout.
+    * @param format p_format: "csv", "json" or "table".
+    * @return True if correctly written.
+    */
+    bool write(QString path, QString format) const;
+
+    QString toCsv() const;
+    QString toJson() const;
+    QString toTable() const;
+
+private:
+    QStringList m_columns;
+    QList<QVariantList> m_rows;
+};
+
+/**
+* @brief Pins the calling thread (and the threads it creates later) to a CPU,
+* to reduce the noise of migrations between cores.
+*
+* @param cpu p_cpu: Index of the CPU.
+* @return True if pinned. Only supported on Linux.
+*/
+bool pinToCpu(int cpu);
+
+#endif // BENCHMARK_H
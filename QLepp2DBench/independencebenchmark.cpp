@@ -0,0 +1,152 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QElapsedTimer>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <independencebenchmark.h>
+
+namespace
+{
+    template<typename T>
+    bool sameElements(const MeshVector<T> &a, const MeshVector<T> &b)
+    {
+        return a.size() == b.size() and std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+    }
+}
+
+IndependenceBenchmark::IndependenceBenchmark(float angle, unsigned long seed, MeshGenerator::Kind kind)
+    : m_angle(angle),
+      m_seed(seed),
+      m_kind(kind)
+{
+}
+
+QStringList IndependenceBenchmark::columns()
+{
+    return QStringList() << "engine" << "models" << "seed" << "triangles" << "refined_triangles"
+                         << "rounds" << "sequential_ns" << "concurrent_ns" << "identical";
+}
+
+bool IndependenceBenchmark::run(QString name,
+                                std::function<bool(Model&)> setup,
+                                unsigned long triangles,
+                                unsigned int models,
+                                Report &report,
+                                unsigned int &mismatches) const
+{
+    std::vector<Mesh> inputs;
+    for (unsigned int i(0); i < models; i++)
+    {
+        inputs.push_back(MeshGenerator(m_seed + i, m_kind).generate(triangles));
+    }
+
+    // Reference: one Model at a time
+    std::vector<Mesh> expected(models);
+    std::vector<unsigned long> rounds(models, 0);
+    QElapsedTimer timer;
+    timer.start();
+    for (unsigned int i(0); i < models; i++)
+    {
+        if (not refine(setup, inputs[i], expected[i], rounds[i]))
+        {
+            return false;
+        }
+    }
+    long long sequential = timer.nsecsElapsed();
+
+    // Every Model at once, each one on its own thread
+    std::vector<Mesh> actual(models);
+    std::vector<unsigned long> actualRounds(models, 0);
+    std::vector<char> refined(models, 0);
+    std::vector<std::thread> workers;
+    timer.start();
+    for (unsigned int i(0); i < models; i++)
+    {
+        workers.emplace_back([this, &setup, &inputs, &actual, &actualRounds, &refined, i]() {
+            refined[i] = refine(setup, inputs[i], actual[i], actualRounds[i]);
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    long long concurrent = timer.nsecsElapsed();
+
+    fprintf(stderr, "  %u models: %.3f s one after another, %.3f s at once\n",
+            models, sequential / 1e9, concurrent / 1e9);
+
+    for (unsigned int i(0); i < models; i++)
+    {
+        bool identical = (refined[i] and
+                          actualRounds[i] == rounds[i] and
+                          sameElements(expected[i].vertices, actual[i].vertices) and
+                          sameElements(expected[i].edges, actual[i].edges) and
+                          sameElements(expected[i].triangles, actual[i].triangles));
+        if (not identical)
+        {
+            mismatches++;
+        }
+
+        report.add(QVariantList() << name
+                                  << models
+                                  << static_cast<qulonglong>(m_seed + i)
+                                  << static_cast<qulonglong>(inputs[i].triangles.size())
+                                  << static_cast<qulonglong>(expected[i].triangles.size())
+                                  << static_cast<qulonglong>(rounds[i])
+                                  << sequential
+                                  << concurrent
+                                  << (identical ? "yes" : "no"));
+    }
+    return true;
+}
+
+bool IndependenceBenchmark::refine(std::function<bool(Model&)> setup,
+                                   const Mesh &input,
+                                   Mesh &output,
+                                   unsigned long &rounds) const
+{
+    Model model;
+    if (not setup(model))
+    {
+        return false;
+    }
+
+    model.getVertices() = input.vertices;
+    model.getEdges() = input.edges;
+    model.getTriangles() = input.triangles;
+
+    if (not model.detectBadTriangles(m_angle))
+    {
+        return false;
+    }
+    while (model.improveTriangulation() and model.getInsertionCount() > 0)
+    {
+        rounds++;
+    }
+
+    output.vertices = model.getVertices();
+    output.edges = model.getEdges();
+    output.triangles = model.getTriangles();
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INDEPENDENCEBENCHMARK_H
+#define INDEPENDENCEBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+#include <benchmark.h>
+#include <meshgenerator.h>
+#include <model.h>
+
+/**
+* @brief Checks that Model instances are independent: several seeded meshes
+* are refined by their own Model, first one after another and then all at
+* once on their own threads, and both runs must give the same meshes.
+*
+*/
+class IndependenceBenchmark
+{
+public:
+    /**
+    * @brief Constructor of IndependenceBenchmark.
+    *
+    * @param angle p_angle: Minimum angle of the refinement.
+    * @param seed p_seed: Seed of the first mesh. Mesh i uses seed + i.
+    * @param kind p_kind: Kind of the meshes.
+    */
+    IndependenceBenchmark(float angle, unsigned long seed, MeshGenerator::Kind kind);
+
+    /**
+    * @brief Columns of the rows added by this benchmark.
+    *
+    */
+    static QStringList columns();
+
+    /**
+    * @brief Refines the meshes sequentially and concurrently, and adds a row
+    * for each mesh.
+    *
+    * @param name p_name: Name of the engine in the report.
+    * @param setup p_setup: Sets the engine of a new Model.
+    * @param triangles p_triangles: Size of each mesh.
+    * @param models p_models: Number of meshes, Models and threads.
+    * @param report p_report: Where rows are added.
+    * @param mismatches p_mismatches: Incremented for each mesh whose
+    * concurrent output differs from the sequential one.
+    * @return False if the engine can't be set up.
+    */
+    bool run(QString name,
+             std::function<bool(Model&)> setup,
+             unsigned long triangles,
+             unsigned int models,
+             Report &report,
+             unsigned int &mismatches) const;
+
+private:
+    /**
+    * @brief Refines a mesh with a new Model until no centroid can be inserted.
+    *
+    * @param setup p_setup: Sets the engine of the Model.
+    * @param input p_input: Mesh to refine.
+    * @param output p_output: Refined mesh.
+    * @param rounds p_rounds: Improvements with insertions.
+    * @return False if the engine can't be set up or the refinement fails.
+    */
+    bool refine(std::function<bool(Model&)> setup,
+                const Mesh &input,
+                Mesh &output,
+                unsigned long &rounds) const;
+
+    float m_angle;
+    unsigned long m_seed;
+    MeshGenerator::Kind m_kind;
+};
+
+#endif // INDEPENDENCEBENCHMARK_H
@@ -0,0 +1,514 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include <allocationbenchmark.h>
+#include <benchmark.h>
+#include <independencebenchmark.h>
+#include <meshgenerator.h>
+#include <phasebenchmark.h>
+#include <regressionbenchmark.h>
+#include <scalingbenchmark.h>
+#include <engine/cpuengine.h>
+#include <engine/openclengine.h>
+
+/* Like qlepp2d-cli, no QCoreApplication is created, so nothing but the
+ * library runs in the measured process.
+ */
+
+namespace
+{
+    bool verbose(false);
+
+    void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+    {
+        // The engines log every phase; that's only useful when debugging the benchmark
+        if (not verbose and (type == QtDebugMsg or type == QtInfoMsg))
+        {
+            return;
+        }
+        QByteArray line = qFormatLogMessage(type, context, msg).toLocal8Bit();
+        fprintf(stderr, "%s\n", line.constData());
+    }
+
+    /**
+    * @brief Creates an engine by name. Returns nullptr if it can't be set up.
+    *
+    */
+    Engine* createEngine(QString name, unsigned long platform, unsigned long device)
+    {
+        try
+        {
+            if (name == "cpu")
+            {
+                return new CPUEngine;
+            }
+            if (name == "opencl")
+            {
+                return new OpenCLEngine(platform, device);
+            }
+        }
+        catch (...)
+        {
+        }
+        return nullptr;
+    }
+
+    /**
+    * @brief Sets the engine of a Model by name.
+    *
+    */
+    bool setEngine(Model &model, QString name, unsigned long platform, unsigned long device)
+    {
+        if (name == "cpu")
+        {
+            return model.setCPUEngine();
+        }
+        if (name == "opencl")
+        {
+            return model.setOpenCLEngine(platform, device);
+        }
+        return false;
+    }
+
+    /**
+    * @brief Thread counts of a scaling study: "N" means 1..N, "a,b,c" is a list.
+    *
+    */
+    std::vector<unsigned int> parseThreads(QString value)
+    {
+        std::vector<unsigned int> threads;
+        QStringList list = value.split(",", QString::SkipEmptyParts);
+        if (list.size() == 1)
+        {
+            for (unsigned int count(1); count <= list.at(0).toUInt(); count++)
+            {
+                threads.push_back(count);
+            }
+            return threads;
+        }
+        for (QString count : list)
+        {
+            if (count.toUInt() > 0)
+            {
+                threads.push_back(count.toUInt());
+            }
+        }
+        return threads;
+    }
+
+    void runPhases(const std::vector<unsigned long> &sizes,
+                   QStringList engines,
+                   std::function<Engine*(QString)> factory,
+                   const MeshGenerator &generator,
+                   const PhaseBenchmark &benchmark,
+                   Report &report)
+    {
+        for (unsigned long size : sizes)
+        {
+            fprintf(stderr, "Generating a mesh of %lu triangles...\n", size);
+            Mesh mesh = generator.generate(size);
+
+            for (QString name : engines)
+            {
+                std::unique_ptr<Engine> engine(factory(name));
+                if (not engine)
+                {
+                    fprintf(stderr, "Skipping engine \"%s\": it couldn't be set up.\n", qPrintable(name));
+                    continue;
+                }
+
+                fprintf(stderr, "  %s...\n", qPrintable(name));
+                benchmark.runEngine(name, engine.get(), mesh, report);
+            }
+
+            fprintf(stderr, "  files...\n");
+            benchmark.runFiles(mesh, report);
+        }
+    }
+
+    bool runScaling(unsigned long size,
+                    QStringList engines,
+                    std::function<Engine*(QString)> factory,
+                    const std::vector<unsigned int> &threads,
+                    QString scaling,
+                    const ScalingBenchmark &benchmark,
+                    Report &report)
+    {
+        bool ok(true);
+        for (QString name : engines)
+        {
+            auto create = [&factory, name]() { return factory(name); };
+
+            double ratio(0);
+            bool identical = benchmark.checkBaseline(create, size, ratio);
+            if (ratio == 0)
+            {
+                fprintf(stderr, "Skipping engine \"%s\": it doesn't accept a thread count.\n", qPrintable(name));
+                continue;
+            }
+            fprintf(stderr, "%s with 1 thread: %.3fx the time of CPUEngine, %s output\n",
+                    qPrintable(name), ratio, identical ? "identical" : "DIFFERENT");
+            ok = (ok and identical);
+
+            for (QString kind : QStringList() << "strong" << "weak")
+            {
+                if (scaling == kind or scaling == "both")
+                {
+                    fprintf(stderr, "  %s scaling...\n", qPrintable(kind));
+                    unsigned int mismatches(0);
+                    benchmark.run(name, create, size, threads, kind == "weak", report, mismatches);
+                    if (mismatches > 0)
+                    {
+                        fprintf(stderr, "  %u thread counts gave a DIFFERENT output than 1 thread\n", mismatches);
+                        ok = false;
+                    }
+                }
+            }
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QStringList arguments;
+    for (int i(0); i < argc; i++)
+    {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the phases of the QLepp2D engines.");
+    parser.addHelpOption();
+
+    QCommandLineOption modeOption(QStringList() << "m" << "mode",
+                                  "Benchmark to run: phases, scaling, regress, allocations or independence.",
+                                  "mode", "phases");
+    QCommandLineOption sizesOption(QStringList() << "s" << "sizes",
+                                   "Comma-separated mesh sizes, in triangles. Scaling uses the first one "
+                                   "(per thread, for weak scaling).",
+                                   "list", "1e3,1e4,1e5,1e6,1e7");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads",
+                                     "Scaling and allocations thread counts: N for 1..N, or a list like 1,2,4,8. "
+                                     "Independence uses the largest one as the number of models.",
+                                     "threads", QString::number(std::max(1u, std::thread::hardware_concurrency())));
+    QCommandLineOption scalingOption("scaling",
+                                     "Scaling study: strong, weak or both.",
+                                     "kind", "both");
+    QCommandLineOption enginesOption(QStringList() << "e" << "engines",
+                                     "Comma-separated engines: cpu, opencl.",
+                                     "list", "cpu,opencl");
+    QCommandLineOption platformOption("platform",
+                                      "Index of the OpenCL platform (e.g. a CPU runtime like PoCL).",
+                                      "index", "0");
+    QCommandLineOption deviceOption("device",
+                                    "Index of the OpenCL device in the platform.",
+                                    "index", "0");
+    QCommandLineOption warmupOption(QStringList() << "w" << "warmup",
+                                    "Discarded runs before measuring.",
+                                    "count", "2");
+    QCommandLineOption repetitionsOption(QStringList() << "r" << "repetitions",
+                                         "Measured runs.",
+                                         "count", "10");
+    QCommandLineOption pinOption(QStringList() << "p" << "pin",
+                                 "Pins the benchmark (and the threads it creates) to a CPU. Not allowed with --mode scaling.",
+                                 "cpu");
+    QCommandLineOption angleOption(QStringList() << "a" << "angle",
+                                   "Minimum angle of a good triangle, in degrees.",
+                                   "degrees", "30");
+    QCommandLineOption seedOption("seed",
+                                  "Seed of the generated meshes.",
+                                  "seed", "1");
+    QCommandLineOption meshOption("mesh",
+                                  "Generated meshes: grid (stretched) or random (Delaunay).",
+                                  "kind", "grid");
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                    "Output format: csv, json or table.",
+                                    "format", "csv");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Output file. \"-\" uses stdout.",
+                                    "file", "-");
+    QCommandLineOption workdirOption("workdir",
+                                     "Directory of the temporary OFF files.",
+                                     "dir", QDir::tempPath());
+    QCommandLineOption baselineOption("baseline",
+                                      "Regress: baseline to compare against.",
+                                      "file");
+    QCommandLineOption saveBaselineOption("save-baseline",
+                                          "Regress: saves the samples of this run as a baseline.",
+                                          "file");
+    QCommandLineOption thresholdOption("threshold",
+                                       "Regress: tolerated growth of the median of a phase, in percent.",
+                                       "percent", "5");
+    QCommandLineOption alphaOption("alpha",
+                                   "Regress: significance level of the Mann-Whitney U test.",
+                                   "level", "0.01");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose",
+                                     "Prints the log of the library to stderr.");
+
+    parser.addOption(modeOption);
+    parser.addOption(sizesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(scalingOption);
+    parser.addOption(enginesOption);
+    parser.addOption(platformOption);
+    parser.addOption(deviceOption);
+    parser.addOption(warmupOption);
+    parser.addOption(repetitionsOption);
+    parser.addOption(pinOption);
+    parser.addOption(angleOption);
+    parser.addOption(seedOption);
+    parser.addOption(meshOption);
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(workdirOption);
+    parser.addOption(baselineOption);
+    parser.addOption(saveBaselineOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(alphaOption);
+    parser.addOption(verboseOption);
+
+    if (not parser.parse(arguments))
+    {
+        fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 1;
+    }
+
+    if (parser.isSet("help"))
+    {
+        fprintf(stdout, "%s", qPrintable(parser.helpText()));
+        return 0;
+    }
+
+    verbose = parser.isSet(verboseOption);
+    qInstallMessageHandler(messageHandler);
+
+    // Every worker would share the one CPU, so the scaling would be meaningless
+    if (parser.isSet(pinOption) and parser.value(modeOption) == "scaling")
+    {
+        fprintf(stderr, "--pin can't be used with --mode scaling.\n");
+        return 1;
+    }
+
+    // Pinning goes first, so the OpenCL runtime threads inherit it
+    if (parser.isSet(pinOption) and not pinToCpu(parser.value(pinOption).toInt()))
+    {
+        fprintf(stderr, "Could not pin to CPU %s.\n", qPrintable(parser.value(pinOption)));
+        return 1;
+    }
+
+    std::vector<unsigned long> sizes;
+    for (QString size : parser.value(sizesOption).split(",", QString::SkipEmptyParts))
+    {
+        // Accepts "1e6" as well as "1000000"
+        bool ok(false);
+        double value = size.toDouble(&ok);
+        if (not ok or value < 2)
+        {
+            fprintf(stderr, "Invalid size \"%s\".\n", qPrintable(size));
+            return 1;
+        }
+        sizes.push_back(static_cast<unsigned long>(value));
+    }
+
+    QStringList engines = parser.value(enginesOption).split(",", QString::SkipEmptyParts);
+    unsigned long platform = parser.value(platformOption).toULong();
+    unsigned long device = parser.value(deviceOption).toULong();
+    auto factory = [platform, device](QString name) { return createEngine(name, platform, device); };
+
+    Runner runner(parser.value(warmupOption).toUInt(), parser.value(repetitionsOption).toUInt());
+    QString meshKind = parser.value(meshOption);
+    if (meshKind != "grid" and meshKind != "random")
+    {
+        fprintf(stderr, "Unknown mesh kind \"%s\".\n", qPrintable(meshKind));
+        return 1;
+    }
+    MeshGenerator generator(parser.value(seedOption).toULong(),
+                            (meshKind == "random") ? MeshGenerator::Random : MeshGenerator::Grid);
+    float angle = parser.value(angleOption).toFloat();
+    QString mode = parser.value(modeOption);
+    int status(0);
+
+    QStringList columns(PhaseBenchmark::columns());
+    if (mode == "scaling")
+    {
+        columns = ScalingBenchmark::columns();
+    }
+    else if (mode == "regress")
+    {
+        columns = RegressionBenchmark::columns();
+    }
+    else if (mode == "allocations")
+    {
+        columns = AllocationBenchmark::columns();
+    }
+    else if (mode == "independence")
+    {
+        columns = IndependenceBenchmark::columns();
+    }
+
+    Report report(columns);
+    if (mode == "phases")
+    {
+        PhaseBenchmark benchmark(runner, angle, parser.value(workdirOption));
+        runPhases(sizes, engines, factory, generator, benchmark, report);
+    }
+    else if (mode == "scaling")
+    {
+        std::vector<unsigned int> threads = parseThreads(parser.value(threadsOption));
+        if (threads.empty())
+        {
+            fprintf(stderr, "Invalid thread counts.\n");
+            return 1;
+        }
+
+        ScalingBenchmark benchmark(runner, angle, generator);
+        if (not runScaling(sizes.front(), engines, factory, threads, parser.value(scalingOption), benchmark, report))
+        {
+            // Results are still written, but a wrong baseline must not go unnoticed
+            status = 6;
+        }
+
+        // A readable table, besides the plot-ready output
+        fprintf(stderr, "%s", qPrintable(report.toTable()));
+    }
+    else if (mode == "regress")
+    {
+        if (not parser.isSet(baselineOption) and not parser.isSet(saveBaselineOption))
+        {
+            fprintf(stderr, "Regress needs --baseline, --save-baseline or both.\n");
+            return 1;
+        }
+
+        Baseline baseline;
+        if (parser.isSet(baselineOption) and not baseline.load(parser.value(baselineOption)))
+        {
+            fprintf(stderr, "Could not read the baseline \"%s\".\n", qPrintable(parser.value(baselineOption)));
+            return 2;
+        }
+
+        Baseline current;
+        current.seed = parser.value(seedOption).toULong();
+        RegressionBenchmark benchmark(runner, angle, generator, parser.value(workdirOption));
+        for (QString name : engines)
+        {
+            fprintf(stderr, "%s...\n", qPrintable(name));
+            if (not benchmark.run(name, platform, device, sizes, meshKind, current))
+            {
+                return 4;
+            }
+        }
+
+        if (parser.isSet(saveBaselineOption) and not current.save(parser.value(saveBaselineOption)))
+        {
+            fprintf(stderr, "Could not write \"%s\".\n", qPrintable(parser.value(saveBaselineOption)));
+            return 3;
+        }
+
+        // Without a baseline every phase is reported as new
+        unsigned int regressions = RegressionBenchmark::compare(baseline, current,
+                                                                parser.value(thresholdOption).toDouble() / 100,
+                                                                parser.value(alphaOption).toDouble(),
+                                                                report);
+        fprintf(stderr, "%s", qPrintable(report.toTable()));
+        if (regressions > 0)
+        {
+            fprintf(stderr, "%u phases regressed.\n", regressions);
+            status = 7;
+        }
+    }
+    else if (mode == "allocations")
+    {
+        std::vector<unsigned int> threads = parseThreads(parser.value(threadsOption));
+        if (threads.empty())
+        {
+            fprintf(stderr, "Invalid thread counts.\n");
+            return 1;
+        }
+
+        AllocationBenchmark benchmark(angle, parser.value(workdirOption));
+        for (unsigned long size : sizes)
+        {
+            fprintf(stderr, "Generating a mesh of %lu triangles...\n", size);
+            Mesh mesh = generator.generate(size);
+            for (QString name : engines)
+            {
+                auto create = [&factory, name]() { return factory(name); };
+                if (not benchmark.run(name, create, mesh, threads, report))
+                {
+                    fprintf(stderr, "Skipping engine \"%s\": it couldn't be set up.\n", qPrintable(name));
+                }
+            }
+        }
+    }
+    else if (mode == "independence")
+    {
+        std::vector<unsigned int> threads = parseThreads(parser.value(threadsOption));
+        if (threads.empty())
+        {
+            fprintf(stderr, "Invalid thread counts.\n");
+            return 1;
+        }
+        unsigned int models = *std::max_element(threads.begin(), threads.end());
+
+        IndependenceBenchmark benchmark(angle, parser.value(seedOption).toULong(),
+                                        (meshKind == "random") ? MeshGenerator::Random : MeshGenerator::Grid);
+        for (QString name : engines)
+        {
+            auto setup = [name, platform, device](Model &model) { return setEngine(model, name, platform, device); };
+            fprintf(stderr, "%s...\n", qPrintable(name));
+
+            unsigned int mismatches(0);
+            if (not benchmark.run(name, setup, sizes.front(), models, report, mismatches))
+            {
+                fprintf(stderr, "Skipping engine \"%s\": it couldn't be set up.\n", qPrintable(name));
+                continue;
+            }
+            if (mismatches > 0)
+            {
+                // Concurrent Models must never affect each other's results
+                fprintf(stderr, "  %u meshes were DIFFERENT when refined concurrently\n", mismatches);
+                status = 8;
+            }
+        }
+        fprintf(stderr, "%s", qPrintable(report.toTable()));
+    }
+    else
+    {
+        fprintf(stderr, "Unknown mode \"%s\".\n", qPrintable(mode));
+        return 1;
+    }
+
+    if (not report.write(parser.value(outputOption), parser.value(formatOption)))
+    {
+        fprintf(stderr, "Could not write \"%s\".\n", qPrintable(parser.value(outputOption)));
+        return 3;
+    }
+
+    return status;
+}
@@ -0,0 +1,90 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <random>
+
+#include <meshgenerator.h>
+#include <filehandlers/topologybuilder.h>
+#include <triangulation/randommeshgenerator.h>
+
+MeshGenerator::MeshGenerator(unsigned long seed, Kind kind)
+    : m_seed(seed),
+      m_kind(kind)
+{
+}
+
+Mesh MeshGenerator::generate(unsigned long triangles) const
+{
+    return (m_kind == Random) ? random(triangles) : grid(triangles);
+}
+
+Mesh MeshGenerator::grid(unsigned long triangles) const
+{
+    // Square grid of cells, 2 triangles per cell
+    int n = std::max(1, static_cast<int>(std::lround(std::sqrt(triangles / 2.0))));
+    const float width(1.0f);
+    const float height(0.25f);
+
+    std::mt19937_64 generator(m_seed);
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+    Mesh mesh;
+    mesh.vertices.reserve(static_cast<unsigned long>((n + 1) * (n + 1)));
+    for (int j(0); j <= n; j++)
+    {
+        for (int i(0); i <= n; i++)
+        {
+            // Border vertices stay on the border, so the domain is a rectangle
+            bool inner = (i > 0 and i < n and j > 0 and j < n);
+            Vertex v;
+            v.x = (i + (inner ? jitter(generator) : 0)) * width;
+            v.y = (j + (inner ? jitter(generator) : 0)) * height;
+            v.z = 0;
+            mesh.vertices.push_back(v);
+        }
+    }
+
+    mesh.triangles.reserve(2ul * static_cast<unsigned long>(n * n));
+    for (int j(0); j < n; j++)
+    {
+        for (int i(0); i < n; i++)
+        {
+            int a = j * (n + 1) + i;
+            int b = a + 1;
+            int c = a + n + 1;
+            int d = c + 1;
+            mesh.triangles.push_back(Triangle{a, b, d, -1, -1, -1, 0});
+            mesh.triangles.push_back(Triangle{a, d, c, -1, -1, -1, 0});
+        }
+    }
+
+    TopologyBuilder builder;
+    builder.build(mesh.edges, mesh.triangles);
+    return mesh;
+}
+
+Mesh MeshGenerator::random(unsigned long triangles) const
+{
+    // A Delaunay mesh of n random points in a square has about 2n triangles
+    Mesh mesh;
+    RandomMeshGenerator generator(m_seed);
+    generator.generate(triangles / 2 + 2, mesh.vertices, mesh.edges, mesh.triangles);
+    return mesh;
+}
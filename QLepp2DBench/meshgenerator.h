@@ -0,0 +1,96 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MESHGENERATOR_H
+#define MESHGENERATOR_H
+
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Mesh of a benchmark.
+*
+*/
+struct Mesh
+{
+    MeshVector<Vertex> vertices;
+    MeshVector<Edge> edges;
+    MeshVector<Triangle> triangles;
+};
+
+/**
+* @brief Generates reproducible benchmark meshes without reading files.
+*
+*/
+class MeshGenerator
+{
+public:
+    /**
+    * @brief Kind of the meshes returned by generate().
+    *
+    */
+    enum Kind
+    {
+        Grid,
+        Random
+    };
+
+    /**
+    * @brief Constructor of MeshGenerator.
+    *
+    * @param seed p_seed: Seed of the random displacements and points.
+    * @param kind p_kind: Kind of the meshes returned by generate().
+    */
+    explicit MeshGenerator(unsigned long seed = 1, Kind kind = Grid);
+
+    /**
+    * @brief Generates a mesh of the kind given to the constructor.
+    *
+    * @param triangles p_triangles: Approximate number of triangles.
+    * @return Mesh with complete topology.
+    */
+    Mesh generate(unsigned long triangles) const;
+
+    /**
+    * @brief Generates a grid of stretched cells (4:1), each one split in two
+    * triangles, with its inner vertices slightly displaced. Most triangles
+    * are bad for angles above ~15 degrees, like the meshes of the examples.
+    *
+    * @param triangles p_triangles: Approximate number of triangles.
+    * @return Mesh with complete topology.
+    */
+    Mesh grid(unsigned long triangles) const;
+
+    /**
+    * @brief Generates the Delaunay mesh of uniformly random points, like the
+    * meshes of RandomMeshGenerator in the library.
+    *
+    * @param triangles p_triangles: Approximate number of triangles.
+    * @return Mesh with complete topology.
+    */
+    Mesh random(unsigned long triangles) const;
+
+private:
+    unsigned long m_seed;
+    Kind m_kind;
+};
+
+#endif // MESHGENERATOR_H
@@ -0,0 +1,191 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <phasebenchmark.h>
+#include <engine/cpuengine.h>
+#include <filehandlers/offhandler.h>
+#include <filehandlers/topologybuilder.h>
+
+namespace
+{
+    /**
+    * @brief CPUEngine that times every insertCentroid call of insertCentroids.
+    *
+    */
+    class InstrumentedCPUEngine : public CPUEngine
+    {
+    public:
+        void insertCentroidsTimed(MeshVector<Vertex> &vertices,
+                                  MeshVector<Edge> &edges,
+                                  MeshVector<Triangle> &triangles,
+                                  std::vector<long long> &calls)
+        {
+            beginChanges(vertices, edges, triangles);
+
+            QElapsedTimer timer;
+            for (unsigned int ie(0); ie < edges.size(); ie++)
+            {
+                Edge &e(edges.at(ie));
+                if (e.isTE and e.itb != -1)
+                {
+                    timer.start();
+                    insertCentroid(static_cast<int>(ie), vertices, edges, triangles);
+                    calls.push_back(timer.nsecsElapsed());
+                }
+            }
+
+            endChanges();
+        }
+    };
+}
+
+PhaseBenchmark::PhaseBenchmark(const Runner &runner, float angle, QString workdir)
+    : m_runner(runner),
+      m_angle(angle),
+      m_workdir(workdir)
+{
+}
+
+QStringList PhaseBenchmark::columns()
+{
+    return QStringList() << "engine" << "triangles" << "benchmark" << "unit" << "samples"
+                         << "min_ns" << "median_ns" << "mean_ns" << "p90_ns" << "p99_ns" << "max_ns";
+}
+
+void PhaseBenchmark::runEngine(QString name, Engine *engine, const Mesh &mesh, Report &report) const
+{
+    // Every repetition starts from a copy of the same input, made out of the timed region.
+    Mesh work;
+    QElapsedTimer timer;
+    bool flag(false);
+
+    std::vector<long long> samples = m_runner.run([&]() {
+        work = mesh;
+        timer.start();
+        engine->detectBadTriangles(m_angle, work.vertices, work.triangles);
+        return timer.nsecsElapsed();
+    });
+    add(report, name, mesh, "detectBadTriangles", "call", samples);
+
+    samples = m_runner.run([&]() {
+        work = mesh;
+        engine->detectBadTriangles(m_angle, work.vertices, work.triangles);
+        timer.start();
+        engine->detectTerminalEdges(work.vertices, work.edges, work.triangles, flag);
+        return timer.nsecsElapsed();
+    });
+    add(report, name, mesh, "detectTerminalEdges", "call", samples);
+
+    samples = m_runner.run([&]() {
+        work = mesh;
+        engine->detectBadTriangles(m_angle, work.vertices, work.triangles);
+        engine->detectTerminalEdges(work.vertices, work.edges, work.triangles, flag);
+        timer.start();
+        engine->insertCentroids(work.vertices, work.edges, work.triangles);
+        return timer.nsecsElapsed();
+    });
+    add(report, name, mesh, "insertCentroids", "batch", samples);
+
+    // insertCentroid is only a CPU function (OpenCLEngine also inserts on CPU)
+    if (dynamic_cast<CPUEngine*>(engine) == nullptr)
+    {
+        return;
+    }
+
+    InstrumentedCPUEngine instrumented;
+    std::vector<long long> calls;
+    unsigned int iteration(0);
+    m_runner.run([&]() {
+        work = mesh;
+        instrumented.detectBadTriangles(m_angle, work.vertices, work.triangles);
+        instrumented.detectTerminalEdges(work.vertices, work.edges, work.triangles, flag);
+
+        std::vector<long long> measured;
+        measured.reserve(work.edges.size() / 4);
+        instrumented.insertCentroidsTimed(work.vertices, work.edges, work.triangles, measured);
+
+        // Calls of the warmup runs are discarded too
+        if (iteration++ >= m_runner.warmup())
+        {
+            calls.insert(calls.end(), measured.begin(), measured.end());
+        }
+        return 0ll;
+    });
+    add(report, name, mesh, "insertCentroid", "insertion", calls);
+}
+
+void PhaseBenchmark::runFiles(const Mesh &mesh, Report &report) const
+{
+    OFFHandler handler;
+    Mesh work(mesh);
+    QElapsedTimer timer;
+    std::string filepath = QDir(m_workdir).filePath(
+        QString("qlepp2d-bench-%1.off").arg(mesh.triangles.size())).toStdString();
+
+    std::vector<long long> samples = m_runner.run([&]() {
+        timer.start();
+        handler.save(filepath, work.vertices, work.edges, work.triangles);
+        return timer.nsecsElapsed();
+    });
+    add(report, "-", mesh, "offSave", "file", samples);
+
+    // Files are read from the page cache after the warmup, so this is mostly parsing
+    samples = m_runner.run([&]() {
+        timer.start();
+        handler.load(filepath, work.vertices, work.edges, work.triangles);
+        return timer.nsecsElapsed();
+    });
+    add(report, "-", mesh, "offLoad", "file", samples);
+
+    TopologyBuilder builder;
+    samples = m_runner.run([&]() {
+        work.triangles = mesh.triangles;
+        timer.start();
+        builder.build(work.edges, work.triangles);
+        return timer.nsecsElapsed();
+    });
+    add(report, "-", mesh, "topologyBuild", "mesh", samples);
+
+    QFile::remove(QString::fromStdString(filepath));
+}
+
+void PhaseBenchmark::add(Report &report,
+                         QString engine,
+                         const Mesh &mesh,
+                         QString benchmark,
+                         QString unit,
+                         std::vector<long long> &samples) const
+{
+    Statistics stats = Statistics::of(samples);
+    report.add(QVariantList() << engine
+                              << static_cast<qulonglong>(mesh.triangles.size())
+                              << benchmark
+                              << unit
+                              << static_cast<qulonglong>(stats.samples)
+                              << stats.min
+                              << stats.median
+                              << stats.mean
+                              << stats.p90
+                              << stats.p99
+                              << stats.max);
+}
@@ -0,0 +1,89 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHASEBENCHMARK_H
+#define PHASEBENCHMARK_H
+
+#include <QString>
+
+#include <functional>
+
+#include <benchmark.h>
+#include <meshgenerator.h>
+#include <engine/engine.h>
+
+/**
+* @brief Times each phase of the refinement, and the mesh I/O, on its own.
+*
+*/
+class PhaseBenchmark
+{
+public:
+    /**
+    * @brief Constructor of PhaseBenchmark.
+    *
+    * @param runner p_runner: Warmup and repetitions of each measurement.
+    * @param angle p_angle: Minimum angle used to detect bad triangles.
+    * @param workdir p_workdir: Directory of the temporary OFF files.
+    */
+    PhaseBenchmark(const Runner &runner, float angle, QString workdir);
+
+    /**
+    * @brief Columns of the rows added by this benchmark.
+    *
+    */
+    static QStringList columns();
+
+    /**
+    * @brief Times detectBadTriangles, detectTerminalEdges and insertCentroids
+    * of an engine. CPUEngine also gets the time of each insertCentroid call.
+    *
+    * @param name p_name: Name of the engine in the report.
+    * @param engine p_engine: Engine to measure.
+    * @param mesh p_mesh: Unmodified input of every repetition.
+    * @param report p_report: Where rows are added.
+    */
+    void runEngine(QString name, Engine *engine, const Mesh &mesh, Report &report) const;
+
+    /**
+    * @brief Times OFF saving, OFF loading and the topology building alone.
+    *
+    * @param mesh p_mesh: Mesh to save and load.
+    * @param report p_report: Where rows are added.
+    */
+    void runFiles(const Mesh &mesh, Report &report) const;
+
+private:
+    /**
+    * @brief Adds the statistics of a measurement to the report.
+    *
+    */
+    void add(Report &report,
+             QString engine,
+             const Mesh &mesh,
+             QString benchmark,
+             QString unit,
+             std::vector<long long> &samples) const;
+
+    Runner m_runner;
+    float m_angle;
+    QString m_workdir;
+};
+
+#endif // PHASEBENCHMARK_H
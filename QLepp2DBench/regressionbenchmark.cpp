@@ -0,0 +1,362 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+#include <model.h>
+#include <regressionbenchmark.h>
+#include <filehandlers/offhandler.h>
+
+bool Baseline::save(QString path) const
+{
+    QJsonObject workloads;
+    for (const auto &workload : samples)
+    {
+        QJsonObject phases;
+        for (const auto &phase : workload.second)
+        {
+            QJsonArray values;
+            for (long long value : phase.second)
+            {
+                values.append(static_cast<double>(value));
+            }
+            phases.insert(phase.first, values);
+        }
+        workloads.insert(workload.first, phases);
+    }
+
+    QJsonObject root;
+    root.insert("mesh", mesh);
+    root.insert("angle", static_cast<double>(angle));
+    root.insert("seed", static_cast<double>(seed));
+    root.insert("workloads", workloads);
+
+    QFile file(path);
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    return file.write(QJsonDocument(root).toJson()) >= 0;
+}
+
+bool Baseline::load(QString path)
+{
+    QFile file(path);
+    if (not file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError or not document.isObject())
+    {
+        return false;
+    }
+
+    QJsonObject root = document.object();
+    mesh = root.value("mesh").toString();
+    angle = static_cast<float>(root.value("angle").toDouble());
+    seed = static_cast<unsigned long>(root.value("seed").toDouble());
+    samples.clear();
+
+    QJsonObject workloads = root.value("workloads").toObject();
+    for (auto workload = workloads.constBegin(); workload != workloads.constEnd(); ++workload)
+    {
+        QJsonObject phases = workload.value().toObject();
+        for (auto phase = phases.constBegin(); phase != phases.constEnd(); ++phase)
+        {
+            std::vector<long long> &values = samples[workload.key()][phase.key()];
+            QJsonArray array = phase.value().toArray();
+            for (int i(0); i < array.size(); i++)
+            {
+                values.push_back(static_cast<long long>(array.at(i).toDouble()));
+            }
+        }
+    }
+    return true;
+}
+
+RegressionBenchmark::RegressionBenchmark(const Runner &runner,
+                                         float angle,
+                                         const MeshGenerator &generator,
+                                         QString workdir)
+    : m_runner(runner),
+      m_angle(angle),
+      m_generator(generator),
+      m_workdir(workdir)
+{
+}
+
+QStringList RegressionBenchmark::columns()
+{
+    return QStringList() << "workload" << "phase" << "baseline_samples" << "samples"
+                         << "baseline_median_ns" << "median_ns" << "change_pct" << "p_value" << "verdict";
+}
+
+bool RegressionBenchmark::run(QString engine,
+                              unsigned long platform,
+                              unsigned long device,
+                              const std::vector<unsigned long> &sizes,
+                              QString mesh,
+                              Baseline &baseline) const
+{
+    baseline.mesh = mesh;
+    baseline.angle = m_angle;
+
+    Model model;
+    bool set(false);
+    if (engine == "cpu")
+    {
+        set = model.setCPUEngine();
+    }
+    else if (engine == "opencl")
+    {
+        set = model.setOpenCLEngine(platform, device);
+    }
+    if (not set)
+    {
+        fprintf(stderr, "Engine \"%s\" couldn't be set up.\n", qPrintable(engine));
+        return false;
+    }
+
+    for (unsigned long size : sizes)
+    {
+        QString workload = QString("%1-%2-%3").arg(engine).arg(mesh).arg(size);
+        fprintf(stderr, "  %s...\n", qPrintable(workload));
+
+        // The input is generated once and read from the page cache in every repetition
+        std::string input = QDir(m_workdir).filePath(
+            QString("qlepp2d-regress-%1.off").arg(workload)).toStdString();
+        std::string output = QDir(m_workdir).filePath(
+            QString("qlepp2d-regress-%1-out.off").arg(workload)).toStdString();
+        {
+            Mesh generated = m_generator.generate(size);
+            OFFHandler handler;
+            if (not handler.save(input, generated.vertices, generated.edges, generated.triangles))
+            {
+                fprintf(stderr, "Could not write \"%s\".\n", input.c_str());
+                return false;
+            }
+        }
+
+        std::map<QString, std::vector<long long>> &phases = baseline.samples[workload];
+        QElapsedTimer timer;
+        unsigned int iteration(0);
+        bool ok(true);
+
+        m_runner.run([&]() {
+            long long load(0), detect(0), improve(0), save(0);
+
+            timer.start();
+            ok = (ok and model.loadFile(input));
+            load = timer.nsecsElapsed();
+
+            timer.start();
+            ok = (ok and model.detectBadTriangles(m_angle));
+            detect = timer.nsecsElapsed();
+
+            // Refined until converged, so every repetition does the same rounds
+            timer.start();
+            while (ok)
+            {
+                ok = model.improveTriangulation();
+                if (not ok or model.getInsertionCount() == 0)
+                {
+                    break;
+                }
+            }
+            improve = timer.nsecsElapsed();
+
+            timer.start();
+            ok = (ok and model.saveFile(output));
+            save = timer.nsecsElapsed();
+
+            // Warmup runs are discarded, like the ones of Runner
+            if (iteration++ >= m_runner.warmup())
+            {
+                phases["load"].push_back(load);
+                phases["detect"].push_back(detect);
+                phases["improve"].push_back(improve);
+                phases["save"].push_back(save);
+            }
+            return load + detect + improve + save;
+        });
+
+        QFile::remove(QString::fromStdString(input));
+        QFile::remove(QString::fromStdString(output));
+
+        if (not ok)
+        {
+            fprintf(stderr, "Workload \"%s\" failed.\n", qPrintable(workload));
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int RegressionBenchmark::compare(const Baseline &baseline,
+                                          const Baseline &current,
+                                          double threshold,
+                                          double alpha,
+                                          Report &report)
+{
+    if (not baseline.samples.empty() and
+        (baseline.mesh != current.mesh or baseline.angle != current.angle or baseline.seed != current.seed))
+    {
+        fprintf(stderr, "Warning: the baseline was measured with %s meshes, angle %g and seed %lu.\n",
+                qPrintable(baseline.mesh),
+                static_cast<double>(baseline.angle), baseline.seed);
+    }
+
+    unsigned int regressions(0);
+    auto add = [&report](QString workload, QString phase,
+                         std::vector<long long> before, std::vector<long long> after,
+                         double change, double p, QString verdict) {
+        Statistics reference = Statistics::of(before);
+        Statistics measured = Statistics::of(after);
+        report.add(QVariantList() << workload
+                                  << phase
+                                  << static_cast<qulonglong>(reference.samples)
+                                  << static_cast<qulonglong>(measured.samples)
+                                  << reference.median
+                                  << measured.median
+                                  << change
+                                  << p
+                                  << verdict);
+    };
+
+    for (const auto &workload : current.samples)
+    {
+        for (const auto &phase : workload.second)
+        {
+            const std::vector<long long> &after = phase.second;
+
+            auto phases = baseline.samples.find(workload.first);
+            if (phases == baseline.samples.end() or phases->second.count(phase.first) == 0)
+            {
+                add(workload.first, phase.first, {}, after, 0, 1, "new");
+                continue;
+            }
+            const std::vector<long long> &before = phases->second.at(phase.first);
+
+            std::vector<long long> sorted(before);
+            double reference = static_cast<double>(Statistics::of(sorted).median);
+            sorted = after;
+            double measured = static_cast<double>(Statistics::of(sorted).median);
+            double change = (reference > 0) ? (measured / reference - 1) : 0;
+
+            QString verdict("ok");
+            double p = mannWhitney(before, after);
+            if (change > threshold and p < alpha)
+            {
+                verdict = "regression";
+                regressions++;
+            }
+            else if (change < -threshold and mannWhitney(after, before) < alpha)
+            {
+                p = mannWhitney(after, before);
+                verdict = "improvement";
+            }
+            add(workload.first, phase.first, before, after, 100 * change, p, verdict);
+        }
+    }
+
+    // Phases that weren't measured this time are reported, but can't regress
+    for (const auto &workload : baseline.samples)
+    {
+        for (const auto &phase : workload.second)
+        {
+            auto phases = current.samples.find(workload.first);
+            if (phases == current.samples.end() or phases->second.count(phase.first) == 0)
+            {
+                add(workload.first, phase.first, phase.second, {}, 0, 1, "missing");
+            }
+        }
+    }
+    return regressions;
+}
+
+double RegressionBenchmark::mannWhitney(const std::vector<long long> &before, const std::vector<long long> &after)
+{
+    if (before.empty() or after.empty())
+    {
+        return 1;
+    }
+
+    // Pooled samples, marking the ones of "after"
+    std::vector<std::pair<long long, bool>> pooled;
+    pooled.reserve(before.size() + after.size());
+    for (long long value : before)
+    {
+        pooled.emplace_back(value, false);
+    }
+    for (long long value : after)
+    {
+        pooled.emplace_back(value, true);
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    // Rank sum of "after"; tied values get the average of their ranks
+    double n = static_cast<double>(pooled.size());
+    double rankSum(0);
+    double ties(0);
+    for (std::size_t first(0); first < pooled.size();)
+    {
+        std::size_t last(first);
+        while (last < pooled.size() and pooled.at(last).first == pooled.at(first).first)
+        {
+            last++;
+        }
+        double rank = (first + 1 + last) / 2.0;
+        double tied = static_cast<double>(last - first);
+        ties += tied * tied * tied - tied;
+        for (std::size_t i(first); i < last; i++)
+        {
+            if (pooled.at(i).second)
+            {
+                rankSum += rank;
+            }
+        }
+        first = last;
+    }
+
+    double na = static_cast<double>(before.size());
+    double nb = static_cast<double>(after.size());
+    double u = rankSum - nb * (nb + 1) / 2;
+    double mean = na * nb / 2;
+    double variance = na * nb / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0)
+    {
+        // Every sample is the same value
+        return 1;
+    }
+
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
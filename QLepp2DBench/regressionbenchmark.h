@@ -0,0 +1,146 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REGRESSIONBENCHMARK_H
+#define REGRESSIONBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <vector>
+
+#include <benchmark.h>
+#include <meshgenerator.h>
+
+/**
+* @brief Measured samples of the phases of each workload, in nanoseconds.
+* Saved as JSON, so a later run can be compared against it.
+*
+*/
+struct Baseline
+{
+    QString mesh;
+    float angle = 0;
+    unsigned long seed = 0;
+
+    /**
+    * @brief Samples by workload ("cpu-grid-1000") and phase ("load").
+    *
+    */
+    std::map<QString, std::map<QString, std::vector<long long>>> samples;
+
+    /**
+    * @brief Saves the baseline.
+    *
+    * @param path p_path: JSON file path.
+    * @return True if correctly saved.
+    */
+    bool save(QString path) const;
+
+    /**
+    * @brief Loads a baseline saved by save().
+    *
+    * @param path p_path: JSON file path.
+    * @return True if correctly loaded.
+    */
+    bool load(QString path);
+};
+
+/**
+* @brief Runs a fixed set of workloads through Model (load an OFF file,
+* detect bad triangles, improve until no centroid can be inserted, save it)
+* and compares them against a baseline.
+*
+* A phase regresses when its median grows more than a threshold and the
+* growth is significant: a one-sided Mann-Whitney U test over the
+* repetitions, so a single noisy run doesn't fail the comparison.
+*
+*/
+class RegressionBenchmark
+{
+public:
+    /**
+    * @brief Constructor of RegressionBenchmark.
+    *
+    * @param runner p_runner: Warmup and repetitions of each workload.
+    * @param angle p_angle: Minimum angle of the refinement.
+    * @param generator p_generator: Generator of the meshes.
+    * @param workdir p_workdir: Directory of the temporary OFF files.
+    */
+    RegressionBenchmark(const Runner &runner, float angle, const MeshGenerator &generator, QString workdir);
+
+    /**
+    * @brief Columns of the rows added by compare().
+    *
+    */
+    static QStringList columns();
+
+    /**
+    * @brief Runs every workload with an engine.
+    *
+    * @param engine p_engine: "cpu" or "opencl".
+    * @param platform p_platform: OpenCL platform.
+    * @param device p_device: OpenCL device.
+    * @param sizes p_sizes: Mesh sizes, in triangles. One workload each.
+    * @param mesh p_mesh: Name of the kind of the generated meshes.
+    * @param baseline p_baseline: Where samples are added.
+    * @return False if the engine can't be set up or a phase fails.
+    */
+    bool run(QString engine,
+             unsigned long platform,
+             unsigned long device,
+             const std::vector<unsigned long> &sizes,
+             QString mesh,
+             Baseline &baseline) const;
+
+    /**
+    * @brief Compares each phase of a run against a baseline and adds a row
+    * for each one.
+    *
+    * @param baseline p_baseline: Reference samples.
+    * @param current p_current: Samples of the new run.
+    * @param threshold p_threshold: Tolerated growth of the median, as a ratio (0.05 is 5%).
+    * @param alpha p_alpha: Significance level of the test.
+    * @param report p_report: Where rows are added.
+    * @return Number of regressed phases.
+    */
+    static unsigned int compare(const Baseline &baseline,
+                                const Baseline &current,
+                                double threshold,
+                                double alpha,
+                                Report &report);
+
+    /**
+    * @brief One-sided Mann-Whitney U test, with the normal approximation
+    * corrected for ties and continuity.
+    *
+    * @param before p_before: Reference samples.
+    * @param after p_after: New samples.
+    * @return p-value of "after is stochastically greater than before".
+    */
+    static double mannWhitney(const std::vector<long long> &before, const std::vector<long long> &after);
+
+private:
+    Runner m_runner;
+    float m_angle;
+    MeshGenerator m_generator;
+    QString m_workdir;
+};
+
+#endif // REGRESSIONBENCHMARK_H
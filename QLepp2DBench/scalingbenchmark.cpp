@@ -0,0 +1,234 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include <scalingbenchmark.h>
+#include <engine/cpuengine.h>
+
+namespace
+{
+    template<typename T>
+    bool sameElements(const MeshVector<T> &a, const MeshVector<T> &b)
+    {
+        return a.size() == b.size() and std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+    }
+
+    bool sameMesh(const Mesh &a, const Mesh &b)
+    {
+        return (sameElements(a.vertices, b.vertices) and
+                sameElements(a.edges, b.edges) and
+                sameElements(a.triangles, b.triangles));
+    }
+}
+
+ScalingBenchmark::ScalingBenchmark(const Runner &runner, float angle, const MeshGenerator &generator)
+    : m_runner(runner),
+      m_angle(angle),
+      m_generator(generator)
+{
+}
+
+QStringList ScalingBenchmark::columns()
+{
+    return QStringList() << "scaling" << "engine" << "threads" << "triangles" << "refined_triangles"
+                         << "median_ns" << "speedup" << "efficiency" << "rounds" << "insertions"
+                         << "DBT_F_ns" << "DTE_F_ns" << "IC_F_ns" << "other_ns" << "identical";
+}
+
+bool ScalingBenchmark::run(QString name,
+                           std::function<Engine*()> factory,
+                           unsigned long triangles,
+                           const std::vector<unsigned int> &threads,
+                           bool weak,
+                           Report &report,
+                           unsigned int &mismatches) const
+{
+    Mesh strongMesh;
+    Mesh sequentialOutput;  // Refined with 1 thread; kept for every count when scaling is strong
+    if (not weak)
+    {
+        strongMesh = m_generator.generate(triangles);
+    }
+
+    double reference(0);
+    unsigned int referenceThreads(0);
+    for (unsigned int count : threads)
+    {
+        std::unique_ptr<Engine> engine(factory());
+        if (not engine or not engine->setThreadCount(count))
+        {
+            return false;
+        }
+
+        Mesh weakMesh;
+        if (weak)
+        {
+            weakMesh = m_generator.generate(triangles * count);
+        }
+        const Mesh &input = weak ? weakMesh : strongMesh;
+
+        Mesh output;
+        Refinement result = refine(engine.get(), input, output);
+
+        // Threads may only change the time, never the mesh
+        bool identical(true);
+        if (count == 1)
+        {
+            sequentialOutput = output;
+        }
+        else
+        {
+            if (weak or sequentialOutput.triangles.empty())
+            {
+                std::unique_ptr<Engine> sequential(factory());
+                if (not sequential or not sequential->setThreadCount(1))
+                {
+                    return false;
+                }
+                Refinement ignored;
+                sequentialOutput = input;
+                refineMesh(sequential.get(), sequentialOutput, ignored);
+            }
+            identical = sameMesh(sequentialOutput, output);
+        }
+        if (not identical)
+        {
+            mismatches++;
+        }
+
+        if (referenceThreads == 0)
+        {
+            reference = result.nanoseconds;
+            referenceThreads = count;
+        }
+
+        /* Strong: speedup = T(ref) / T(n), efficiency = speedup / (n / ref).
+         * Weak: work grows with n, so scaled speedup = (n / ref) * T(ref) / T(n),
+         * and efficiency = T(ref) / T(n).
+         */
+        double factor = static_cast<double>(count) / referenceThreads;
+        double ratio = (result.nanoseconds > 0) ? reference / result.nanoseconds : 0;
+        double speedup = weak ? factor * ratio : ratio;
+        double efficiency = weak ? ratio : ratio / factor;
+
+        long long other(result.nanoseconds);
+        for (auto &phase : result.phases)
+        {
+            other -= phase.second;
+        }
+
+        report.add(QVariantList() << (weak ? "weak" : "strong")
+                                  << name
+                                  << count
+                                  << static_cast<qulonglong>(input.triangles.size())
+                                  << static_cast<qulonglong>(output.triangles.size())
+                                  << result.nanoseconds
+                                  << speedup
+                                  << efficiency
+                                  << static_cast<qulonglong>(result.rounds)
+                                  << static_cast<qulonglong>(result.insertions)
+                                  << result.phases["DBT_F"]
+                                  << result.phases["DTE_F"]
+                                  << result.phases["IC_F"]
+                                  << std::max(other, 0ll)
+                                  << (identical ? "yes" : "no"));
+    }
+    return true;
+}
+
+bool ScalingBenchmark::checkBaseline(std::function<Engine*()> factory,
+                                     unsigned long triangles,
+                                     double &ratio) const
+{
+    std::unique_ptr<Engine> engine(factory());
+    if (not engine or not engine->setThreadCount(1))
+    {
+        ratio = 0;
+        return false;
+    }
+
+    Mesh mesh = m_generator.generate(triangles);
+
+    CPUEngine baseline;
+    Mesh expectedOutput;
+    Refinement expected = refine(&baseline, mesh, expectedOutput);
+
+    Mesh actualOutput;
+    Refinement actual = refine(engine.get(), mesh, actualOutput);
+
+    ratio = (expected.nanoseconds > 0) ? static_cast<double>(actual.nanoseconds) / expected.nanoseconds : 0;
+    return sameMesh(expectedOutput, actualOutput);
+}
+
+ScalingBenchmark::Refinement ScalingBenchmark::refine(Engine *engine, const Mesh &mesh, Mesh &output) const
+{
+    std::vector<Refinement> measured;
+    unsigned int iteration(0);
+    QElapsedTimer timer;
+
+    m_runner.run([&]() {
+        Refinement refinement;
+        output = mesh;
+
+        engine->getMetrics().setEnabled(true);
+        engine->getMetrics().clear();
+        timer.start();
+
+        refineMesh(engine, output, refinement);
+
+        refinement.nanoseconds = timer.nsecsElapsed();
+        for (auto &timing : engine->getMetrics().getTimings())
+        {
+            refinement.phases[timing.first] += timing.second;
+        }
+
+        if (iteration++ >= m_runner.warmup())
+        {
+            measured.push_back(refinement);
+        }
+        return refinement.nanoseconds;
+    });
+
+    // The run with the median time, so phases and time come from the same run
+    std::sort(measured.begin(), measured.end(), [](const Refinement &a, const Refinement &b) {
+        return a.nanoseconds < b.nanoseconds;
+    });
+    return measured.at((measured.size() - 1) / 2);
+}
+
+void ScalingBenchmark::refineMesh(Engine *engine, Mesh &mesh, Refinement &refinement) const
+{
+    engine->detectBadTriangles(m_angle, mesh.vertices, mesh.triangles);
+    while (engine->improveTriangulation(mesh.vertices, mesh.edges, mesh.triangles))
+    {
+        // Each insertion adds exactly one vertex (the centroid)
+        unsigned long insertions = mesh.vertices.size() - engine->getChanges().firstVertex;
+        if (insertions == 0)
+        {
+            break;
+        }
+        refinement.rounds++;
+        refinement.insertions += insertions;
+    }
+}
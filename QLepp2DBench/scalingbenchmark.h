@@ -0,0 +1,137 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCALINGBENCHMARK_H
+#define SCALINGBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <benchmark.h>
+#include <meshgenerator.h>
+#include <engine/engine.h>
+
+/**
+* @brief Measures how a full refinement (detect, then improve until no
+* centroid can be inserted) scales with the threads of an engine.
+*
+* Strong scaling refines the same mesh with every thread count. Weak scaling
+* gives each thread the same amount of work, so the mesh grows with the
+* thread count.
+*
+*/
+class ScalingBenchmark
+{
+public:
+    /**
+    * @brief Constructor of ScalingBenchmark.
+    *
+    * @param runner p_runner: Warmup and repetitions of each measurement.
+    * @param angle p_angle: Minimum angle of the refinement.
+    * @param generator p_generator: Generator of the meshes.
+    */
+    ScalingBenchmark(const Runner &runner, float angle, const MeshGenerator &generator);
+
+    /**
+    * @brief Columns of the rows added by this benchmark.
+    *
+    */
+    static QStringList columns();
+
+    /**
+    * @brief Refines with each thread count and adds a row for each one. The
+    * output of every thread count is compared against the same mesh refined
+    * with 1 thread.
+    *
+    * @param name p_name: Name of the engine in the report.
+    * @param factory p_factory: Creates a new engine.
+    * @param triangles p_triangles: Mesh size (per thread, for weak scaling).
+    * @param threads p_threads: Thread counts to measure. The first one is the reference.
+    * @param weak p_weak: True for weak scaling.
+    * @param report p_report: Where rows are added.
+    * @param mismatches p_mismatches: Incremented for each thread count whose
+    * output differs from the 1-thread output.
+    * @return False if the engine doesn't accept a thread count.
+    */
+    bool run(QString name,
+             std::function<Engine*()> factory,
+             unsigned long triangles,
+             const std::vector<unsigned int> &threads,
+             bool weak,
+             Report &report,
+             unsigned int &mismatches) const;
+
+    /**
+    * @brief Compares an engine running with 1 thread against CPUEngine: both
+    * must produce the same mesh, and the time ratio shows the overhead of
+    * the parallel version.
+    *
+    * @param factory p_factory: Creates a new engine.
+    * @param triangles p_triangles: Mesh size.
+    * @param ratio p_ratio: Time of the engine divided by the time of CPUEngine.
+    * 0 if the engine can't be set up or doesn't accept a thread count.
+    * @return True if both meshes are identical.
+    */
+    bool checkBaseline(std::function<Engine*()> factory,
+                       unsigned long triangles,
+                       double &ratio) const;
+
+private:
+    /**
+    * @brief Measurement of a refinement.
+    *
+    */
+    struct Refinement
+    {
+        long long nanoseconds = 0;
+        unsigned long rounds = 0;
+        unsigned long insertions = 0;
+        std::map<std::string, long long> phases;
+    };
+
+    /**
+    * @brief Refines a copy of the mesh with the runner, and returns the
+    * measurement of the median run.
+    *
+    * @param engine p_engine: Engine to measure.
+    * @param mesh p_mesh: Unmodified input of every run.
+    * @param output p_output: Refined mesh (of the last run).
+    */
+    Refinement refine(Engine *engine, const Mesh &mesh, Mesh &output) const;
+
+    /**
+    * @brief Detects, then improves the mesh until no centroid can be inserted.
+    *
+    * @param engine p_engine: Engine that refines.
+    * @param mesh p_mesh: Mesh to refine.
+    * @param refinement p_refinement: Where rounds and insertions are added.
+    */
+    void refineMesh(Engine *engine, Mesh &mesh, Refinement &refinement) const;
+
+    Runner m_runner;
+    float m_angle;
+    MeshGenerator m_generator;
+};
+
+#endif // SCALINGBENCHMARK_H
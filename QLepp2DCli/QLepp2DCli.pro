@@ -0,0 +1,46 @@
+QT       += core
+QT       -= gui
+
+TARGET = qlepp2d-cli
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp
+
+unix:!macx {
+    LIBS += -lOpenCL
+}
+
+macx: {
+    LIBS += -framework OpenCL
+}
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../QLepp2DLib/release/ -lqlepp2d-lib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../QLepp2DLib/debug/ -lqlepp2d-lib
+else:unix: LIBS += -L$$OUT_PWD/../QLepp2DLib/ -lqlepp2d-lib
+
+INCLUDEPATH += $$PWD/../QLepp2DLib
+DEPENDPATH += $$PWD/../QLepp2DLib
+
+# Useful when not installing the app, but testing it in a local environment
+QMAKE_LFLAGS += -Wl,-rpath,$$OUT_PWD/../QLepp2DLib/
+
+unix {
+    isEmpty(PREFIX)
+    {
+        PREFIX = /usr/bin
+    }
+    target.path = $$PREFIX
+    INSTALLS += target
+}
@@ -0,0 +1,611 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+
+#include <cstdio>
+
+#include <model.h>
+
+/* No QCoreApplication is created: the library doesn't need an event loop,
+ * and this keeps the startup of each invocation as short as possible.
+ */
+
+namespace
+{
+    bool verbose(false);
+
+    void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+    {
+        // The standard output may carry the mesh, so everything goes to stderr
+        if (not verbose and (type == QtDebugMsg or type == QtInfoMsg))
+        {
+            return;
+        }
+        QByteArray line = qFormatLogMessage(type, context, msg).toLocal8Bit();
+        fprintf(stderr, "%s\n", line.constData());
+    }
+
+    QJsonObject timingsToJson(const std::vector<std::pair<std::string, long long>> &timings)
+    {
+        QJsonObject phases;
+        for (auto &timing : timings)
+        {
+            QString phase(QString::fromStdString(timing.first));
+            phases.insert(phase, phases.value(phase).toDouble() + timing.second);
+        }
+        return phases;
+    }
+
+    QJsonObject countersToJson(const std::vector<std::pair<std::string, unsigned long>> &counters)
+    {
+        QJsonObject values;
+        for (auto &counter : counters)
+        {
+            values.insert(QString::fromStdString(counter.first), static_cast<double>(counter.second));
+        }
+        return values;
+    }
+
+    QJsonObject histogramToJson(const Histogram &histogram)
+    {
+        QJsonObject summary;
+        summary.insert("count", static_cast<double>(histogram.count()));
+        summary.insert("min", static_cast<double>(histogram.min()));
+        summary.insert("mean", histogram.mean());
+        summary.insert("p50", static_cast<double>(histogram.percentile(50)));
+        summary.insert("p99", static_cast<double>(histogram.percentile(99)));
+        summary.insert("max", static_cast<double>(histogram.max()));
+        return summary;
+    }
+
+    QJsonArray commandsToJson(const std::vector<DeviceCommand> &commands)
+    {
+        QJsonArray array;
+        for (const DeviceCommand &command : commands)
+        {
+            QJsonObject profile;
+            profile.insert("name", QString::fromStdString(command.name));
+            profile.insert("kind", command.kindName());
+            profile.insert("bytes", static_cast<double>(command.bytes));
+            profile.insert("latency_ns", static_cast<double>(command.latency()));
+            profile.insert("duration_ns", static_cast<double>(command.duration()));
+            if (command.kind != DeviceCommand::Kernel)
+            {
+                profile.insert("gb_per_s", command.bandwidth());
+            }
+            array.append(profile);
+        }
+        return array;
+    }
+
+    QJsonObject hardwareToJson(const HardwareCounters &counters)
+    {
+        QJsonObject values;
+        for (int counter(0); counter < HardwareCounters::Count; counter++)
+        {
+            if (counters.available[counter])
+            {
+                values.insert(HardwareCounters::name(static_cast<HardwareCounters::Counter>(counter)),
+                              static_cast<double>(counters.values[counter]));
+            }
+        }
+        if (counters.ipc() > 0)
+        {
+            values.insert("ipc", counters.ipc());
+        }
+        return values;
+    }
+
+    QJsonObject hardwareToJson(const Metrics &metrics)
+    {
+        // Each phase has the sum of its threads, and then every thread
+        QJsonObject phases;
+        for (const Metrics::PhaseCounters &value : metrics.getHardwareCounters())
+        {
+            QString phase(QString::fromStdString(value.phase));
+            QJsonObject summary(phases.contains(phase) ?
+                                phases.value(phase).toObject() :
+                                hardwareToJson(metrics.getHardwareCounters(value.phase)));
+            QJsonArray threads(summary.value("threads").toArray());
+            QJsonObject thread(hardwareToJson(value.counters));
+            thread.insert("thread", static_cast<double>(value.thread));
+            threads.append(thread);
+            summary.insert("threads", threads);
+            phases.insert(phase, summary);
+        }
+        return phases;
+    }
+
+    void accumulate(QJsonObject &total, const QJsonObject &phases)
+    {
+        for (auto it = phases.constBegin(); it != phases.constEnd(); ++it)
+        {
+            total.insert(it.key(), total.value(it.key()).toDouble() + it.value().toDouble());
+        }
+    }
+
+    bool writeReport(QString path, const QJsonObject &report)
+    {
+        QFile file(path);
+        bool opened = (path == "-") ?
+            file.open(stderr, QIODevice::WriteOnly) :
+            file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+        if (not opened)
+        {
+            return false;
+        }
+        file.write(QJsonDocument(report).toJson());
+        return true;
+    }
+
+    /**
+    * @brief Adds an input of a batch: a mesh file, or every OFF file of a directory.
+    *
+    */
+    void addInput(QString path, QStringList &inputs)
+    {
+        QFileInfo fileinfo(path);
+        if (fileinfo.isDir())
+        {
+            QDir dir(path);
+            for (QString name : dir.entryList(QStringList() << "*.off", QDir::Files, QDir::Name))
+            {
+                inputs << dir.filePath(name);
+            }
+        }
+        else
+        {
+            inputs << path;
+        }
+    }
+
+    /**
+    * @brief Reads the inputs of a batch from a list with one path per line.
+    *
+    */
+    bool readList(QString path, QStringList &inputs)
+    {
+        QFile file(path);
+        bool opened = (path == "-") ?
+            file.open(stdin, QIODevice::ReadOnly | QIODevice::Text) :
+            file.open(QIODevice::ReadOnly | QIODevice::Text);
+
+        if (not opened)
+        {
+            return false;
+        }
+
+        QTextStream in(&file);
+        while (not in.atEnd())
+        {
+            QString line = in.readLine().trimmed();
+            if (not line.isEmpty())
+            {
+                addInput(line, inputs);
+            }
+        }
+        return true;
+    }
+
+    /* Writes the trace on every way out of main, so failed runs (the ones
+     * worth looking at) get their trace too.
+     */
+    class TraceWriter
+    {
+    public:
+        TraceWriter(Model &model, QString path)
+            : m_model(model),
+              m_path(path),
+              m_started(not path.isEmpty() and model.startTrace(path.toStdString()))
+        {
+        }
+
+        ~TraceWriter()
+        {
+            if (m_started and not m_model.stopTrace())
+            {
+                fprintf(stderr, "Could not write the trace to \"%s\".\n", qPrintable(m_path));
+            }
+        }
+
+    private:
+        Model &m_model;
+        QString m_path;
+        bool m_started;
+    };
+
+    int runGenerate(Model &model, const QCommandLineParser &parser)
+    {
+        // Accepts "1e8" as well as "100000000"
+        bool ok(true);
+        double triangles = parser.value("generate").toDouble(&ok);
+        unsigned long seed = (ok) ? parser.value("seed").toULong(&ok) : 0;
+        if (not ok or triangles < 2)
+        {
+            fprintf(stderr, "Invalid number of triangles or seed.\n");
+            return 1;
+        }
+
+        // A Delaunay mesh of n random points in a square has about 2n triangles
+        if (not model.generateRandomMesh(static_cast<unsigned long>(triangles / 2) + 1, seed))
+        {
+            fprintf(stderr, "Could not generate the mesh.\n");
+            return 4;
+        }
+        if (not model.saveFile(parser.value("output").toStdString()))
+        {
+            fprintf(stderr, "Could not save \"%s\".\n", qPrintable(parser.value("output")));
+            return 3;
+        }
+        return 0;
+    }
+
+    int runBatch(Model &model,
+                 const QCommandLineParser &parser,
+                 float angle,
+                 unsigned long rounds,
+                 QJsonObject report)
+    {
+        QStringList inputs;
+        for (QString argument : parser.positionalArguments())
+        {
+            addInput(argument, inputs);
+        }
+        if (parser.isSet("list") and not readList(parser.value("list"), inputs))
+        {
+            fprintf(stderr, "Could not read the list \"%s\".\n", qPrintable(parser.value("list")));
+            return 3;
+        }
+
+        QString outputDir = parser.value("output-dir");
+        if (outputDir.isEmpty() or not QDir().mkpath(outputDir))
+        {
+            fprintf(stderr, "Batches need a writable --output-dir.\n");
+            return 1;
+        }
+
+        bool ok(true);
+        unsigned int concurrency = parser.value("jobs").toUInt(&ok);
+        if (not ok or concurrency == 0)
+        {
+            fprintf(stderr, "Invalid number of jobs.\n");
+            return 1;
+        }
+
+        // Meshes keep their file name, so the output directory mirrors the inputs
+        std::vector<BatchJob> jobs;
+        for (QString input : inputs)
+        {
+            QString output = QDir(outputDir).filePath(QFileInfo(input).fileName());
+            jobs.push_back(BatchJob{input.toStdString(), output.toStdString()});
+        }
+
+        BatchReport batch = model.processBatch(jobs, angle, rounds, concurrency);
+
+        QJsonArray results;
+        for (const BatchResult &result : batch.results)
+        {
+            QJsonObject entry;
+            entry.insert("input", QString::fromStdString(result.input));
+            entry.insert("output", QString::fromStdString(result.output));
+            entry.insert("ok", result.ok);
+            entry.insert("rounds", static_cast<double>(result.rounds));
+            entry.insert("triangles", static_cast<double>(result.triangles));
+            results.append(entry);
+        }
+
+        report.insert("jobs", static_cast<double>(concurrency));
+        report.insert("meshes", static_cast<double>(batch.meshes));
+        report.insert("failed", static_cast<double>(batch.failed));
+        report.insert("triangles", static_cast<double>(batch.triangles));
+        report.insert("seconds", batch.seconds);
+        report.insert("meshes_per_second", batch.meshesPerSecond());
+        report.insert("triangles_per_second", batch.trianglesPerSecond());
+        report.insert("results", results);
+
+        fprintf(stderr, "%lu meshes (%lu failed) in %.3f s: %.2f meshes/s, %.0f triangles/s\n",
+                batch.meshes, batch.failed, batch.seconds,
+                batch.meshesPerSecond(), batch.trianglesPerSecond());
+
+        if (parser.isSet("timings") and not writeReport(parser.value("timings"), report))
+        {
+            fprintf(stderr, "Could not write the timings to \"%s\".\n", qPrintable(parser.value("timings")));
+            return 3;
+        }
+
+        return (batch.failed == 0) ? 0 : 5;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QStringList arguments;
+    for (int i(0); i < argc; i++)
+    {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Refines a triangle mesh with the Lepp-Centroid algorithm.");
+    parser.addHelpOption();
+
+    QCommandLineOption inputOption(QStringList() << "i" << "input",
+                                   "Mesh to refine. \"-\" reads an OFF mesh from stdin.",
+                                   "file", "-");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Refined mesh. \"-\" writes an OFF mesh to stdout.",
+                                    "file", "-");
+    QCommandLineOption angleOption(QStringList() << "a" << "angle",
+                                   "Minimum angle of a good triangle, in degrees.",
+                                   "degrees", "30");
+    QCommandLineOption roundsOption(QStringList() << "r" << "rounds",
+                                    "Improvement rounds. 0 refines until no centroid can be inserted.",
+                                    "count", "0");
+    QCommandLineOption engineOption(QStringList() << "e" << "engine",
+                                    "Engine to use: cpu or opencl.",
+                                    "engine", "cpu");
+    QCommandLineOption platformOption("platform",
+                                      "Index of the OpenCL platform.",
+                                      "index", "0");
+    QCommandLineOption deviceOption("device",
+                                    "Index of the OpenCL device in the platform.",
+                                    "index", "0");
+    QCommandLineOption timingsOption(QStringList() << "t" << "timings",
+                                     "Writes the timings as JSON to this file. \"-\" uses stderr.",
+                                     "file");
+    QCommandLineOption perfOption("perf",
+                                  "Adds the hardware counters of each phase and thread to the timings (Linux).");
+    QCommandLineOption checkMemoryOption("check-memory",
+                                         "Stops refining before a round that wouldn't fit in memory.");
+    QCommandLineOption traceOption("trace",
+                                   "Writes a Chrome trace (chrome://tracing, Perfetto) of the run to this file.",
+                                   "file");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose",
+                                     "Prints the log of the library to stderr.");
+    QCommandLineOption batchOption(QStringList() << "b" << "batch",
+                                   "Refines every input (mesh files or directories) in a pipeline.");
+    QCommandLineOption listOption("list",
+                                  "Batch inputs, one per line. \"-\" reads them from stdin.",
+                                  "file");
+    QCommandLineOption outputDirOption("output-dir",
+                                       "Directory of the refined meshes of a batch.",
+                                       "dir");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+                                  "Parsing and writing threads of a batch.",
+                                  "count", "2");
+    QCommandLineOption generateOption(QStringList() << "g" << "generate",
+                                      "Writes a random Delaunay mesh of about this many triangles instead of refining.",
+                                      "triangles");
+    QCommandLineOption seedOption("seed",
+                                  "Seed of the generated mesh.",
+                                  "seed", "1");
+
+    parser.addOption(inputOption);
+    parser.addOption(outputOption);
+    parser.addOption(angleOption);
+    parser.addOption(roundsOption);
+    parser.addOption(engineOption);
+    parser.addOption(platformOption);
+    parser.addOption(deviceOption);
+    parser.addOption(timingsOption);
+    parser.addOption(perfOption);
+    parser.addOption(checkMemoryOption);
+    parser.addOption(traceOption);
+    parser.addOption(verboseOption);
+    parser.addOption(batchOption);
+    parser.addOption(listOption);
+    parser.addOption(outputDirOption);
+    parser.addOption(jobsOption);
+    parser.addOption(generateOption);
+    parser.addOption(seedOption);
+    parser.addPositionalArgument("inputs", "Meshes or directories to refine with --batch.", "[inputs...]");
+
+    if (not parser.parse(arguments))
+    {
+        fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 1;
+    }
+
+    if (parser.isSet("help"))
+    {
+        fprintf(stdout, "%s", qPrintable(parser.helpText()));
+        return 0;
+    }
+
+    verbose = parser.isSet(verboseOption);
+    qInstallMessageHandler(messageHandler);
+
+    bool ok(true);
+    float angle = parser.value(angleOption).toFloat(&ok);
+    if (not ok or angle <= 0 or angle >= 60)
+    {
+        fprintf(stderr, "The angle must be in (0, 60) degrees.\n");
+        return 1;
+    }
+
+    unsigned long rounds = parser.value(roundsOption).toULong(&ok);
+    if (not ok)
+    {
+        fprintf(stderr, "Invalid number of rounds.\n");
+        return 1;
+    }
+
+    Model model;
+    model.setMetricsEnabled(parser.isSet(timingsOption));
+    if (parser.isSet(perfOption) and not model.setHardwareCountersEnabled(true))
+    {
+        // The timings are still useful without them
+        fprintf(stderr, "Hardware counters are not available (see /proc/sys/kernel/perf_event_paranoid).\n");
+    }
+    TraceWriter traceWriter(model, parser.value(traceOption));
+    QString engine = parser.value(engineOption);
+    if (engine == "cpu")
+    {
+        model.setCPUEngine();
+    }
+    else if (engine == "opencl")
+    {
+        unsigned long platform = parser.value(platformOption).toULong();
+        unsigned long device = parser.value(deviceOption).toULong();
+        if (not model.setOpenCLEngine(platform, device))
+        {
+            fprintf(stderr, "Could not set up the OpenCL device %lu of platform %lu.\n", device, platform);
+            return 2;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Unknown engine \"%s\".\n", qPrintable(engine));
+        return 1;
+    }
+
+    QJsonObject report;
+    report.insert("engine", engine);
+    report.insert("angle", angle);
+
+    if (parser.isSet(generateOption))
+    {
+        return runGenerate(model, parser);
+    }
+
+    if (parser.isSet(batchOption))
+    {
+        return runBatch(model, parser, angle, rounds, report);
+    }
+
+    QElapsedTimer timer;
+
+    // Load
+    timer.start();
+    if (not model.loadFile(parser.value(inputOption).toStdString()))
+    {
+        fprintf(stderr, "Could not load \"%s\".\n", qPrintable(parser.value(inputOption)));
+        return 3;
+    }
+    report.insert("load_ns", static_cast<double>(timer.nsecsElapsed()));
+    report.insert("input_triangles", static_cast<double>(model.getTriangles().size()));
+
+    // Detection
+    if (not model.detectBadTriangles(angle))
+    {
+        fprintf(stderr, "Could not detect bad triangles.\n");
+        return 4;
+    }
+    QJsonObject total(timingsToJson(model.getMetrics().getTimings()));
+    report.insert("detection", total);
+    report.insert("bad_triangles", static_cast<double>(model.getMetrics().getCount("bad_triangles")));
+    if (not model.getMetrics().getHardwareCounters().empty())
+    {
+        report.insert("detection_hardware", hardwareToJson(model.getMetrics()));
+    }
+
+    // Improvement, until there aren't any more insertions or rounds
+    QJsonArray roundReports;
+    for (unsigned long round(1); rounds == 0 or round <= rounds; round++)
+    {
+        // Keep the mesh refined so far instead of running out of memory
+        MemoryReport memory(model.getMemoryReport());
+        if (parser.isSet(checkMemoryOption) and not memory.nextRoundFits())
+        {
+            fprintf(stderr, "Round %lu needs %llu host bytes (%llu available) and %llu device bytes, stopping.\n",
+                    round, memory.nextRoundHostBytes, memory.availableBytes, memory.nextRoundDeviceBytes);
+            report.insert("stopped_for_memory", true);
+            break;
+        }
+
+        if (not model.improveTriangulation())
+        {
+            fprintf(stderr, "Could not improve the triangulation in round %lu.\n", round);
+            return 4;
+        }
+
+        QJsonObject phases(timingsToJson(model.getMetrics().getTimings()));
+        accumulate(total, phases);
+
+        QJsonObject roundReport;
+        roundReport.insert("round", static_cast<double>(round));
+        roundReport.insert("insertions", static_cast<double>(model.getInsertionCount()));
+        roundReport.insert("phases", phases);
+        roundReport.insert("counters", countersToJson(model.getMetrics().getCounters()));
+        roundReport.insert("lepp_steps", histogramToJson(model.getMetrics().getHistogram("lepp_steps")));
+        if (not model.getMetrics().getCommands().empty())
+        {
+            roundReport.insert("commands", commandsToJson(model.getMetrics().getCommands()));
+        }
+        if (not model.getMetrics().getHardwareCounters().empty())
+        {
+            roundReport.insert("hardware", hardwareToJson(model.getMetrics()));
+        }
+        roundReports.append(roundReport);
+
+        if (model.getInsertionCount() == 0)
+        {
+            report.insert("converged", true);
+            break;
+        }
+    }
+    report.insert("rounds", roundReports);
+    report.insert("total", total);
+
+    // Save
+    timer.restart();
+    if (not model.saveFile(parser.value(outputOption).toStdString()))
+    {
+        fprintf(stderr, "Could not save \"%s\".\n", qPrintable(parser.value(outputOption)));
+        return 3;
+    }
+    report.insert("save_ns", static_cast<double>(timer.nsecsElapsed()));
+    report.insert("vertices", static_cast<double>(model.getVertices().size()));
+    report.insert("edges", static_cast<double>(model.getEdges().size()));
+    report.insert("triangles", static_cast<double>(model.getTriangles().size()));
+
+    MemoryReport memory(model.getMemoryReport());
+    QJsonObject memoryReport;
+    memoryReport.insert("host_bytes", static_cast<double>(memory.hostBytes()));
+    memoryReport.insert("load_transient_bytes", static_cast<double>(memory.loadTransientBytes));
+    if (not memory.devices.empty())
+    {
+        memoryReport.insert("device_bytes", static_cast<double>(memory.devices.front().bytes));
+    }
+    report.insert("memory", memoryReport);
+
+    if (not report.contains("converged"))
+    {
+        report.insert("converged", false);
+    }
+
+    if (parser.isSet(timingsOption) and not writeReport(parser.value(timingsOption), report))
+    {
+        fprintf(stderr, "Could not write the timings to \"%s\".\n", qPrintable(parser.value(timingsOption)));
+        return 3;
+    }
+
+    return 0;
+}
@@ -23,13 +23,18 @@ SOURCES += \
         mainwindow.cpp \
         about.cpp \
         tutorial.cpp \
-        openglwidget.cpp
+        openglwidget.cpp \
+        refinementworker.cpp \
+        tilebuilder.cpp
 
 HEADERS += \
         mainwindow.h \
         about.h \
         tutorial.h \
-        openglwidget.h
+        openglwidget.h \
+        refinementworker.h \
+        meshsnapshot.h \
+        tilebuilder.h
 
 FORMS += \
         mainwindow.ui \
@@ -18,6 +18,7 @@
  */
 
 #include <QApplication>
+#include <QSurfaceFormat>
 #include <QTranslator>
 #include <QLocale>
 #include <mainwindow.h>
@@ -25,6 +26,13 @@
 
 int main(int argc, char **argv)
 {
+    // Indexed drawing reads the flags of each triangle with gl_PrimitiveID
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setDepthBufferSize(24);
+    QSurfaceFormat::setDefaultFormat(format);
+
     QApplication app(argc, argv);
 
     QTranslator translator;
@@ -34,7 +34,14 @@ MainWindow::MainWindow(Model *model, QWidget *parent) :
     m_about(new About(this)),
     m_settings(new QSettings("QLepp2D", "qlepp2d", this)),
     m_recentFilesLimit(9),
-    m_model(model)
+    m_model(model),
+    m_worker(new RefinementWorker(model)),
+    m_progressBar(new QProgressBar(this)),
+    m_job(Detection),
+    m_running(false),
+    m_loaded(false),
+    m_detected(false),
+    m_rounds(0)
 {
     ui->setupUi(this);
 
@@ -54,6 +61,8 @@ MainWindow::MainWindow(Model *model, QWidget *parent) :
     QAction *save = ui->mainToolBar->addAction(ui->actionSaveTriangulation->icon(), ui->actionSaveTriangulation->text());
     QAction *reset = ui->mainToolBar->addAction(ui->actionResetView->icon(), ui->actionResetView->text());
     QAction *quit = ui->mainToolBar->addAction(ui->actionQuit->icon(), ui->actionQuit->text());
+    m_loadAction = load;
+    m_saveAction = save;
 
     // Toolbar status tips
     load->setStatusTip(ui->actionLoadTriangulation->statusTip());
@@ -67,6 +76,26 @@ MainWindow::MainWindow(Model *model, QWidget *parent) :
     connect(reset, &QAction::triggered, this, &MainWindow::resetViewClicked);
     connect(quit, &QAction::triggered, this, &MainWindow::close);
 
+    // Progress of the worker, only shown while it runs
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setMaximumWidth(300);
+    m_progressBar->hide();
+    ui->statusBar->addPermanentWidget(m_progressBar);
+
+    // Worker connections (the worker lives in its own thread)
+    qRegisterMetaType<QSharedPointer<const MeshSnapshot>>();
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &MainWindow::emitLoad, m_worker, &RefinementWorker::load);
+    connect(this, &MainWindow::emitDetect, m_worker, &RefinementWorker::detect);
+    connect(this, &MainWindow::emitImprove, m_worker, &RefinementWorker::improve);
+    connect(this, &MainWindow::emitRefine, m_worker, &RefinementWorker::refineUntilDone);
+    connect(m_worker, &RefinementWorker::progress, this, &MainWindow::refinementProgress);
+    connect(m_worker, &RefinementWorker::roundFinished, this, &MainWindow::roundFinished);
+    connect(m_worker, &RefinementWorker::finished, this, &MainWindow::refinementFinished);
+    connect(m_worker, &RefinementWorker::snapshotReady, ui->openGLWidget, &OpenGLWidget::updateSnapshot);
+    m_workerThread.start();
+
     // Default title
     setWindowTitle(windowTitle() + " (CPU)");
 
@@ -82,6 +111,11 @@ MainWindow::MainWindow(Model *model, QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    // The worker only leaves its slot (and its thread) when its work is cancelled
+    m_worker->cancel();
+    m_workerThread.quit();
+    m_workerThread.wait();
+
     writeSettings();
     delete ui;
 }
@@ -97,15 +131,39 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 void MainWindow::dropEvent(QDropEvent *event)
 {
     qDebug() << "MainWindow::dropEvent";
+    if (m_running)
+    {
+        return;
+    }
     QString filepath = event->mimeData()->urls().at(0).toLocalFile();
     loadFile(filepath);
 }
 
 void MainWindow::loadFile(QString path)
 {
+    // Nothing else may touch the Model while the worker runs
+    if (m_running)
+    {
+        return;
+    }
+
+    // The worker parses the file, and the view shows each chunk of it
+    m_job = Loading;
+    m_loadingPath = path;
+    setRunning(true);
     ui->statusBar->showMessage(tr("Loading..."));
-    std::string spath = path.toStdString();
-    if (m_model->loadFile(spath))
+    emit emitLoad(path);
+}
+
+void MainWindow::loadFinished(bool ok, bool cancelled)
+{
+    QString path(m_loadingPath);
+
+    // The view only has the parsed chunks, so it takes the whole Model again
+    // (a failed load keeps the previous triangulation)
+    emit emitUpdateData();
+
+    if (ok)
     {
         // Saving current filename so we can use it as a hint for saving the OFF file
         QFileInfo fileinfo(path);
@@ -114,10 +172,15 @@ void MainWindow::loadFile(QString path)
 
         qInfo() << m_currentFileName << "triangulation loaded." << endl;
         ui->statusBar->showMessage(tr("Loaded."));
+        m_loaded = true;
+        m_detected = false;
         ui->improveButton->setDisabled(true);
+        ui->refineButton->setDisabled(true);
         ui->detectButton->setEnabled(true);
-
-        emit emitUpdateData();
+    }
+    else if (cancelled)
+    {
+        ui->statusBar->showMessage(tr("Loading cancelled. The previous triangulation has been kept."));
     }
     else
     {
@@ -197,30 +260,127 @@ void MainWindow::resetViewClicked()
 void MainWindow::detectClicked()
 {
     qDebug() << "Detect button clicked";
-    double angle = ui->angleSpinBox->value();
+    m_job = Detection;
+    setRunning(true);
+    ui->statusBar->showMessage(tr("Detecting bad triangles..."));
+    emit emitDetect(ui->angleSpinBox->value());
+}
+
+void MainWindow::improveClicked()
+{
+    qDebug() << "Improve button clicked";
+    m_job = Improvement;
+    setRunning(true);
+    ui->statusBar->showMessage(tr("Improving triangulation..."));
+    emit emitImprove();
+}
+
+void MainWindow::refineClicked()
+{
+    qDebug() << "Refine button clicked";
+    m_job = Refinement;
+    m_rounds = 0;
+    setRunning(true);
+    ui->statusBar->showMessage(tr("Refining triangulation..."));
+    emit emitRefine();
+}
 
-    if (m_model->detectBadTriangles(static_cast<float>(angle)))
+void MainWindow::cancelClicked()
+{
+    qDebug() << "Cancel button clicked";
+    // The worker stops at the next chunk of work, leaving a consistent triangulation
+    m_worker->cancel();
+    ui->cancelButton->setDisabled(true);
+    ui->statusBar->showMessage(tr("Cancelling..."));
+}
+
+void MainWindow::refinementProgress(QString phase, qulonglong processed, qulonglong total)
+{
+    QString name(phase);
+    if (phase == "DBT_F")
     {
-        ui->improveButton->setEnabled(true);
-        ui->statusBar->showMessage(tr("Bad triangles have been detected. You can now proceed to improve them."));
-        emit emitUpdateData();
+        name = tr("Detecting bad triangles");
     }
-    else
+    else if (phase == "DTE_F")
     {
-        ui->statusBar->showMessage(tr("Unable to detect bad triangles."));
-        QMessageBox::critical(this,
-                              tr("QLepp2D"),
-                              tr("Unable to detect bad triangles."));
+        name = tr("Detecting terminal edges");
+    }
+    else if (phase == "IC_F")
+    {
+        name = tr("Inserting centroids");
     }
+    else if (phase == "LOAD_V")
+    {
+        name = tr("Reading vertices");
+    }
+    else if (phase == "LOAD_T")
+    {
+        name = tr("Reading triangles");
+    }
+    else if (phase == "LOAD_E")
+    {
+        name = tr("Building edges");
+    }
+
+    // An unknown total (points of an XYZ file) shows a busy bar
+    m_progressBar->setRange(0, total > 0 ? 1000 : 0);
+    m_progressBar->setFormat(QString("%1: %p%").arg(name));
+    m_progressBar->setValue(total > 0 ? static_cast<int>(processed * 1000 / total) : 0);
 }
 
-void MainWindow::improveClicked()
+void MainWindow::roundFinished(qulonglong round, qulonglong insertions)
 {
-    qDebug() << "Improve button clicked";
-    if (m_model->improveTriangulation())
+    m_rounds = round;
+    ui->statusBar->showMessage(tr("Round %1: %2 centroids inserted.").arg(round).arg(insertions));
+}
+
+void MainWindow::refinementFinished(bool ok, bool cancelled)
+{
+    // The view has already received the changed triangles from the worker
+    setRunning(false);
+
+    if (m_job == Loading)
+    {
+        loadFinished(ok, cancelled);
+        return;
+    }
+
+    if (cancelled)
     {
-        ui->statusBar->showMessage(tr("Triangulation has been modified."));
-        emit emitUpdateData();
+        // Cancelled improvements keep the centroids that were already inserted
+        ui->statusBar->showMessage(tr("Cancelled. The triangulation has been left consistent."));
+        return;
+    }
+
+    if (m_job == Detection)
+    {
+        if (ok)
+        {
+            m_detected = true;
+            ui->improveButton->setEnabled(true);
+            ui->refineButton->setEnabled(true);
+            ui->statusBar->showMessage(tr("Bad triangles have been detected. You can now proceed to improve them."));
+        }
+        else
+        {
+            ui->statusBar->showMessage(tr("Unable to detect bad triangles."));
+            QMessageBox::critical(this,
+                                  tr("QLepp2D"),
+                                  tr("Unable to detect bad triangles."));
+        }
+        return;
+    }
+
+    if (ok)
+    {
+        if (m_job == Refinement)
+        {
+            ui->statusBar->showMessage(tr("Triangulation has been refined in %1 rounds.").arg(m_rounds));
+        }
+        else
+        {
+            ui->statusBar->showMessage(tr("Triangulation has been modified."));
+        }
     }
     else
     {
@@ -231,6 +391,40 @@ void MainWindow::improveClicked()
     }
 }
 
+void MainWindow::setRunning(bool running)
+{
+    m_running = running;
+    if (running)
+    {
+        m_worker->reset();
+        m_progressBar->setRange(0, 1000);
+        m_progressBar->setValue(0);
+        m_progressBar->setFormat("%p%");
+    }
+    m_progressBar->setVisible(running);
+
+    // Nothing else may touch the Model while the worker runs
+    ui->cancelButton->setEnabled(running);
+    ui->detectButton->setEnabled(not running and m_loaded);
+    ui->improveButton->setEnabled(not running and m_detected);
+    ui->refineButton->setEnabled(not running and m_detected);
+    ui->angleSpinBox->setDisabled(running);
+    ui->actionLoadTriangulation->setDisabled(running);
+    ui->actionSaveTriangulation->setDisabled(running);
+    ui->actionUseCPUEngine->setDisabled(running);
+    ui->actionUseOpenCLEngine->setDisabled(running);
+    m_loadAction->setDisabled(running);
+    m_saveAction->setDisabled(running);
+    if (running)
+    {
+        ui->menuRecentTriangulations->setDisabled(true);
+    }
+    else
+    {
+        updateRecentFiles();
+    }
+}
+
 void MainWindow::cpuEngineClicked()
 {
     qDebug() << "CPU Engine button clicked";
@@ -243,7 +437,9 @@ void MainWindow::cpuEngineClicked()
     {
         ui->statusBar->showMessage(tr("Unable to set CPU engine."));
     }
+    m_detected = false;
     ui->improveButton->setDisabled(true);
+    ui->refineButton->setDisabled(true);
 }
 
 void MainWindow::openclEngineClicked()
@@ -258,7 +454,9 @@ void MainWindow::openclEngineClicked()
     {
         ui->statusBar->showMessage(tr("Unable to set OpenCL engine."));
     }
+    m_detected = false;
     ui->improveButton->setDisabled(true);
+    ui->refineButton->setDisabled(true);
 }
 
 void MainWindow::readSettings()
@@ -21,10 +21,13 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QProgressBar>
 #include <QSettings>
+#include <QThread>
 
 #include <tutorial.h>
 #include <about.h>
+#include <refinementworker.h>
 #include <model.h>
 
 namespace Ui {
@@ -43,6 +46,10 @@ signals:
     void emitUpdateModel(Model *model);
     void emitUpdateData();
     void resetView();
+    void emitLoad(QString path);
+    void emitDetect(double angle);
+    void emitImprove();
+    void emitRefine();
 
 protected:
     void dragEnterEvent(QDragEnterEvent *event);
@@ -57,11 +64,17 @@ private slots:
     void loadAboutQtClicked();
     void detectClicked();
     void improveClicked();
+    void refineClicked();
+    void cancelClicked();
+    void refinementProgress(QString phase, qulonglong processed, qulonglong total);
+    void roundFinished(qulonglong round, qulonglong insertions);
+    void refinementFinished(bool ok, bool cancelled);
     void cpuEngineClicked();
     void openclEngineClicked();
 
 private:
     void loadFile(QString path);
+    void loadFinished(bool ok, bool cancelled);
     void saveFile(QString path);
     void readSettings();
     void writeSettings();
@@ -69,6 +82,15 @@ private:
     void removeRecentFile(QString path);
     void updateRecentFiles();
     void clearRecentFiles();
+    void setRunning(bool running);
+
+    enum Job
+    {
+        Loading,
+        Detection,
+        Improvement,
+        Refinement
+    };
 
 private:
     Ui::MainWindow *ui;
@@ -81,6 +103,19 @@ private:
     const int m_recentFilesLimit;
 
     Model *m_model;
+
+    // Engine work runs in its own thread
+    QThread m_workerThread;
+    RefinementWorker *m_worker;
+    QProgressBar *m_progressBar;
+    QAction *m_loadAction;
+    QAction *m_saveAction;
+    Job m_job;
+    QString m_loadingPath;
+    bool m_running;
+    bool m_loaded;
+    bool m_detected;
+    qulonglong m_rounds;
 };
 
 #endif // MAINWINDOW_H
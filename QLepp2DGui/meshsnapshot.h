@@ -0,0 +1,46 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MESHSNAPSHOT_H
+#define MESHSNAPSHOT_H
+
+#include <QMetaType>
+#include <QSharedPointer>
+
+#include <vector>
+
+#include <model.h>
+
+// Vertices and triangles that changed since the previous snapshot, copied
+// between two rounds, so they can be drawn while the worker keeps modifying
+// the Model. Only the changes are copied, so its cost follows the insertions.
+struct MeshSnapshot
+{
+    bool reset = false;                 // First chunk of a mesh being loaded
+    unsigned long firstVertex = 0;      // Vertices are only appended
+    std::vector<Vertex> vertices;       // Vertices from firstVertex onwards
+    unsigned long triangleCount = 0;    // Triangles of the mesh when it was taken
+    std::vector<int> indices;           // Sorted positions of the changed triangles
+    std::vector<Triangle> triangles;    // Changed triangles, in the same order
+    std::vector<unsigned char> flags;   // Bad flag of every triangle, or empty if they didn't change
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<const MeshSnapshot>)
+
+#endif // MESHSNAPSHOT_H
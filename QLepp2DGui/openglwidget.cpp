@@ -17,24 +17,71 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <openglwidget.h>
 
+// 3 indices per triangle
+static const int TRIANGLE_BYTES = 3 * static_cast<int>(sizeof(GLuint));
+static const int VERTEX_BYTES = static_cast<int>(sizeof(Vertex));
+
+// Flags per row of the texture (must match FLAGS_WIDTH in fragment.glsl)
+static const int FLAGS_WIDTH = 4096;
+
+// Changed triangles this close are uploaded together, as each upload has a cost
+static const int MERGE_GAP = 16;
+
+// Tiles whose triangles would cover less pixels than this are simplified
+static const float LOD_PIXELS = 4.0f;
+
+// Time without changes before the tiles are built again
+static const int TILE_DELAY = 1000;
+
 OpenGLWidget::OpenGLWidget(QWidget* parent)
   : QOpenGLWidget(parent),
+    m_ibo(QOpenGLBuffer::IndexBuffer),
+    m_lodIbo(QOpenGLBuffer::IndexBuffer),
+    m_flagsTexture(0),
+    m_lodTexture(0),
     m_program(nullptr),
+    m_goodColor(0.0f, 1.0f, 0.0f),      // Green
+    m_badColor(1.0f, 0.0f, 0.0f),       // Red
     m_xRot(0),
     m_yRot(0),
     m_zRot(0),
     m_xCamPos(0),
     m_yCamPos(0),
     m_zCamPos(-5),
-    m_dataAlreadyLoaded(false),
+    m_firstDirtyVertex(0),
+    m_flagsDirty(false),
+    m_triangleCount(0),
+    m_vertexCapacity(0),
+    m_triangleCapacity(0),
+    m_tileBuilder(new TileBuilder),
+    m_tiledCount(0),
+    m_generation(0),
+    m_building(false),
+    m_lodDirty(false),
     m_model(nullptr)
 {
+    // The tile builder lives in its own thread
+    qRegisterMetaType<QSharedPointer<const TileInput>>();
+    qRegisterMetaType<QSharedPointer<const TileSet>>();
+    m_tileBuilder->moveToThread(&m_tileThread);
+    connect(&m_tileThread, &QThread::finished, m_tileBuilder, &QObject::deleteLater);
+    connect(this, &OpenGLWidget::emitBuildTiles, m_tileBuilder, &TileBuilder::build);
+    connect(m_tileBuilder, &TileBuilder::built, this, &OpenGLWidget::tilesBuilt);
+    m_tileThread.start();
+
+    m_tileTimer.setSingleShot(true);
+    m_tileTimer.setInterval(TILE_DELAY);
+    connect(&m_tileTimer, &QTimer::timeout, this, &OpenGLWidget::rebuildTiles);
 }
 
 OpenGLWidget::~OpenGLWidget()
 {
+    m_tileThread.quit();
+    m_tileThread.wait();
     cleanup();
 }
 
@@ -42,6 +89,16 @@ void OpenGLWidget::cleanup()
 {
     makeCurrent();
     m_vbo.destroy();
+    m_ibo.destroy();
+    m_lodIbo.destroy();
+    if (m_flagsTexture != 0)
+    {
+        glDeleteTextures(1, &m_flagsTexture);
+    }
+    if (m_lodTexture != 0)
+    {
+        glDeleteTextures(1, &m_lodTexture);
+    }
     delete m_program;
     doneCurrent();
 }
@@ -51,16 +108,15 @@ void OpenGLWidget::setupVertexAttribs()
     m_vbo.bind();
     QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
     f->glEnableVertexAttribArray(0);                        // Vertex
-    f->glEnableVertexAttribArray(1);                        // Color
     // glVertexAttribPointer(GLuint index​, GLint size​, GLenum type​, GLboolean normalized​, GLsizei stride​, const GLvoid * pointer​);
-    // index = Vertex(0) or Color(1), can be more if needed
+    // index = Vertex(0), can be more if needed
     // size = Coordinates(x, y, z) => 3
     // type = GL_FLOAT, as that's the type of each coordinate
     // normalized = false, as there's no need to normalize here
-    // stride = 0, which implies that vertices are side-to-side (VVVCCC)
-    // pointer = where is the start of the data (in VVVCCC, 0 = start of vertices and 3 * GL_FLOAT * sizeof(vertexArray) = start of color)
+    // stride = 0, as the buffer is a plain copy of the vertices of the Model
+    // pointer = where is the start of the data (0 = first vertex)
+    // Colors aren't attributes: a vertex is shared by many triangles (see fragment.glsl)
     f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(3 * sizeof(Vertex) * m_model->getTriangles().size()));
     m_vbo.release();
 }
 
@@ -77,12 +133,17 @@ void OpenGLWidget::generateGLProgram()
     m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vertex.glsl");
     m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fragment.glsl");
     m_program->bindAttributeLocation("vertex", 0);
-    m_program->bindAttributeLocation("color", 1);
     m_program->link();
 
     m_program->bind();
     m_modelViewMatrixLoc = m_program->uniformLocation("modelViewMatrix");
     m_projMatrixLoc = m_program->uniformLocation("projMatrix");
+    m_flagsLoc = m_program->uniformLocation("flags");
+    m_lodSourcesLoc = m_program->uniformLocation("lodSources");
+    m_firstPrimitiveLoc = m_program->uniformLocation("firstPrimitive");
+    m_lodLoc = m_program->uniformLocation("lod");
+    m_goodColorLoc = m_program->uniformLocation("goodColor");
+    m_badColorLoc = m_program->uniformLocation("badColor");
 
     // Create a vertex array object. In OpenGL ES 2.0 and OpenGL 2.x
     // implementations this is optional and support may not be present
@@ -90,6 +151,25 @@ void OpenGLWidget::generateGLProgram()
     // sure there is a VAO when one is needed.
     m_vao.create();
 
+    // Our vertex and index buffer objects, allocated on the first upload
+    m_vbo.create();
+    m_vbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_ibo.create();
+    m_ibo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_lodIbo.create();
+    m_lodIbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+    // One byte per triangle, and one draw position per simplified triangle,
+    // fetched as they are (no filtering)
+    for (GLuint *texture : {&m_flagsTexture, &m_lodTexture})
+    {
+        glGenTextures(1, texture);
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
     // Our camera has an initial position.
     m_camera.setToIdentity();
     m_camera.translate(m_xCamPos, m_yCamPos, m_zCamPos);
@@ -97,52 +177,420 @@ void OpenGLWidget::generateGLProgram()
     m_program->release();
 }
 
+void OpenGLWidget::clearData()
+{
+    // The tiles of the previous mesh (even the ones being built) are useless
+    m_generation++;
+    m_building = false;
+    m_tileTimer.stop();
+    m_tiles.clear();
+    m_tiledCount = 0;
+    m_lodIndices.clear();
+    m_lodSources.clear();
+    m_rewritten.clear();
+    m_position.clear();
+    m_order.clear();
+    m_triangleCount = 0;
+    m_vertices.clear();
+
+    // A new mesh gets new buffers
+    m_vertexCapacity = 0;
+    m_triangleCapacity = 0;
+    m_firstDirtyVertex = 0;
+    m_flagsDirty = false;
+    m_dirty.clear();
+}
+
 void OpenGLWidget::loadData()
 {
-    // Setup our vertex buffer object.
-    m_vbo.create();
-    m_vbo.bind();
+    MeshVector<Vertex> &vertices(m_model->getVertices());
+    MeshVector<Triangle> &triangles(m_model->getTriangles());
+
+    clearData();
+    m_vertices.resize(static_cast<int>(vertices.size()));
+    std::copy(vertices.begin(), vertices.end(), m_vertices.begin());
+    resizeTriangles(static_cast<int>(triangles.size()));
+    for (int i(0); i < m_triangleCount; i++)
+    {
+        writeTriangle(i, triangles.at(static_cast<unsigned long>(i)));
+    }
+    m_dirty.append(qMakePair(0, m_triangleCount));
 
-    // Create data vector.
-    QVector<GLfloat> vertexData;
+    // Until they're built, every triangle is drawn
+    requestTiles();
+}
+
+void OpenGLWidget::resizeTriangles(int count)
+{
+    // New triangles are drawn after the tiles, in their own order
+    for (int i(m_triangleCount); i < count; i++)
+    {
+        m_position.append(i);
+        m_order.append(i);
+    }
+    m_triangleCount = count;
+    m_indices.resize(3 * count);
+    // Flags are kept in whole rows
+    m_flags.resize((count + FLAGS_WIDTH - 1) / FLAGS_WIDTH * FLAGS_WIDTH);
+}
+
+void OpenGLWidget::writeTriangle(int index, const Triangle &t)
+{
+    int position(m_position.at(index));
+    GLuint *indices(m_indices.data() + 3 * position);
+    indices[0] = static_cast<GLuint>(t.iv1);
+    indices[1] = static_cast<GLuint>(t.iv2);
+    indices[2] = static_cast<GLuint>(t.iv3);
+    m_flags[position] = (t.bad != 0) ? 255 : 0;
+    touchTile(position);
+}
+
+void OpenGLWidget::markDirty(const std::vector<int> &indices)
+{
+    std::vector<int> positions;
+    positions.reserve(indices.size());
+    for (int index : indices)
+    {
+        positions.push_back(m_position.at(index));
+    }
+    std::sort(positions.begin(), positions.end());
+
+    // Sorted, so close ones are merged into the same range
+    for (int index : positions)
+    {
+        if (not m_dirty.isEmpty() and index >= m_dirty.last().first and index <= m_dirty.last().second + MERGE_GAP)
+        {
+            m_dirty.last().second = std::max(m_dirty.last().second, index + 1);
+        }
+        else
+        {
+            m_dirty.append(qMakePair(index, index + 1));
+        }
+    }
+}
 
-    // Load vertices
-    std::vector<Vertex> &vertices(m_model->getVertices());
-    std::vector<Triangle> &triangles(m_model->getTriangles());
+void OpenGLWidget::uploadData()
+{
+    // Spare room, so the next insertions don't reallocate the buffers
+    auto grow = [](int count) { return count + count / 2; };
 
-    for (Triangle &t : triangles)
+    if (m_firstDirtyVertex < m_vertices.size())
     {
-        unsigned long t_iv1(static_cast<unsigned long>(t.iv1));
-        unsigned long t_iv2(static_cast<unsigned long>(t.iv2));
-        unsigned long t_iv3(static_cast<unsigned long>(t.iv3));
+        m_vbo.bind();
+        if (m_vertices.size() > m_vertexCapacity)
+        {
+            m_vertexCapacity = grow(m_vertices.size());
+            m_vbo.allocate(m_vertexCapacity * VERTEX_BYTES);
+            m_firstDirtyVertex = 0;
+        }
+        m_vbo.write(m_firstDirtyVertex * VERTEX_BYTES,
+                    m_vertices.constData() + m_firstDirtyVertex,
+                    (m_vertices.size() - m_firstDirtyVertex) * VERTEX_BYTES);
+        m_vbo.release();
+        m_firstDirtyVertex = m_vertices.size();
 
-        vertexData.append(vertices.at(t_iv1).x);
-        vertexData.append(vertices.at(t_iv1).y);
-        vertexData.append(vertices.at(t_iv1).z);
+        // Store the vertex attribute bindings for the program.
+        setupVertexAttribs();
+    }
 
-        vertexData.append(vertices.at(t_iv2).x);
-        vertexData.append(vertices.at(t_iv2).y);
-        vertexData.append(vertices.at(t_iv2).z);
+    if (m_lodDirty)
+    {
+        m_lodIbo.bind();
+        m_lodIbo.allocate(m_lodIndices.constData(), m_lodIndices.size() * static_cast<int>(sizeof(GLuint)));
+        glBindTexture(GL_TEXTURE_2D, m_lodTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, FLAGS_WIDTH, m_lodSources.size() / FLAGS_WIDTH, 0,
+                     GL_RED_INTEGER, GL_INT, m_lodSources.constData());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_lodDirty = false;
+    }
 
-        vertexData.append(vertices.at(t_iv3).x);
-        vertexData.append(vertices.at(t_iv3).y);
-        vertexData.append(vertices.at(t_iv3).z);
+    if (m_dirty.isEmpty() and not m_flagsDirty)
+    {
+        return;
     }
 
-    // Generate color
-    for (Triangle &t : triangles)
+    // The index buffer stays bound, as it's part of the state of the VAO
+    m_ibo.bind();
+    if (m_triangleCount > m_triangleCapacity)
     {
-        for (int i(1); i <= 3; i++)
+        m_triangleCapacity = grow(m_triangleCount);
+        m_ibo.allocate(m_triangleCapacity * TRIANGLE_BYTES);
+        m_ibo.write(0, m_indices.constData(), m_triangleCount * TRIANGLE_BYTES);
+
+        int rows((m_triangleCapacity + FLAGS_WIDTH - 1) / FLAGS_WIDTH);
+        glBindTexture(GL_TEXTURE_2D, m_flagsTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, FLAGS_WIDTH, rows, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        uploadFlags(0, m_flags.size() / FLAGS_WIDTH);
+    }
+    else
+    {
+        // Only the changed triangles are written (glBufferSubData)
+        for (const QPair<int, int> &range : m_dirty)
         {
-            vertexData.append( t.bad * 0.3f * i);
-            vertexData.append(!t.bad * 0.3f * i);
-            vertexData.append(0.0);
+            if (range.first >= range.second)
+            {
+                continue;
+            }
+            m_ibo.write(range.first * TRIANGLE_BYTES,
+                        m_indices.constData() + 3 * range.first,
+                        (range.second - range.first) * TRIANGLE_BYTES);
+            if (not m_flagsDirty)
+            {
+                uploadFlags(range.first / FLAGS_WIDTH, (range.second - 1) / FLAGS_WIDTH + 1);
+            }
+        }
+
+        // A new detection only costs one byte per triangle
+        if (m_flagsDirty)
+        {
+            uploadFlags(0, m_flags.size() / FLAGS_WIDTH);
         }
     }
+    m_dirty.clear();
+    m_flagsDirty = false;
+}
 
-    // Allocate data into VBO
-    m_vbo.allocate(vertexData.constData(),
-                   static_cast<int>(vertexData.count()) * static_cast<int>(sizeof(GLfloat)));
+void OpenGLWidget::uploadFlags(int firstRow, int lastRow)
+{
+    if (firstRow >= lastRow)
+    {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_flagsTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, FLAGS_WIDTH, lastRow - firstRow,
+                    GL_RED, GL_UNSIGNED_BYTE, m_flags.constData() + firstRow * FLAGS_WIDTH);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void OpenGLWidget::touchTile(int position)
+{
+    // Written again when the tiles being built arrive
+    if (m_building)
+    {
+        m_rewritten.append(position);
+    }
+    if (position >= m_tiledCount)
+    {
+        return;
+    }
+
+    // The triangle may reach out of its tile, and its simplified levels are outdated
+    auto next = std::upper_bound(m_tiles.begin(), m_tiles.end(), position,
+                                 [](int p, const MeshTile &tile) { return p < tile.first; });
+    MeshTile &tile(*(next - 1));
+    for (int k(0); k < 3; k++)
+    {
+        const Vertex &v(m_vertices.at(static_cast<int>(m_indices.at(3 * position + k))));
+        tile.min[0] = std::min(tile.min[0], v.x);
+        tile.min[1] = std::min(tile.min[1], v.y);
+        tile.min[2] = std::min(tile.min[2], v.z);
+        tile.max[0] = std::max(tile.max[0], v.x);
+        tile.max[1] = std::max(tile.max[1], v.y);
+        tile.max[2] = std::max(tile.max[2], v.z);
+    }
+    tile.lodStale = true;
+}
+
+void OpenGLWidget::requestTiles()
+{
+    if (m_building or m_triangleCount == 0)
+    {
+        return;
+    }
+
+    // Shared copies, which only get detached if the mesh changes meanwhile
+    QSharedPointer<TileInput> input(new TileInput);
+    input->generation = m_generation;
+    input->vertices = m_vertices;
+    input->indices = m_indices;
+    m_building = true;
+    m_rewritten.clear();
+    emit emitBuildTiles(input);
+}
+
+void OpenGLWidget::rebuildTiles()
+{
+    if (m_building)
+    {
+        m_tileTimer.start();
+        return;
+    }
+    bool stale(m_tiledCount < m_triangleCount);
+    for (const MeshTile &tile : m_tiles)
+    {
+        stale = stale or tile.lodStale;
+    }
+    if (stale)
+    {
+        requestTiles();
+    }
+}
+
+void OpenGLWidget::tilesBuilt(QSharedPointer<const TileSet> tiles)
+{
+    // Tiles of a previous mesh
+    if (tiles->generation != m_generation)
+    {
+        return;
+    }
+    m_building = false;
+
+    // Triangles of the input are moved to their tiles, and the newer ones stay after them
+    int count(tiles->triangleCount);
+    QVector<GLuint> indices(m_indices);
+    QVector<GLubyte> flags(m_flags);
+    QVector<int> order(m_order);
+    QVector<int> position(count);
+    for (int p(0); p < count; p++)
+    {
+        int old(tiles->order.at(p));
+        std::copy(indices.constData() + 3 * old, indices.constData() + 3 * old + 3, m_indices.data() + 3 * p);
+        m_flags[p] = flags.at(old);
+        m_order[p] = order.at(old);
+        m_position[order.at(old)] = p;
+        position[old] = p;
+    }
+    m_tiles = tiles->tiles;
+    m_tiledCount = count;
+
+    m_lodIndices = tiles->lodIndices;
+    m_lodSources.resize((tiles->lodSources.size() / FLAGS_WIDTH + 1) * FLAGS_WIDTH);
+    for (int i(0); i < tiles->lodSources.size(); i++)
+    {
+        m_lodSources[i] = position.at(tiles->lodSources.at(i));
+    }
+    m_lodDirty = true;
+
+    // Triangles written while the tiles were built
+    QVector<int> rewritten;
+    rewritten.swap(m_rewritten);
+    for (int old : rewritten)
+    {
+        touchTile(old < count ? position.at(old) : old);
+    }
+
+    m_dirty.clear();
+    m_dirty.append(qMakePair(0, m_triangleCount));
+    m_flagsDirty = true;
+    update();
+}
+
+void OpenGLWidget::drawTiles()
+{
+    QMatrix4x4 mvp(m_proj * m_camera * m_world);
+    float pixels(static_cast<float>(width()) * static_cast<float>(height()));
+
+    // Consecutive tiles with the same level are drawn together
+    int level(0);
+    int first(0);
+    int count(0);
+    auto draw = [&](int tileLevel, int tileFirst, int tileCount) {
+        if (tileLevel != level or tileFirst != first + count)
+        {
+            drawRange(level, first, count);
+            level = tileLevel;
+            first = tileFirst;
+            count = 0;
+        }
+        count += tileCount;
+    };
+
+    for (const MeshTile &tile : m_tiles)
+    {
+        // Corners of the bounding box in clip space
+        QVector4D corners[8];
+        for (int k(0); k < 8; k++)
+        {
+            corners[k] = mvp * QVector4D((k & 1) ? tile.max[0] : tile.min[0],
+                                         (k & 2) ? tile.max[1] : tile.min[1],
+                                         (k & 4) ? tile.max[2] : tile.min[2],
+                                         1.0f);
+        }
+
+        // Frustum culling: every corner out of the same plane
+        bool culled(false);
+        for (int plane(0); plane < 6 and not culled; plane++)
+        {
+            int axis(plane / 2);
+            float side(plane % 2 == 0 ? -1.0f : 1.0f);
+            culled = true;
+            for (const QVector4D &c : corners)
+            {
+                float coordinate(axis == 0 ? c.x() : axis == 1 ? c.y() : c.z());
+                culled = culled and side * coordinate > c.w();
+            }
+        }
+        if (culled)
+        {
+            continue;
+        }
+
+        // Covered pixels, from the projected box (the whole view if it's behind the camera)
+        float area(pixels);
+        float minX(1.0f), minY(1.0f), maxX(-1.0f), maxY(-1.0f);
+        bool inFront(true);
+        for (const QVector4D &c : corners)
+        {
+            inFront = inFront and c.w() > 0.0f;
+            if (inFront)
+            {
+                minX = std::min(minX, c.x() / c.w());
+                minY = std::min(minY, c.y() / c.w());
+                maxX = std::max(maxX, c.x() / c.w());
+                maxY = std::max(maxY, c.y() / c.w());
+            }
+        }
+        if (inFront)
+        {
+            area = (std::min(maxX, 1.0f) - std::max(minX, -1.0f)) * (std::min(maxY, 1.0f) - std::max(minY, -1.0f)) * pixels / 4.0f;
+        }
+
+        // The finest level whose triangles aren't too small, as long as it's up to date
+        int tileLevel(0);
+        if (not tile.lodStale)
+        {
+            while (tileLevel < LOD_LEVELS and tile.lodCount[tileLevel] > 0
+                   and area < LOD_PIXELS * (tileLevel == 0 ? tile.count : tile.lodCount[tileLevel - 1]))
+            {
+                tileLevel++;
+            }
+        }
+        if (tileLevel == 0)
+        {
+            draw(0, tile.first, tile.count);
+        }
+        else
+        {
+            draw(tileLevel, tile.lodFirst[tileLevel - 1], tile.lodCount[tileLevel - 1]);
+        }
+    }
+
+    // Triangles added after the tiles were built
+    draw(0, m_tiledCount, m_triangleCount - m_tiledCount);
+    drawRange(level, first, count);
+}
+
+void OpenGLWidget::drawRange(int level, int first, int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // gl_PrimitiveID restarts in each draw, so the shader gets the first one
+    m_program->setUniformValue(m_lodLoc, level > 0 ? 1 : 0);
+    m_program->setUniformValue(m_firstPrimitiveLoc, first);
+    if (level > 0)
+    {
+        m_lodIbo.bind();
+    }
+    else
+    {
+        m_ibo.bind();
+    }
+    glDrawElements(GL_TRIANGLES, 3 * count, GL_UNSIGNED_INT, reinterpret_cast<void *>(static_cast<quintptr>(first) * TRIANGLE_BYTES));
 }
 
 void OpenGLWidget::paintGL()
@@ -167,21 +615,28 @@ void OpenGLWidget::paintGL()
     m_program->setUniformValue(m_projMatrixLoc, m_proj);
     m_program->setUniformValue(m_modelViewMatrixLoc, m_camera * m_world);
 
-    // Load new data only on model data change
-    if (not m_dataAlreadyLoaded)
-    {
-        // Load data
-        loadData();
+    // Upload only what has changed since the last frame
+    uploadData();
 
-        // Store the vertex attribute bindings for the program.
-        setupVertexAttribs();
+    // Flags of the triangles
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_flagsTexture);
+    m_program->setUniformValue(m_flagsLoc, 0);
 
-        m_dataAlreadyLoaded = true;
-    }
+    // Colors are uniforms, so changing them doesn't upload anything else
+    m_program->setUniformValue(m_goodColorLoc, m_goodColor);
+    m_program->setUniformValue(m_badColorLoc, m_badColor);
+
+    // Draw positions of the simplified triangles
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_lodTexture);
+    m_program->setUniformValue(m_lodSourcesLoc, 1);
 
     // Draw triangulation
-    // Last argument = Number of vertices in total
-    glDrawArrays(GL_TRIANGLES, 0, 3 * static_cast<int>(m_model->getTriangles().size()));
+    drawTiles();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
     m_program->release();
 }
@@ -199,7 +654,44 @@ void OpenGLWidget::updateModel(Model *model)
 
 void OpenGLWidget::updateData()
 {
-    m_dataAlreadyLoaded = false;
+    // The whole mesh is copied now, while nobody is modifying the Model
+    loadData();
+    update();
+}
+
+void OpenGLWidget::updateSnapshot(QSharedPointer<const MeshSnapshot> snapshot)
+{
+    // The first chunk of a load replaces the mesh
+    if (snapshot->reset)
+    {
+        clearData();
+    }
+
+    // Vertices and triangles only grow between loads
+    int firstVertex(static_cast<int>(snapshot->firstVertex));
+    m_vertices.resize(firstVertex + static_cast<int>(snapshot->vertices.size()));
+    std::copy(snapshot->vertices.begin(), snapshot->vertices.end(), m_vertices.begin() + firstVertex);
+    m_firstDirtyVertex = std::min(m_firstDirtyVertex, firstVertex);
+
+    resizeTriangles(static_cast<int>(snapshot->triangleCount));
+    for (unsigned long i(0); i < snapshot->indices.size(); i++)
+    {
+        writeTriangle(snapshot->indices.at(i), snapshot->triangles.at(i));
+    }
+    markDirty(snapshot->indices);
+
+    // Flags of every triangle (after a detection), without geometry
+    if (not snapshot->flags.empty())
+    {
+        for (unsigned long i(0); i < snapshot->flags.size(); i++)
+        {
+            m_flags[m_position.at(static_cast<int>(i))] = (snapshot->flags.at(i) != 0) ? 255 : 0;
+        }
+        m_flagsDirty = true;
+    }
+
+    // Tiles are built again once the work ends
+    m_tileTimer.start();
     update();
 }
 
@@ -257,6 +749,14 @@ static void qNormalizeAngle(int &angle)
         angle -= 360 * 16;
 }
 
+void OpenGLWidget::setColorblindPalette(bool enabled)
+{
+    // Blue and orange can be told apart with any color vision deficiency
+    m_goodColor = enabled ? QVector3D(0.0f, 0.45f, 0.7f) : QVector3D(0.0f, 1.0f, 0.0f);
+    m_badColor = enabled ? QVector3D(0.9f, 0.6f, 0.0f) : QVector3D(1.0f, 0.0f, 0.0f);
+    update();
+}
+
 void OpenGLWidget::setXRotation(int angle)
 {
     qNormalizeAngle(angle);
@@ -28,8 +28,17 @@
 #include <QOpenGLWidget>
 #include <QMouseEvent>
 #include <QStringRef>
+#include <QPair>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QVector3D>
 
+#include <vector>
+
+#include <meshsnapshot.h>
 #include <model.h>
+#include <tilebuilder.h>
 
 class OpenGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
 {
@@ -42,13 +51,22 @@ public:
 public slots:
     void updateModel(Model *model);
     void updateData();
+    void updateSnapshot(QSharedPointer<const MeshSnapshot> snapshot);
     void resetView();
+    void setColorblindPalette(bool enabled);
     void setXRotation(int angle);
     void setYRotation(int angle);
     void setZRotation(int angle);
     void setXMovement(float position);
     void setYMovement(float position);
 
+signals:
+    void emitBuildTiles(QSharedPointer<const TileInput> input);
+
+private slots:
+    void rebuildTiles();
+    void tilesBuilt(QSharedPointer<const TileSet> tiles);
+
 protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
@@ -60,14 +78,36 @@ protected:
 private:
     void setupVertexAttribs();
     void generateGLProgram();
+    void clearData();
     void loadData();
+    void resizeTriangles(int count);
+    void writeTriangle(int index, const Triangle &t);
+    void markDirty(const std::vector<int> &indices);
+    void uploadData();
+    void uploadFlags(int firstRow, int lastRow);
+    void touchTile(int position);
+    void requestTiles();
+    void drawTiles();
+    void drawRange(int level, int first, int count);
     void cleanup();
 
     QOpenGLVertexArrayObject m_vao;
-    QOpenGLBuffer m_vbo;
+    QOpenGLBuffer m_vbo;                // Positions, shared by the triangles of each vertex
+    QOpenGLBuffer m_ibo;                // Vertices 1, 2 and 3 of each triangle
+    QOpenGLBuffer m_lodIbo;             // Simplified triangles of the tiles
+    GLuint m_flagsTexture;              // Bad flag of each triangle, read by gl_PrimitiveID
+    GLuint m_lodTexture;                // Draw position whose flag colors each simplified triangle
     QOpenGLShaderProgram *m_program;
     int m_modelViewMatrixLoc;
     int m_projMatrixLoc;
+    int m_flagsLoc;
+    int m_lodSourcesLoc;
+    int m_firstPrimitiveLoc;
+    int m_lodLoc;
+    int m_goodColorLoc;
+    int m_badColorLoc;
+    QVector3D m_goodColor;
+    QVector3D m_badColor;
 
     QMatrix4x4 m_proj;
     QMatrix4x4 m_camera;
@@ -82,7 +122,33 @@ private:
     float m_yCamPos;
     float m_zCamPos;
 
-    bool m_dataAlreadyLoaded;
+    // Copies of the buffers, so only what changed has to be uploaded.
+    // Triangles are kept in draw order: tile after tile, and then the ones
+    // that were added after the tiles were built.
+    QVector<Vertex> m_vertices;
+    QVector<GLuint> m_indices;
+    QVector<GLubyte> m_flags;           // Whole rows of the texture
+    QVector<int> m_position;            // Draw position of each triangle
+    QVector<int> m_order;               // Triangle at each draw position
+    int m_firstDirtyVertex;             // Vertices are only appended
+    bool m_flagsDirty;                  // Every flag must be uploaded
+    QVector<QPair<int, int>> m_dirty;   // Ranges [first, last) of triangles
+    int m_triangleCount;
+    int m_vertexCapacity;               // Vertices that fit in the VBO
+    int m_triangleCapacity;             // Triangles that fit in the IBO and the texture
+
+    // Tiles, built by another thread
+    QThread m_tileThread;
+    TileBuilder *m_tileBuilder;
+    QTimer m_tileTimer;                 // Rebuilds them once the mesh stops changing
+    QVector<MeshTile> m_tiles;
+    QVector<GLuint> m_lodIndices;
+    QVector<GLint> m_lodSources;        // Whole rows of the texture
+    QVector<int> m_rewritten;           // Draw positions written while the tiles are built
+    int m_tiledCount;                   // Triangles in the tiles
+    int m_generation;                   // Meshes loaded so far
+    bool m_building;
+    bool m_lodDirty;                    // The LOD buffers must be uploaded
 
     Model *m_model;
 };
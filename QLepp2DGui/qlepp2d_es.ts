@@ -954,6 +954,16 @@ p, li { white-space: pre-wrap; }
         <source>Ctrl+R</source>
         <translation>Ctrl+R</translation>
     </message>
+    <message>
+        <location filename="mainwindow.ui" line="323"/>
+        <source>&amp;Colorblind-safe Colors</source>
+        <translation>&amp;Colores Aptos para Daltónicos</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.ui" line="326"/>
+        <source>Shows good triangles in blue and bad triangles in orange.</source>
+        <translation>Muestra los triángulos buenos en azul y los malos en naranjo.</translation>
+    </message>
     <message>
         <location filename="mainwindow.ui" line="297"/>
         <source>Use &amp;CPU Engine</source>
@@ -1033,6 +1043,11 @@ p, li { white-space: pre-wrap; }
         <source>Unable to load.</source>
         <translation>No se puede cargar.</translation>
     </message>
+    <message>
+        <location filename="mainwindow.cpp" line="172"/>
+        <source>Loading cancelled. The previous triangulation has been kept.</source>
+        <translation>Carga cancelada. Se ha conservado la triangulación anterior.</translation>
+    </message>
     <message>
         <location filename="mainwindow.cpp" line="149"/>
         <location filename="mainwindow.cpp" line="167"/>
@@ -1114,6 +1129,91 @@ p, li { white-space: pre-wrap; }
         <source>Unable to set OpenCL engine.</source>
         <translation>No se puede cargar el motor de OpenCL.</translation>
     </message>
+    <message>
+        <location filename="mainwindow.ui" line="105"/>
+        <source>Improves the triangulation round after round, until no centroid can be inserted.</source>
+        <translation>Mejora la triangulación ronda tras ronda, hasta que no se pueda insertar ningún centroide.</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.ui" line="111"/>
+        <source>Refine until done</source>
+        <translation>Refinar hasta terminar</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.ui" line="121"/>
+        <source>Stops the running detection or improvement, keeping a consistent triangulation.</source>
+        <translation>Detiene la detección o mejora en curso, manteniendo una triangulación consistente.</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.ui" line="127"/>
+        <source>Cancel</source>
+        <translation>Cancelar</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="240"/>
+        <source>Detecting bad triangles...</source>
+        <translation>Detectando triángulos malos...</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="249"/>
+        <source>Improving triangulation...</source>
+        <translation>Mejorando la triangulación...</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="259"/>
+        <source>Refining triangulation...</source>
+        <translation>Refinando la triangulación...</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="269"/>
+        <source>Cancelling...</source>
+        <translation>Cancelando...</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="277"/>
+        <source>Detecting bad triangles</source>
+        <translation>Detectando triángulos malos</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="281"/>
+        <source>Detecting terminal edges</source>
+        <translation>Detectando aristas terminales</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="285"/>
+        <source>Inserting centroids</source>
+        <translation>Insertando centroides</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="308"/>
+        <source>Reading vertices</source>
+        <translation>Leyendo vértices</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="312"/>
+        <source>Reading triangles</source>
+        <translation>Leyendo triángulos</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="316"/>
+        <source>Building edges</source>
+        <translation>Construyendo aristas</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="294"/>
+        <source>Round %1: %2 centroids inserted.</source>
+        <translation>Ronda %1: %2 centroides insertados.</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="304"/>
+        <source>Cancelled. The triangulation has been left consistent.</source>
+        <translation>Cancelado. La triangulación ha quedado consistente.</translation>
+    </message>
+    <message>
+        <location filename="mainwindow.cpp" line="333"/>
+        <source>Triangulation has been refined in %1 rounds.</source>
+        <translation>La triangulación ha sido refinada en %1 rondas.</translation>
+    </message>
 </context>
 <context>
     <name>Tutorial</name>
@@ -0,0 +1,246 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include <algorithm>
+
+#include <refinementworker.h>
+
+RefinementWorker::RefinementWorker(Model *model, QObject *parent) :
+    QObject(parent),
+    m_model(model),
+    m_refreshInterval(100),  // At most 10 updates per second
+    m_firstNewVertex(0),
+    m_firstNewTriangle(0),
+    m_allFlags(false),
+    m_staleFlags(false),
+    m_loadedVertices(0),
+    m_loadedTriangles(0),
+    m_loadTotal(0)
+{
+}
+
+void RefinementWorker::cancel()
+{
+    m_token.cancel();
+}
+
+void RefinementWorker::reset()
+{
+    m_token.reset();
+}
+
+void RefinementWorker::load(QString filepath)
+{
+    qDebug() << "RefinementWorker::load";
+    m_lastProgress.start();
+    m_lastSnapshot.invalidate();
+    m_loadedVertices = 0;
+    m_loadedTriangles = 0;
+    m_loadTotal = 0;
+
+    // Both callbacks are called by the loading thread, one after the other
+    bool ok = m_model->loadFileAsync(filepath.toStdString(),
+                                     [this](const Progress &p) {
+                                         if (p.phase == "LOAD_T")
+                                         {
+                                             m_loadTotal = p.total;
+                                         }
+                                         reportProgress(p);
+                                     },
+                                     m_token,
+                                     [this](const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles) {
+                                         publishChunk(vertices, triangles);
+                                     }).get();
+
+    // The view loads the whole Model again (the new mesh, or the previous one)
+    m_staleFlags = false;
+    emit finished(ok, m_token.isCancelled());
+}
+
+void RefinementWorker::detect(double angle)
+{
+    qDebug() << "RefinementWorker::detect";
+    m_lastProgress.start();
+    bool ok = m_model->detectBadTrianglesAsync(static_cast<float>(angle),
+                                               [this](const Progress &p) { reportProgress(p); },
+                                               m_token).get();
+    m_staleFlags = m_token.isCancelled();
+
+    // Any triangle may change its color, but the geometry stays the same
+    beginChanges(true);
+    publishSnapshot();
+    emit finished(ok, m_token.isCancelled());
+}
+
+void RefinementWorker::improve()
+{
+    qDebug() << "RefinementWorker::improve";
+    m_lastProgress.start();
+    beginChanges(m_staleFlags);
+    bool ok = m_model->improveTriangulationAsync([this](const Progress &p) { reportProgress(p); },
+                                                 m_token).get();
+    m_staleFlags = m_token.isCancelled();
+    addChanges(m_model->getChanges());
+    publishSnapshot();
+    if (ok)
+    {
+        emit roundFinished(1, m_model->getInsertionCount());
+    }
+    emit finished(ok, m_token.isCancelled());
+}
+
+void RefinementWorker::refineUntilDone()
+{
+    qDebug() << "RefinementWorker::refineUntilDone";
+    m_lastProgress.start();
+    m_lastSnapshot.start();
+    beginChanges(m_staleFlags);
+    bool ok(true);
+    qulonglong round(0);
+    while (not m_token.isCancelled())
+    {
+        ok = m_model->improveTriangulationAsync([this](const Progress &p) { reportProgress(p); },
+                                                m_token).get();
+        addChanges(m_model->getChanges());
+        if (not ok)
+        {
+            break;
+        }
+        round++;
+        emit roundFinished(round, m_model->getInsertionCount());
+
+        // No centroid could be inserted, so there's nothing left to improve
+        if (m_model->getInsertionCount() == 0)
+        {
+            break;
+        }
+
+        // Rounds can be very short on small meshes, so they're not drawn each time
+        if (m_lastSnapshot.elapsed() >= m_refreshInterval)
+        {
+            publishSnapshot();
+            m_lastSnapshot.restart();
+        }
+    }
+    m_staleFlags = m_token.isCancelled();
+    publishSnapshot();
+    emit finished(ok, m_token.isCancelled());
+}
+
+void RefinementWorker::publishChunk(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles)
+{
+    // Chunks are parsed faster than they can be drawn, but the last one is always shown
+    bool last(triangles.size() == m_loadTotal);
+    if (not last and m_lastSnapshot.isValid() and m_lastSnapshot.elapsed() < m_refreshInterval)
+    {
+        return;
+    }
+    m_lastSnapshot.start();
+
+    // Only the vertices and triangles parsed since the previous chunk
+    QSharedPointer<MeshSnapshot> snapshot(new MeshSnapshot);
+    snapshot->reset = (m_loadedVertices == 0 and m_loadedTriangles == 0);
+    snapshot->firstVertex = m_loadedVertices;
+    snapshot->vertices.assign(vertices.begin() + static_cast<long>(m_loadedVertices), vertices.end());
+    snapshot->triangleCount = triangles.size();
+    snapshot->indices.reserve(triangles.size() - m_loadedTriangles);
+    snapshot->triangles.assign(triangles.begin() + static_cast<long>(m_loadedTriangles), triangles.end());
+    for (unsigned long i(m_loadedTriangles); i < triangles.size(); i++)
+    {
+        snapshot->indices.push_back(static_cast<int>(i));
+    }
+    m_loadedVertices = vertices.size();
+    m_loadedTriangles = triangles.size();
+    emit snapshotReady(snapshot);
+}
+
+void RefinementWorker::reportProgress(const Progress &current)
+{
+    // Engines report every chunk, which is much more than the window can show
+    if (m_lastProgress.elapsed() < m_refreshInterval and current.processed < current.total)
+    {
+        return;
+    }
+    m_lastProgress.restart();
+    emit progress(QString::fromStdString(current.phase), current.processed, current.total);
+}
+
+void RefinementWorker::beginChanges(bool allFlags)
+{
+    /* After a cancelled work, the Model detects the stale flags again before
+     * improving, so any triangle may change its color.
+     */
+    m_changedTriangles.clear();
+    m_firstNewVertex = m_model->getVertices().size();
+    m_firstNewTriangle = m_model->getTriangles().size();
+    m_allFlags = allFlags;
+}
+
+void RefinementWorker::addChanges(const ChangeSet &changes)
+{
+    // Positions that were new in an earlier round are already covered
+    for (int itriangle : changes.triangles)
+    {
+        if (static_cast<unsigned long>(itriangle) < m_firstNewTriangle)
+        {
+            m_changedTriangles.push_back(itriangle);
+        }
+    }
+    m_firstNewVertex = std::min(m_firstNewVertex, changes.firstVertex);
+    m_firstNewTriangle = std::min(m_firstNewTriangle, changes.firstTriangle);
+}
+
+void RefinementWorker::publishSnapshot()
+{
+    // The Model isn't being modified between rounds, so these are consistent copies
+    MeshVector<Vertex> &vertices(m_model->getVertices());
+    MeshVector<Triangle> &triangles(m_model->getTriangles());
+
+    std::sort(m_changedTriangles.begin(), m_changedTriangles.end());
+    m_changedTriangles.erase(std::unique(m_changedTriangles.begin(), m_changedTriangles.end()),
+                             m_changedTriangles.end());
+    for (unsigned long i(m_firstNewTriangle); i < triangles.size(); i++)
+    {
+        m_changedTriangles.push_back(static_cast<int>(i));
+    }
+
+    QSharedPointer<MeshSnapshot> snapshot(new MeshSnapshot);
+    snapshot->firstVertex = m_firstNewVertex;
+    snapshot->vertices.assign(vertices.begin() + static_cast<long>(m_firstNewVertex), vertices.end());
+    snapshot->triangleCount = triangles.size();
+    snapshot->indices.swap(m_changedTriangles);
+    snapshot->triangles.reserve(snapshot->indices.size());
+    for (int itriangle : snapshot->indices)
+    {
+        snapshot->triangles.push_back(triangles.at(static_cast<unsigned long>(itriangle)));
+    }
+    if (m_allFlags)
+    {
+        snapshot->flags.reserve(triangles.size());
+        for (const Triangle &t : triangles)
+        {
+            snapshot->flags.push_back(t.bad != 0 ? 1 : 0);
+        }
+    }
+    emit snapshotReady(snapshot);
+
+    beginChanges(false);
+}
@@ -0,0 +1,84 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REFINEMENTWORKER_H
+#define REFINEMENTWORKER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+#include <vector>
+
+#include <meshsnapshot.h>
+#include <model.h>
+
+// Runs the loads and the engine work of the Model in its own thread, so the
+// window keeps responding. While it runs, nobody else may touch the Model.
+class RefinementWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RefinementWorker(Model *model, QObject *parent = nullptr);
+
+    // Both are thread-safe, as the thread of the worker is busy while it runs
+    void cancel();
+    void reset();
+
+public slots:
+    void load(QString filepath);
+    void detect(double angle);
+    void improve();
+    void refineUntilDone();
+
+signals:
+    void progress(QString phase, qulonglong processed, qulonglong total);
+    void roundFinished(qulonglong round, qulonglong insertions);
+    void snapshotReady(QSharedPointer<const MeshSnapshot> snapshot);
+    void finished(bool ok, bool cancelled);
+
+private:
+    void reportProgress(const Progress &current);
+    void beginChanges(bool allFlags);
+    void addChanges(const ChangeSet &changes);
+    void publishSnapshot();
+    void publishChunk(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles);
+
+    Model *m_model;
+    CancellationToken m_token;
+    QElapsedTimer m_lastProgress;
+    QElapsedTimer m_lastSnapshot;
+    const qint64 m_refreshInterval;
+
+    // Triangles that changed since the last snapshot
+    std::vector<int> m_changedTriangles;
+    unsigned long m_firstNewVertex;
+    unsigned long m_firstNewTriangle;
+    bool m_allFlags;                    // Every flag may have changed
+    bool m_staleFlags;                  // The last work was cancelled
+
+    // Parts of the mesh being loaded that were already sent
+    unsigned long m_loadedVertices;
+    unsigned long m_loadedTriangles;
+    unsigned long m_loadTotal;          // Triangles in the file
+};
+
+#endif // REFINEMENTWORKER_H
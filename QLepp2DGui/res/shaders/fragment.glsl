@@ -1,7 +1,34 @@
-#version 120
+#version 330 core
 
-varying highp vec3 f_color;
+// Flags per row (must match FLAGS_WIDTH in openglwidget.cpp)
+const int FLAGS_WIDTH = 4096;
+
+// Bad flag of each triangle (0 or 1), in draw order
+uniform sampler2D flags;
+
+// Draw position of the triangle that colors each simplified triangle
+uniform isampler2D lodSources;
+
+// gl_PrimitiveID restarts in each draw
+uniform int firstPrimitive;
+uniform bool lod;
+
+// Palette
+uniform vec3 goodColor;
+uniform vec3 badColor;
+
+out vec4 fragColor;
 
 void main() {
-    gl_FragColor = vec4(f_color, 0.0);
+    int id = firstPrimitive + gl_PrimitiveID;
+    if (lod) {
+        id = texelFetch(lodSources, ivec2(id % FLAGS_WIDTH, id / FLAGS_WIDTH), 0).r;
+    }
+    float bad = texelFetch(flags, ivec2(id % FLAGS_WIDTH, id / FLAGS_WIDTH), 0).r;
+
+    // Vertices are shared, so each triangle gets a flat shade from its index
+    uint h = uint(id) * 2654435761u;
+    float shade = 0.3 + 0.6 * float(h >> 24) / 255.0;
+
+    fragColor = vec4(shade * mix(goodColor, badColor, bad), 0.0);
 }
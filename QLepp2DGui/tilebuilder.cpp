@@ -0,0 +1,219 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <tilebuilder.h>
+
+// Triangles per tile, if the mesh had the same density everywhere
+static const int TILE_TRIANGLES = 16384;
+
+// Each level has about this many times fewer triangles than the mesh
+static const int LOD_REDUCTION[LOD_LEVELS] = {16, 256};
+
+// Grid of about 'cells' square cells over the XY plane of a box
+struct Grid
+{
+    Grid(const float *min, const float *max, int cells) :
+        minX(min[0]),
+        minY(min[1]),
+        width(std::max(max[0] - min[0], std::numeric_limits<float>::epsilon())),
+        height(std::max(max[1] - min[1], std::numeric_limits<float>::epsilon())),
+        cols(std::min(cells, std::max(1, static_cast<int>(std::lround(std::sqrt(cells * width / height)))))),
+        rows((cells + cols - 1) / cols)
+    {
+    }
+
+    int size() const
+    {
+        return cols * rows;
+    }
+
+    int cellOf(float x, float y) const
+    {
+        int col(std::min(cols - 1, std::max(0, static_cast<int>((x - minX) / width * cols))));
+        int row(std::min(rows - 1, std::max(0, static_cast<int>((y - minY) / height * rows))));
+        return row * cols + col;
+    }
+
+    float minX;
+    float minY;
+    float width;
+    float height;
+    int cols;
+    int rows;
+};
+
+static void emptyBox(float *min, float *max)
+{
+    std::fill(min, min + 3, std::numeric_limits<float>::max());
+    std::fill(max, max + 3, std::numeric_limits<float>::lowest());
+}
+
+static void expandBox(float *min, float *max, const Vertex &v)
+{
+    min[0] = std::min(min[0], v.x);
+    min[1] = std::min(min[1], v.y);
+    min[2] = std::min(min[2], v.z);
+    max[0] = std::max(max[0], v.x);
+    max[1] = std::max(max[1], v.y);
+    max[2] = std::max(max[2], v.z);
+}
+
+TileBuilder::TileBuilder(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void TileBuilder::build(QSharedPointer<const TileInput> input)
+{
+    qDebug() << "TileBuilder::build";
+    QSharedPointer<TileSet> tiles(new TileSet);
+    tiles->generation = input->generation;
+    tiles->triangleCount = input->indices.size() / 3;
+
+    const int count(tiles->triangleCount);
+    const QVector<Vertex> &vertices(input->vertices);
+    const unsigned int *indices(input->indices.constData());
+    if (count == 0)
+    {
+        emit built(tiles);
+        return;
+    }
+
+    float min[3];
+    float max[3];
+    emptyBox(min, max);
+    for (const Vertex &v : vertices)
+    {
+        expandBox(min, max, v);
+    }
+
+    // Counting sort of the triangles by the cell of their centroids
+    Grid grid(min, max, std::max(1, count / TILE_TRIANGLES));
+    QVector<int> cellOf(count);
+    QVector<int> start(grid.size() + 1, 0);
+    for (int i(0); i < count; i++)
+    {
+        const Vertex &a(vertices.at(static_cast<int>(indices[3 * i])));
+        const Vertex &b(vertices.at(static_cast<int>(indices[3 * i + 1])));
+        const Vertex &c(vertices.at(static_cast<int>(indices[3 * i + 2])));
+        cellOf[i] = grid.cellOf((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3);
+        start[cellOf.at(i) + 1]++;
+    }
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    QVector<int> next(start);
+    tiles->order.resize(count);
+    for (int i(0); i < count; i++)
+    {
+        tiles->order[next[cellOf.at(i)]++] = i;
+    }
+
+    // Empty cells don't get a tile
+    for (int cell(0); cell < grid.size(); cell++)
+    {
+        if (start.at(cell) == start.at(cell + 1))
+        {
+            continue;
+        }
+        MeshTile tile;
+        tile.first = start.at(cell);
+        tile.count = start.at(cell + 1) - start.at(cell);
+        emptyBox(tile.min, tile.max);
+        for (int p(tile.first); p < tile.first + tile.count; p++)
+        {
+            const unsigned int *t(indices + 3 * tiles->order.at(p));
+            for (int k(0); k < 3; k++)
+            {
+                expandBox(tile.min, tile.max, vertices.at(static_cast<int>(t[k])));
+            }
+        }
+        tiles->tiles.append(tile);
+    }
+
+    /* Vertex clustering: the vertices in each cell of a finer grid collapse into
+     * the first one of them. The grid is the same for every tile, so the
+     * borders of neighbouring tiles still match.
+     */
+    std::vector<std::array<unsigned int, 4>> collapsed;
+    for (int level(0); level < LOD_LEVELS; level++)
+    {
+        Grid clusters(min, max, std::max(1, count / (2 * LOD_REDUCTION[level])));
+        QVector<int> representative(clusters.size(), -1);
+        for (int v(0); v < vertices.size(); v++)
+        {
+            int &r(representative[clusters.cellOf(vertices.at(v).x, vertices.at(v).y)]);
+            if (r < 0)
+            {
+                r = v;
+            }
+        }
+        auto collapse = [&](unsigned int v) {
+            const Vertex &vertex(vertices.at(static_cast<int>(v)));
+            return static_cast<unsigned int>(representative.at(clusters.cellOf(vertex.x, vertex.y)));
+        };
+
+        for (MeshTile &tile : tiles->tiles)
+        {
+            collapsed.clear();
+            for (int p(tile.first); p < tile.first + tile.count; p++)
+            {
+                int source(tiles->order.at(p));
+                const unsigned int *t(indices + 3 * source);
+                std::array<unsigned int, 4> c{{collapse(t[0]), collapse(t[1]), collapse(t[2]),
+                                               static_cast<unsigned int>(source)}};
+
+                // Triangles with two corners in the same cell disappear
+                if (c[0] == c[1] or c[1] == c[2] or c[0] == c[2])
+                {
+                    continue;
+                }
+
+                // Faces aren't culled, so the winding doesn't matter
+                std::sort(c.begin(), c.begin() + 3);
+                collapsed.push_back(c);
+            }
+
+            // Many triangles collapse into the same one, which is drawn once
+            std::sort(collapsed.begin(), collapsed.end());
+            auto last = std::unique(collapsed.begin(), collapsed.end(),
+                                    [](const std::array<unsigned int, 4> &a, const std::array<unsigned int, 4> &b)
+                                    { return a[0] == b[0] and a[1] == b[1] and a[2] == b[2]; });
+
+            tile.lodFirst[level] = tiles->lodSources.size();
+            for (auto c(collapsed.begin()); c != last; ++c)
+            {
+                tiles->lodIndices.append((*c)[0]);
+                tiles->lodIndices.append((*c)[1]);
+                tiles->lodIndices.append((*c)[2]);
+                tiles->lodSources.append(static_cast<int>((*c)[3]));
+            }
+            tile.lodCount[level] = tiles->lodSources.size() - tile.lodFirst[level];
+        }
+    }
+
+    emit built(tiles);
+}
@@ -0,0 +1,84 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILEBUILDER_H
+#define TILEBUILDER_H
+
+#include <QMetaType>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <model.h>
+
+// Simplified levels of each tile, from the finest to the coarsest
+static const int LOD_LEVELS = 2;
+
+// Triangles of the mesh whose centroids are in the same cell of a grid. They
+// are drawn together, and skipped when their box is out of the view.
+struct MeshTile
+{
+    int first = 0;                      // First draw position of its triangles
+    int count = 0;
+    float min[3];                       // Bounding box of its triangles
+    float max[3];
+    int lodFirst[LOD_LEVELS];           // First triangle of each level, in the LOD buffer
+    int lodCount[LOD_LEVELS];
+    bool lodStale = false;              // Some of its triangles changed after the LOD was built
+};
+
+// Copy of the mesh as the view draws it. Both vectors are implicitly shared,
+// so the copy is only made if the view modifies them while the tiles are built.
+struct TileInput
+{
+    int generation = 0;                 // Mesh loaded in the view
+    QVector<Vertex> vertices;
+    QVector<unsigned int> indices;      // 3 per triangle, in draw order
+};
+
+struct TileSet
+{
+    int generation = 0;
+    int triangleCount = 0;              // Triangles of the input
+    QVector<int> order;                 // Input position of the triangle of each new draw position
+    QVector<MeshTile> tiles;
+    QVector<unsigned int> lodIndices;   // Levels one after the other, each one in the order of the tiles
+    QVector<int> lodSources;            // Input position of the triangle that gives its color to each LOD triangle
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<const TileInput>)
+Q_DECLARE_METATYPE(QSharedPointer<const TileSet>)
+
+// Sorts the triangles into tiles, and simplifies each tile by vertex
+// clustering, in its own thread so the view keeps drawing meanwhile.
+class TileBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TileBuilder(QObject *parent = nullptr);
+
+public slots:
+    void build(QSharedPointer<const TileInput> input);
+
+signals:
+    void built(QSharedPointer<const TileSet> tiles);
+};
+
+#endif // TILEBUILDER_H
@@ -26,10 +26,26 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        filehandlers/filehandler.cpp \
         filehandlers/filemanager.cpp \
         filehandlers/offhandler.cpp \
+        filehandlers/topologybuilder.cpp \
+        filehandlers/xyzhandler.cpp \
+        triangulation/delaunaytriangulator.cpp \
+        triangulation/randommeshgenerator.cpp \
+        filehandlers/journal.cpp \
+        engine/engine.cpp \
+        engine/progress.cpp \
+        metrics/allocationtracker.cpp \
+        metrics/histogram.cpp \
+        metrics/metrics.cpp \
+        metrics/perfcounters.cpp \
+        metrics/tracer.cpp \
         engine/cpuengine.cpp \
         engine/openclengine.cpp \
+        storage/mappedstorage.cpp \
+        storage/localityorder.cpp \
+        batch/batchprocessor.cpp \
         model.cpp \
         model_impl.cpp
 
@@ -38,14 +54,35 @@ HEADERS += \
         structs/triangle.h \
         structs/vertex.h \
         structs/edge.h \
+        structs/meshvector.h \
+        structs/batch.h \
+        structs/memoryreport.h \
+        batch/batchprocessor.h \
+        batch/blockingqueue.h \
+        storage/localityorder.h \
         engine/cpuengine.h \
         engine/openclengine.h \
         filehandlers/filemanager.h \
         filehandlers/filehandler.h \
         filehandlers/offhandler.h \
+        filehandlers/topologybuilder.h \
+        filehandlers/xyzhandler.h \
+        triangulation/delaunaytriangulator.h \
+        triangulation/randommeshgenerator.h \
+        filehandlers/journal.h \
+        filehandlers/rawio.h \
         model.h \
         model_impl.h \
         engine/engine.h \
+        metrics/allocationtracker.h \
+        metrics/devicecommand.h \
+        metrics/histogram.h \
+        metrics/metrics.h \
+        metrics/perfcounters.h \
+        metrics/scopedtimer.h \
+        metrics/tracer.h \
+        engine/changeset.h \
+        engine/progress.h \
 
 # Installable headers
 header_files.path   = /usr/include/QLepp2D
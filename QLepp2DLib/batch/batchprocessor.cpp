@@ -0,0 +1,205 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include <chrono>
+#include <thread>
+
+#include <batch/batchprocessor.h>
+#include <filehandlers/filemanager.h>
+
+BatchProcessor::BatchProcessor(Engine *engine, unsigned int concurrency, const MappedStorage &storage)
+    : m_engine(engine),
+      m_concurrency(concurrency > 0 ? concurrency : 1),
+      m_storage(storage)
+{
+}
+
+BatchReport BatchProcessor::process(const std::vector<BatchJob> &jobs, float angle, unsigned long rounds)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    BatchReport report;
+    report.results.resize(jobs.size());
+    for (unsigned long i(0); i < jobs.size(); i++)
+    {
+        report.results[i] = BatchResult{jobs[i].input, jobs[i].output, false, 0, 0};
+    }
+
+    BlockingQueue<Mesh> loaded(m_concurrency);
+    BlockingQueue<Mesh> refined(m_concurrency);
+    std::atomic<unsigned long> nextJob(0);
+    std::atomic<unsigned int> runningLoaders(m_concurrency);
+
+    std::vector<std::thread> loaders;
+    std::vector<std::thread> savers;
+    for (unsigned int i(0); i < m_concurrency; i++)
+    {
+        loaders.emplace_back([this, &jobs, &nextJob, &loaded, &runningLoaders]() {
+            load(jobs, nextJob, loaded);
+
+            // The last loader tells the refining stage that nothing else is coming
+            if (--runningLoaders == 0)
+            {
+                loaded.close();
+            }
+        });
+        savers.emplace_back([this, &refined, &report]() {
+            save(refined, report.results);
+        });
+    }
+
+    refine(angle, rounds, loaded, refined, report.results);
+    refined.close();
+
+    for (std::thread &loader : loaders)
+    {
+        loader.join();
+    }
+    for (std::thread &saver : savers)
+    {
+        saver.join();
+    }
+
+    for (BatchResult &result : report.results)
+    {
+        if (result.ok)
+        {
+            report.meshes++;
+            report.triangles += result.triangles;
+        }
+        else
+        {
+            report.failed++;
+        }
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    qInfo() << "Batch:" << report.meshes << "meshes," << report.failed << "failed in" << report.seconds << "s";
+    qInfo() << "Batch:" << report.meshesPerSecond() << "meshes/s," << report.trianglesPerSecond() << "triangles/s";
+
+    return report;
+}
+
+void BatchProcessor::load(const std::vector<BatchJob> &jobs,
+                          std::atomic<unsigned long> &nextJob,
+                          BlockingQueue<Mesh> &loaded)
+{
+    FileManager fileManager;
+    for (unsigned long job = nextJob++; job < jobs.size(); job = nextJob++)
+    {
+        Mesh mesh;
+        mesh.job = job;
+        mesh.vertices = MeshVector<Vertex>(m_storage);
+        mesh.edges = MeshVector<Edge>(m_storage);
+        mesh.triangles = MeshVector<Triangle>(m_storage);
+        try
+        {
+            mesh.ok = fileManager.load(jobs[job].input, mesh.vertices, mesh.edges, mesh.triangles);
+        }
+        catch (...)
+        {
+            mesh.ok = false;
+        }
+
+        if (not mesh.ok)
+        {
+            qWarning() << "Could not load" << QString::fromStdString(jobs[job].input);
+        }
+
+        // Failed meshes also go through the pipeline, so they're reported in order
+        if (not loaded.push(std::move(mesh)))
+        {
+            return;
+        }
+    }
+}
+
+void BatchProcessor::refine(float angle,
+                            unsigned long rounds,
+                            BlockingQueue<Mesh> &loaded,
+                            BlockingQueue<Mesh> &refined,
+                            std::vector<BatchResult> &results)
+{
+    Mesh mesh;
+    while (loaded.pop(mesh))
+    {
+        if (mesh.ok)
+        {
+            unsigned long round(0);
+            // Like the other stages, a failure only fails this job
+            try
+            {
+                mesh.ok = m_engine->detectBadTriangles(angle, mesh.vertices, mesh.triangles);
+                while (mesh.ok and (rounds == 0 or round < rounds))
+                {
+                    mesh.ok = m_engine->improveTriangulation(mesh.vertices, mesh.edges, mesh.triangles);
+                    round++;
+
+                    // Each insertion adds exactly one vertex (the centroid)
+                    if (mesh.vertices.size() == m_engine->getChanges().firstVertex)
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                mesh.ok = false;
+            }
+
+            if (not mesh.ok)
+            {
+                qWarning() << "Could not refine" << QString::fromStdString(results[mesh.job].input);
+            }
+            m_engine->getMetrics().clear();
+            results[mesh.job].rounds = round;
+        }
+
+        refined.push(std::move(mesh));
+        mesh = Mesh();
+    }
+}
+
+void BatchProcessor::save(BlockingQueue<Mesh> &refined,
+                          std::vector<BatchResult> &results)
+{
+    FileManager fileManager;
+    Mesh mesh;
+    while (refined.pop(mesh))
+    {
+        BatchResult &result = results[mesh.job];
+        try
+        {
+            result.ok = (mesh.ok and fileManager.save(result.output, mesh.vertices, mesh.edges, mesh.triangles));
+        }
+        catch (...)
+        {
+            result.ok = false;
+        }
+        result.triangles = mesh.triangles.size();
+
+        if (mesh.ok and not result.ok)
+        {
+            qWarning() << "Could not save" << QString::fromStdString(result.output);
+        }
+    }
+}
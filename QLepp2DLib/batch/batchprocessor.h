@@ -0,0 +1,111 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <atomic>
+#include <vector>
+
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+#include <structs/batch.h>
+#include <batch/blockingqueue.h>
+#include <engine/engine.h>
+
+/**
+* @brief Refines many mesh files in a 3-stage pipeline: while one mesh is
+* being refined, the next ones are parsed and the previous ones are written.
+* Parsing and writing use as many threads as the concurrency, but every mesh
+* is refined by the same engine, one at a time, so an OpenCL context is only
+* set up once for the whole batch.
+*
+*/
+class BatchProcessor
+{
+public:
+    /**
+    * @brief Constructor of BatchProcessor.
+    *
+    * @param engine p_engine: Engine used to refine every mesh. Not owned.
+    * @param concurrency p_concurrency: Number of parsing threads, of writing
+    * threads, and of meshes that can wait between stages.
+    * @param storage p_storage: Memory of the parsed meshes.
+    */
+    BatchProcessor(Engine *engine, unsigned int concurrency, const MappedStorage &storage = MappedStorage());
+
+    /**
+    * @brief Refines every job and waits until all of them are saved.
+    *
+    * @param jobs p_jobs: Files to refine.
+    * @param angle p_angle: Minimum angle of a good triangle.
+    * @param rounds p_rounds: Maximum improvement rounds. 0 refines until no
+    * centroid can be inserted.
+    * @return Outcome of each job and aggregate throughput.
+    */
+    BatchReport process(const std::vector<BatchJob> &jobs, float angle, unsigned long rounds);
+
+private:
+    /**
+    * @brief A mesh moving through the pipeline.
+    *
+    */
+    struct Mesh
+    {
+        unsigned long job = 0;
+        bool ok = false;
+        MeshVector<Vertex> vertices;
+        MeshVector<Edge> edges;
+        MeshVector<Triangle> triangles;
+    };
+
+    /**
+    * @brief Parsing stage. Takes jobs until there are none left.
+    *
+    */
+    void load(const std::vector<BatchJob> &jobs,
+              std::atomic<unsigned long> &nextJob,
+              BlockingQueue<Mesh> &loaded);
+
+    /**
+    * @brief Refining stage. Runs in the calling thread, as the engine isn't
+    * meant to be used by several threads.
+    *
+    */
+    void refine(float angle,
+                unsigned long rounds,
+                BlockingQueue<Mesh> &loaded,
+                BlockingQueue<Mesh> &refined,
+                std::vector<BatchResult> &results);
+
+    /**
+    * @brief Writing stage. Saves meshes until the refining stage finishes.
+    *
+    */
+    void save(BlockingQueue<Mesh> &refined,
+              std::vector<BatchResult> &results);
+
+    Engine *m_engine;
+    unsigned int m_concurrency;
+    MappedStorage m_storage;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,109 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+* @brief Bounded FIFO queue shared by the stages of a pipeline. Producers wait
+* while it's full, so a fast stage can't keep more than "capacity" items in
+* memory ahead of a slow one.
+*
+*/
+template<typename T>
+class BlockingQueue
+{
+public:
+    /**
+    * @brief Constructor of BlockingQueue.
+    *
+    * @param capacity p_capacity: Maximum number of waiting items.
+    */
+    explicit BlockingQueue(unsigned long capacity)
+        : m_capacity(capacity > 0 ? capacity : 1),
+          m_closed(false)
+    {
+    }
+
+    /**
+    * @brief Adds an item, waiting for space if needed.
+    *
+    * @param item p_item: Item to add.
+    * @return False if the queue was closed, in which case the item is dropped.
+    */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]() { return m_closed or m_items.size() < m_capacity; });
+        if (m_closed)
+        {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+    * @brief Takes the oldest item, waiting for one if needed.
+    *
+    * @param item p_item: Where the item is moved to.
+    * @return False if the queue is closed and there's nothing left.
+    */
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return m_closed or not m_items.empty(); });
+        if (m_items.empty())
+        {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /**
+    * @brief Marks the end of the items. Waiting consumers get the remaining
+    * items and then stop.
+    *
+    */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    std::deque<T> m_items;
+    unsigned long m_capacity;
+    bool m_closed;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+#endif // BLOCKINGQUEUE_H
@@ -0,0 +1,44 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGESET_H
+#define CHANGESET_H
+
+#include <vector>
+
+/**
+ * @brief Positions of the vectors that were modified by the last
+ * improvement of the triangulation.
+ *
+ * Vectors only grow during an improvement, so every new element lives from
+ * the "first" indices onwards, while the old positions that were recycled
+ * (see phases 4, 5 and 6 of CPUEngine::insertCentroid) are listed explicitly.
+ *
+ */
+struct ChangeSet
+{
+    unsigned long firstVertex = 0;      // Size of "vertices" before the improvement
+    unsigned long firstEdge = 0;        // Size of "edges" before the improvement
+    unsigned long firstTriangle = 0;    // Size of "triangles" before the improvement
+
+    std::vector<int> edges;             // Sorted indices of rewritten old edges
+    std::vector<int> triangles;         // Sorted indices of rewritten old triangles
+};
+
+#endif // CHANGESET_H
@@ -18,73 +18,99 @@
  */
 
 #include <QDebug>
-#include <QElapsedTimer>
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <engine/cpuengine.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/perfcounters.h>
+#include <metrics/scopedtimer.h>
 #include <structs/triangle.h>
 #include <structs/edge.h>
 
 CPUEngine::CPUEngine()
+    : m_threadCount(1)
 {
     m_angle = 0;
 }
 
 bool CPUEngine::detectBadTriangles(float angle,
-                                   std::vector<Vertex> &vertices,
-                                   std::vector<Triangle> &triangles)
+                                   MeshVector<Vertex> &vertices,
+                                   MeshVector<Triangle> &triangles)
 {
     qDebug() << "(CPU) Angle :" << angle;
     m_angle = angle;
 
-    QElapsedTimer timer;
-    timer.start();
+    ScopedTimer timer(m_metrics, "DBT_F");
 
-    for (Triangle &t : triangles)
-    {
-        Vertex A, B, C;
-        A = vertices.at(t.iv1);
-        B = vertices.at(t.iv2);
-        C = vertices.at(t.iv3);
+    // Bad triangles are counted by each thread while they're detected
+    std::vector<unsigned long> badCounts(m_threadCount, 0);
 
-        float length_A = pow(B.x - C.x, 2) + pow(B.y - C.y, 2) + pow(B.z - C.z, 2);
-        float length_B = pow(A.x - C.x, 2) + pow(A.y - C.y, 2) + pow(A.z - C.z, 2);
-        float length_C = pow(A.x - B.x, 2) + pow(A.y - B.y, 2) + pow(A.z - B.z, 2);
-
-        float length_a = sqrt(length_A);
-        float length_b = sqrt(length_B);
-        float length_c = sqrt(length_C);
-
-        float angle_opp_A = std::acos((length_B + length_C - length_A)
-                                      / (2 * length_b * length_c));
-        float angle_opp_B = std::acos((length_A + length_C - length_B)
-                                      / (2 * length_a * length_c));
-        float angle_opp_C = std::acos((length_A + length_B - length_C)
-                                      / (2 * length_a * length_b));
-
-        float rad_angle = angle * static_cast<float>(M_PI) / 180.0f;
-
-        t.bad = (angle_opp_A < rad_angle or
-                 angle_opp_B < rad_angle or
-                 angle_opp_C < rad_angle);
+    bool completed(false);
+    try
+    {
+        completed = parallelFor("DBT_F", triangles.size(), [&](unsigned long begin, unsigned long end, unsigned int thread) {
+            unsigned long badCount(0);
+            for (unsigned long i(begin); i < end; i++)
+            {
+                Triangle &t(triangles.at(i));
+
+                Vertex A, B, C;
+                A = vertices.at(t.iv1);
+                B = vertices.at(t.iv2);
+                C = vertices.at(t.iv3);
+
+                float length_A = pow(B.x - C.x, 2) + pow(B.y - C.y, 2) + pow(B.z - C.z, 2);
+                float length_B = pow(A.x - C.x, 2) + pow(A.y - C.y, 2) + pow(A.z - C.z, 2);
+                float length_C = pow(A.x - B.x, 2) + pow(A.y - B.y, 2) + pow(A.z - B.z, 2);
+
+                float length_a = sqrt(length_A);
+                float length_b = sqrt(length_B);
+                float length_c = sqrt(length_C);
+
+                float angle_opp_A = std::acos((length_B + length_C - length_A)
+                                              / (2 * length_b * length_c));
+                float angle_opp_B = std::acos((length_A + length_C - length_B)
+                                              / (2 * length_a * length_c));
+                float angle_opp_C = std::acos((length_A + length_B - length_C)
+                                              / (2 * length_a * length_b));
+
+                float rad_angle = angle * static_cast<float>(M_PI) / 180.0f;
+
+                t.bad = (angle_opp_A < rad_angle or
+                         angle_opp_B < rad_angle or
+                         angle_opp_C < rad_angle);
+                badCount += static_cast<unsigned long>(t.bad);
+            }
+            badCounts[thread] += badCount;
+        });
+    }
+    catch (std::exception &e)
+    {
+        qWarning() << e.what();
+        return false;
+    }
+    catch (...)
+    {
+        qWarning() << "Unknown error in CPUEngine::detectBadTriangles";
+        return false;
     }
-    qint64 elapsed = timer.nsecsElapsed();
-    qInfo() << "___";
-    qInfo() << "(CPU) DBT_F :" << elapsed << "nanoseconds";
 
-    // Only to check ratio of bad/total triangles (won't be in benchmark!)
-    int badCount{0};
-    for (Triangle &t : triangles)
+    for (unsigned long badCount : badCounts)
     {
-        badCount += t.bad;
+        m_metrics.addCount("bad_triangles", badCount);
     }
-    qDebug() << "Ratio:" << static_cast<float>(badCount) / triangles.size();
 
-    return true;
+    // Triangles of the chunks that didn't start keep their old flags
+    return completed;
 }
 
-bool CPUEngine::improveTriangulation(std::vector<Vertex> &vertices,
-                                     std::vector<Edge> &edges,
-                                     std::vector<Triangle> &triangles)
+bool CPUEngine::improveTriangulation(MeshVector<Vertex> &vertices,
+                                     MeshVector<Edge> &edges,
+                                     MeshVector<Triangle> &triangles)
 {
     /* Relevant information: Each insertion does
      *   +1 to vertices.size()
@@ -94,6 +120,9 @@ bool CPUEngine::improveTriangulation(std::vector<Vertex> &vertices,
 
     qDebug() << "CPUEngine::improveTriangulation";
 
+    // Nothing has changed yet (in case we don't reach Phase 2)
+    beginChanges(vertices, edges, triangles);
+
     /* We'll do this in 3 phases:
      * Phase 1: Detect the terminal edges for each bad triangle.
      * Phase 2: Insert new triangle(s) at each terminal edge.
@@ -106,6 +135,10 @@ bool CPUEngine::improveTriangulation(std::vector<Vertex> &vertices,
         bool nonBTERemaining = false; // Flag that shows if we still have Non-border Terminal Edges.
         detectTerminalEdges(vertices, edges, triangles, nonBTERemaining);
 
+        if (isCancelled())
+        {
+            return false;
+        }
         if (not nonBTERemaining)
         {
             return true;
@@ -114,10 +147,13 @@ bool CPUEngine::improveTriangulation(std::vector<Vertex> &vertices,
         // Phase 2
         insertCentroids(vertices, edges, triangles);
 
-        // Phase 3
-        detectBadTriangles(m_angle, vertices, triangles);
+        if (isCancelled())
+        {
+            return false;
+        }
 
-        return true;
+        // Phase 3
+        return detectBadTriangles(m_angle, vertices, triangles);
     }
     catch (std::exception &e)
     {
@@ -131,69 +167,228 @@ bool CPUEngine::improveTriangulation(std::vector<Vertex> &vertices,
     }
 }
 
-void CPUEngine::detectTerminalEdges(std::vector<Vertex> &vertices,
-                                    std::vector<Edge> &edges,
-                                    std::vector<Triangle> &triangles,
+void CPUEngine::detectTerminalEdges(MeshVector<Vertex> &vertices,
+                                    MeshVector<Edge> &edges,
+                                    MeshVector<Triangle> &triangles,
                                     bool &flag)
 {
-    QElapsedTimer timer;
-    timer.start();
+    ScopedTimer timer(m_metrics, "DTE_F");
+
+    /* Lepps only read the mesh, so they're walked in parallel. Each thread
+     * keeps its terminal edges (and its flag), and they're marked afterwards,
+     * as several bad triangles can share the same terminal edge.
+     */
+    std::vector<std::vector<int>> terminalEdges(m_threadCount);
+    std::vector<char> flags(m_threadCount, 0);
+
+    // Lengths of the Lepps, only while collecting metrics
+    bool countSteps(m_metrics.isEnabled());
+    std::vector<Histogram> walks(countSteps ? m_threadCount : 0);
+
+    bool completed = parallelFor("DTE_F", triangles.size(), [&](unsigned long begin, unsigned long end, unsigned int thread) {
+        bool threadFlag(false);
+        unsigned int steps(0);
+        for (int i(static_cast<int>(begin)); i < static_cast<int>(end); i++)
+        {
+            Triangle &t(triangles.at(i));
+
+            /* Since we need to find the longest edges to get the Lepp, we can
+             * just create a protected method "int getTerminalIEdge()" that returns
+             * the index of the edge that is a terminal edge.
+             *
+             * From here, we can update the "edges" vector, and each of these edges
+             * will know if it's a terminal edge that has to be modified or not.
+             */
+            if (t.bad)
+            {
+                /* We can just calculate every triangle's lepp in GPU, but only have
+                 * to calculate the required here in CPU, as there's no need for
+                 * everyone right now.
+                 */
+                terminalEdges[thread].push_back(getTerminalIEdge(i, vertices, edges, triangles, threadFlag,
+                                                                 countSteps ? &steps : nullptr));
+                if (countSteps)
+                {
+                    walks[thread].add(steps);
+                }
+            }
+        }
+        flags[thread] = (flags[thread] or threadFlag);
+    });
+    // Nothing is marked when cancelled, so the edges are left untouched
+    if (not completed)
+    {
+        return;
+    }
+
+    unsigned long terminalCount(0);
+    for (unsigned int thread(0); thread < m_threadCount; thread++)
+    {
+        for (int longestIEdge : terminalEdges[thread])
+        {
+            Edge &e(edges.at(longestIEdge));
+            terminalCount += static_cast<unsigned long>(not e.isTE);
+            e.isTE = 1;
+        }
+        flag = (flag or flags[thread]);
+    }
+    m_metrics.addCount("terminal_edges", terminalCount);
+    for (const Histogram &walk : walks)
+    {
+        m_metrics.addSamples("lepp_steps", walk);
+    }
+}
 
-    for (int i(0); i < static_cast<int>(triangles.size()); i++)
+void CPUEngine::insertCentroids(MeshVector<Vertex> &vertices,
+                                MeshVector<Edge> &edges,
+                                MeshVector<Triangle> &triangles)
+{
+    unsigned long borderCount(0);
     {
-        Triangle &t(triangles.at(i));
-
-        /* Since we need to find the longest edges to get the Lepp, we can
-         * just create a protected method "int getTerminalIEdge()" that returns
-         * the index of the edge that is a terminal edge.
-         *
-         * From here, we can update the "edges" vector, and each of these edges
-         * will know if it's a terminal edge that has to be modified or not.
-         */
-        if (t.bad)
+        ScopedTimer timer(m_metrics, "IC_F");
+
+        beginChanges(vertices, edges, triangles);
+
+        // Insertions are sequential, so only the calling thread is counted
+        std::unique_ptr<PerfCounters> counters(m_metrics.hasHardwareCounters() ? new PerfCounters : nullptr);
+
+        for (unsigned int ie(0); ie < edges.size(); ie++)
         {
-            /* We can just calculate every triangle's lepp in GPU, but only have
-             * to calculate the required here in CPU, as there's no need for
-             * everyone right now.
+            /* Insertions are only interrupted between them. The terminal edges
+             * that remain marked are inserted by the next improvement.
              */
-            int longestIEdge = getTerminalIEdge(i, vertices, edges, triangles, flag);
-            edges.at(longestIEdge).isTE = 1;
+            if (ie > 0 and ie % CHUNK_SIZE == 0)
+            {
+                reportProgress("IC_F", ie, edges.size());
+                if (isCancelled())
+                {
+                    break;
+                }
+            }
+            Edge &e(edges.at(ie));
+            // If e.itb == -1, it's a border edge, so we won't insert a centroid
+            if (e.isTE and e.itb != -1)
+            {
+                insertCentroid(ie, vertices, edges, triangles);
+            }
+            else if (e.isTE)
+            {
+                borderCount++;
+            }
+        }
+
+        if (counters)
+        {
+            m_metrics.addHardwareCounters("IC_F", 0, counters->stop());
+        }
+        if (not isCancelled())
+        {
+            reportProgress("IC_F", edges.size(), edges.size());
         }
     }
 
-    qint64 elapsed = timer.nsecsElapsed();
-    qInfo() << "(CPU) DTE_F :" << elapsed << "nanoseconds";
+    endChanges();
+
+    // Each insertion adds exactly one vertex (the centroid)
+    m_metrics.addCount("border_terminal_edges", borderCount);
+    m_metrics.addCount("insertions", vertices.size() - m_changes.firstVertex);
 }
 
-void CPUEngine::insertCentroids(std::vector<Vertex> &vertices,
-                                std::vector<Edge> &edges,
-                                std::vector<Triangle> &triangles)
+bool CPUEngine::setThreadCount(unsigned int count)
 {
-    QElapsedTimer timer;
-    timer.start();
+    m_threadCount = (count > 0) ? count : 1;
+    return true;
+}
 
-    for (unsigned int ie(0); ie < edges.size(); ie++)
+bool CPUEngine::parallelFor(const char *phase,
+                            unsigned long count,
+                            std::function<void(unsigned long, unsigned long, unsigned int)> work)
+{
+    // Counters are opened by each thread, as they only count the thread that opens them
+    bool counting(m_metrics.hasHardwareCounters());
+    std::vector<HardwareCounters> counters(counting ? m_threadCount : 0);
+    std::atomic<unsigned long> processed(0);
+
+    // The first exception of a worker, rethrown in the calling thread after every join
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::atomic<bool> failed(false);
+
+    auto run = [this, &work, &counters, &processed, &failed, counting, phase, count](unsigned long begin, unsigned long end, unsigned int thread) {
+        AllocationScope allocations(phase);
+        std::unique_ptr<PerfCounters> perf(counting ? new PerfCounters : nullptr);
+        for (unsigned long chunk(begin); chunk < end and not isCancelled() and not failed; chunk += CHUNK_SIZE)
+        {
+            unsigned long chunkEnd = std::min(end, chunk + CHUNK_SIZE);
+            work(chunk, chunkEnd, thread);
+            reportProgress(phase, processed += chunkEnd - chunk, count);
+        }
+        if (perf)
+        {
+            counters[thread] = perf->stop();
+        }
+    };
+    if (m_threadCount == 1)
     {
-        Edge &e(edges.at(ie));
-        // If e.itb == -1, it's a border edge, so we won't insert a centroid
-        if (e.isTE and e.itb != -1)
+        run(0, count, 0);
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        unsigned long chunk = (count + m_threadCount - 1) / m_threadCount;
+        for (unsigned int thread(0); thread < m_threadCount; thread++)
+        {
+            unsigned long begin = std::min(count, thread * chunk);
+            unsigned long end = std::min(count, begin + chunk);
+            threads.emplace_back([&run, &error, &errorMutex, &failed, begin, end, thread]() {
+                long long start = Tracer::getInstance().isEnabled() ? Tracer::getInstance().now() : -1;
+                try
+                {
+                    run(begin, end, thread);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (not error)
+                    {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+                if (start >= 0)
+                {
+                    Tracer &tracer(Tracer::getInstance());
+                    tracer.addSpan(Tracer::WORKER_TRACK + static_cast<int>(thread), "worker", "engine", start, tracer.now());
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        if (error)
         {
-            insertCentroid(ie, vertices, edges, triangles);
+            std::rethrow_exception(error);
         }
     }
 
-    qint64 elapsed = timer.nsecsElapsed();
-    qInfo() << "(CPU)  IC_F :" << elapsed << "nanoseconds";
+    for (unsigned int thread(0); thread < counters.size(); thread++)
+    {
+        m_metrics.addHardwareCounters(phase, thread, counters[thread]);
+    }
+    return processed == count;
 }
 
 int CPUEngine::getTerminalIEdge(int it,
-                                std::vector<Vertex> &vertices,
-                                std::vector<Edge> &edges,
-                                std::vector<Triangle> &triangles,
-                                bool &flag) const
+                                MeshVector<Vertex> &vertices,
+                                MeshVector<Edge> &edges,
+                                MeshVector<Triangle> &triangles,
+                                bool &flag,
+                                unsigned int *steps) const
 {
     QVector<int> triangleHistory;
     int k = 0;                                              // Index of triangleHistory
+    unsigned int visited = 0;                               // Length of the Lepp
 
     triangleHistory.resize(3);
     for (int j(0); j < 3; j++)
@@ -206,6 +401,7 @@ int CPUEngine::getTerminalIEdge(int it,
     {
         // Add myself to the history.
         triangleHistory[k] = it;
+        visited++;
 
         // Detect longest edge.
         Vertex A, B, C;
@@ -243,6 +439,10 @@ int CPUEngine::getTerminalIEdge(int it,
         // Border triangle
         if (neighbourIT < 0)
         {
+            if (steps != nullptr)
+            {
+                *steps = visited;
+            }
             return longestIE;
         }
 
@@ -250,6 +450,10 @@ int CPUEngine::getTerminalIEdge(int it,
         if (it == triangleHistory.at((k + 1) % 3))          // Equivalent of (k - 2)
         {
             flag = true;
+            if (steps != nullptr)
+            {
+                *steps = visited - 1;                       // The last one was visited twice
+            }
             return longestIE;
         }
 
@@ -266,7 +470,7 @@ Vertex CPUEngine::centroidOf(int iva,
                              int ivb,
                              int ivc,
                              int ivd,
-                             std::vector<Vertex> &vertices)
+                             MeshVector<Vertex> &vertices)
 {
     Vertex centroid;
     centroid.x = (vertices.at(iva).x +
@@ -286,9 +490,9 @@ Vertex CPUEngine::centroidOf(int iva,
 }
 
 void CPUEngine::insertCentroid(int iedge,
-                               std::vector<Vertex> &vertices,
-                               std::vector<Edge> &edges,
-                               std::vector<Triangle> &triangles)
+                               MeshVector<Vertex> &vertices,
+                               MeshVector<Edge> &edges,
+                               MeshVector<Triangle> &triangles)
 {
     /* This is the difficult part of the project.
      * The algorithm is divided in 7 "phases", that will be documented here.
@@ -431,6 +635,8 @@ void CPUEngine::insertCentroid(int iedge,
     newITriangles.append(triangles.size() - 1);
     triangles.push_back(newTriangles.at(3));
     newITriangles.append(triangles.size() - 1);
+    markTriangleChanged(oldE.ita);
+    markTriangleChanged(oldE.itb);
 
     // Phase 5
     /* We'll work with our new triangles. We'll take two of them that share one
@@ -458,6 +664,7 @@ void CPUEngine::insertCentroid(int iedge,
     for (int ie : nonSharedIEdges)
     {
         Edge &e(edges.at(ie));
+        markEdgeChanged(ie);
 
         for (int it(0); it < 4; it++)
         {
@@ -481,6 +688,7 @@ void CPUEngine::insertCentroid(int iedge,
     QVector<int> newIEdges;
     newIEdges.append(iedge);
     edges.at(newIEdges.at(0)) = newEdges.at(0);
+    markEdgeChanged(iedge);
     edges.push_back(newEdges.at(1));
     newIEdges.append(edges.size() - 1);
     edges.push_back(newEdges.at(2));
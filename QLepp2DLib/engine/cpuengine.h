@@ -20,6 +20,8 @@
 #ifndef CPUENGINE_H
 #define CPUENGINE_H
 
+#include <functional>
+
 #include <engine/engine.h>
 
 /**
@@ -44,8 +46,8 @@ public:
      * @return True if detected without issues.
      */
     virtual bool detectBadTriangles(float angle,
-                                    std::vector<Vertex> &vertices,
-                                    std::vector<Triangle> &triangles) override;
+                                    MeshVector<Vertex> &vertices,
+                                    MeshVector<Triangle> &triangles) override;
 
     /**
      * @brief Improves the actual triangulation from the vector of triangles. Overridden method.
@@ -55,9 +57,9 @@ public:
      * @param triangles p_triangles: Vector of triangles.
      * @return True if improved without issues.
      */
-    virtual bool improveTriangulation(std::vector<Vertex> &vertices,
-                                      std::vector<Edge> &edges,
-                                      std::vector<Triangle> &triangles) override;
+    virtual bool improveTriangulation(MeshVector<Vertex> &vertices,
+                                      MeshVector<Edge> &edges,
+                                      MeshVector<Triangle> &triangles) override;
 
     /**
      * @brief Detects terminal edges for each bad triangle in the "triangles"
@@ -69,9 +71,9 @@ public:
      * @param flag p_flag: Flag that marks if a non-border terminal edge still
      * exists.
      */
-    virtual void detectTerminalEdges(std::vector<Vertex> &vertices,
-                                     std::vector<Edge> &edges,
-                                     std::vector<Triangle> &triangles,
+    virtual void detectTerminalEdges(MeshVector<Vertex> &vertices,
+                                     MeshVector<Edge> &edges,
+                                     MeshVector<Triangle> &triangles,
                                      bool &flag) override;
 
     /**
@@ -81,11 +83,49 @@ public:
      * @param edges p_edges: Vector of edges.
      * @param triangles p_triangles: Vector of triangles.
      */
-    virtual void insertCentroids(std::vector<Vertex> &vertices,
-                                 std::vector<Edge> &edges,
-                                 std::vector<Triangle> &triangles) override;
+    virtual void insertCentroids(MeshVector<Vertex> &vertices,
+                                 MeshVector<Edge> &edges,
+                                 MeshVector<Triangle> &triangles) override;
+
+    /**
+     * @brief Sets the number of threads used to detect bad triangles and
+     * terminal edges. Centroids are always inserted by one thread, as each
+     * insertion modifies its neighbourhood. Overridden method.
+     *
+     * @param count p_count: Number of threads. Default is 1.
+     * @return True.
+     */
+    virtual bool setThreadCount(unsigned int count) override;
+
+protected:
+    /**
+     * @brief Elements processed between two checks of the cancellation token
+     * (and two progress reports).
+     *
+     */
+    static const unsigned long CHUNK_SIZE = 16384;
+
+    /**
+     * @brief Splits [0, count) in contiguous ranges, one per thread, and runs
+     * "work" on each of them, one chunk of CHUNK_SIZE elements at a time, so
+     * work may be called several times per thread. With 1 thread, runs in the
+     * calling thread. Reports the progress after each chunk, and stops
+     * starting new chunks once cancelled.
+     * Records the hardware counters of each thread, if enabled, and makes the
+     * phase the allocation phase of the threads.
+     * If work throws in a thread, the other threads stop starting new chunks
+     * and the first exception is rethrown in the calling thread once every
+     * thread has finished.
+     *
+     * @param phase p_phase: Name of the phase of the counters and the progress. Must be a string literal.
+     * @param count p_count: Number of elements.
+     * @param work p_work: Function of (begin, end, thread index).
+     * @return True if every element was processed (false if cancelled).
+     */
+    bool parallelFor(const char *phase,
+                     unsigned long count,
+                     std::function<void(unsigned long, unsigned long, unsigned int)> work);
 
-private:
     /**
      * @brief Returns the index to the "edges" vector in which the shared
      * (or border) terminal edge was found in the "it" triangle.
@@ -95,13 +135,15 @@ private:
      * @param edges p_edges: Vector of edges.
      * @param triangles p_triangles: Vector of triangles.
      * @param flag p_flag: Flag that shows if we still have Non-border Terminal Edges.
+     * @param steps p_steps: If not null, receives the number of triangles visited by the Lepp.
      * @return int Index of the terminal edge. -1 on error (Not expected to return an error).
      */
     int getTerminalIEdge(int it,
-                         std::vector<Vertex> &vertices,
-                         std::vector<Edge> &edges,
-                         std::vector<Triangle> &triangles,
-                         bool &flag) const;
+                         MeshVector<Vertex> &vertices,
+                         MeshVector<Edge> &edges,
+                         MeshVector<Triangle> &triangles,
+                         bool &flag,
+                         unsigned int *steps = nullptr) const;
 
     /**
      * @brief Returns the centroid of the 4 vertices.
@@ -117,7 +159,7 @@ private:
                       int ivb,
                       int ivc,
                       int ivd,
-                      std::vector<Vertex> &vertices);
+                      MeshVector<Vertex> &vertices);
 
     /**
      * @brief Inserts the centroid of the 2 triangles marked by index "iedge".
@@ -128,9 +170,11 @@ private:
      * @param triangles p_triangles: Vector of triangles.
      */
     void insertCentroid(int iedge,
-                        std::vector<Vertex> &vertices,
-                        std::vector<Edge> &edges,
-                        std::vector<Triangle> &triangles);
+                        MeshVector<Vertex> &vertices,
+                        MeshVector<Edge> &edges,
+                        MeshVector<Triangle> &triangles);
+
+    unsigned int m_threadCount;
 };
 
 #endif // CPUENGINE_H
@@ -0,0 +1,119 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <engine/engine.h>
+
+const ChangeSet& Engine::getChanges() const
+{
+    return m_changes;
+}
+
+void Engine::beginChanges(MeshVector<Vertex> &vertices,
+                          MeshVector<Edge> &edges,
+                          MeshVector<Triangle> &triangles)
+{
+    m_changes.firstVertex = vertices.size();
+    m_changes.firstEdge = edges.size();
+    m_changes.firstTriangle = triangles.size();
+    m_changes.edges.clear();
+    m_changes.triangles.clear();
+}
+
+void Engine::markEdgeChanged(int iedge)
+{
+    // New edges are already covered by firstEdge
+    if (static_cast<unsigned long>(iedge) < m_changes.firstEdge)
+    {
+        m_changes.edges.push_back(iedge);
+    }
+}
+
+void Engine::markTriangleChanged(int itriangle)
+{
+    // New triangles are already covered by firstTriangle
+    if (static_cast<unsigned long>(itriangle) < m_changes.firstTriangle)
+    {
+        m_changes.triangles.push_back(itriangle);
+    }
+}
+
+void Engine::endChanges()
+{
+    for (std::vector<int> *v : {&m_changes.edges, &m_changes.triangles})
+    {
+        std::sort(v->begin(), v->end());
+        v->erase(std::unique(v->begin(), v->end()), v->end());
+    }
+}
+
+Metrics& Engine::getMetrics()
+{
+    return m_metrics;
+}
+
+const Metrics& Engine::getMetrics() const
+{
+    return m_metrics;
+}
+
+bool Engine::setThreadCount(unsigned int count)
+{
+    (void) count;
+    return false;
+}
+
+std::vector<DeviceMemory> Engine::getDeviceMemory() const
+{
+    return std::vector<DeviceMemory>();
+}
+
+void Engine::setProgressCallback(ProgressCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    m_progress = callback;
+}
+
+void Engine::setCancellationToken(CancellationToken token)
+{
+    m_cancellation = token;
+}
+
+const CancellationToken& Engine::getCancellationToken() const
+{
+    return m_cancellation;
+}
+
+bool Engine::isCancelled() const
+{
+    return m_cancellation.isCancelled();
+}
+
+void Engine::reportProgress(const char *phase, unsigned long processed, unsigned long total)
+{
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    if (m_progress)
+    {
+        Progress progress;
+        progress.phase = phase;
+        progress.processed = processed;
+        progress.total = total;
+        m_progress(progress);
+    }
+}
@@ -20,10 +20,15 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
-#include <vector>
+#include <mutex>
 #include <structs/triangle.h>
 #include <structs/vertex.h>
 #include <structs/edge.h>
+#include <structs/meshvector.h>
+#include <structs/memoryreport.h>
+#include <engine/changeset.h>
+#include <engine/progress.h>
+#include <metrics/metrics.h>
 
 /**
  * @brief Interface for engines.
@@ -60,8 +65,8 @@ public:
      * @return True if detected without issues.
      */
     virtual bool detectBadTriangles(float angle,
-                                    std::vector<Vertex> &vertices,
-                                    std::vector<Triangle> &triangles) = 0;
+                                    MeshVector<Vertex> &vertices,
+                                    MeshVector<Triangle> &triangles) = 0;
 
     /**
      * @brief Improves the actual triangulation from the vector of triangles.
@@ -72,9 +77,9 @@ public:
      * @param triangles p_triangles: Vector of triangles.
      * @return True if improved without issues.
      */
-    virtual bool improveTriangulation(std::vector<Vertex> &vertices,
-                                      std::vector<Edge> &edges,
-                                      std::vector<Triangle> &triangles) = 0;
+    virtual bool improveTriangulation(MeshVector<Vertex> &vertices,
+                                      MeshVector<Edge> &edges,
+                                      MeshVector<Triangle> &triangles) = 0;
 
     // Available for API
 
@@ -88,9 +93,9 @@ public:
      * @param flag p_flag: Flag that marks if a non-border terminal edge still
      * exists.
      */
-    virtual void detectTerminalEdges(std::vector<Vertex> &vertices,
-                                     std::vector<Edge> &edges,
-                                     std::vector<Triangle> &triangles,
+    virtual void detectTerminalEdges(MeshVector<Vertex> &vertices,
+                                     MeshVector<Edge> &edges,
+                                     MeshVector<Triangle> &triangles,
                                      bool &flag) = 0;
 
     /**
@@ -100,12 +105,135 @@ public:
      * @param edges p_edges: Vector of edges.
      * @param triangles p_triangles: Vector of triangles.
      */
-    virtual void insertCentroids(std::vector<Vertex> &vertices,
-                                 std::vector<Edge> &edges,
-                                 std::vector<Triangle> &triangles) = 0;
+    virtual void insertCentroids(MeshVector<Vertex> &vertices,
+                                 MeshVector<Edge> &edges,
+                                 MeshVector<Triangle> &triangles) = 0;
+
+    /**
+     * @brief Gets the positions of the vectors that were modified by the last
+     * call to improveTriangulation (or insertCentroids).
+     *
+     * @return Changes of the last improvement.
+     */
+    const ChangeSet& getChanges() const;
+
+    /**
+     * @brief Gets the metrics of the engine. Timers are DBT_F, DTE_F, IC_F
+     * (and DBT_A, DTE_A for kernels), counters are bad_triangles,
+     * terminal_edges, border_terminal_edges and insertions. They're only
+     * collected after enabling them.
+     *
+     * @return Metrics registry.
+     */
+    Metrics& getMetrics();
+
+    /**
+     * @brief Gets the metrics of the engine.
+     *
+     * @return Metrics registry.
+     */
+    const Metrics& getMetrics() const;
+
+    /**
+     * @brief Sets how many threads the engine may use. Engines that don't
+     * manage their own threads (like OpenCL, where the runtime decides)
+     * ignore it.
+     *
+     * @param count p_count: Number of threads. At least 1.
+     * @return True if the engine accepts a thread count.
+     */
+    virtual bool setThreadCount(unsigned int count);
+
+    /**
+     * @brief Gets the memory of the buffers that the engine keeps in its
+     * devices. Engines without devices return none.
+     *
+     * @return One entry per device.
+     */
+    virtual std::vector<DeviceMemory> getDeviceMemory() const;
+
+    /**
+     * @brief Sets the function that receives the progress of each phase.
+     * An empty function disables the reports.
+     *
+     * @param callback p_callback: Receiver of the progress.
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Sets the token that stops the engine. A cancelled call returns
+     * false, leaving a consistent mesh: every insertion is either complete or
+     * not started, and the changes are still recorded. The bad flags of the
+     * triangles may be stale, though, so they must be detected again.
+     *
+     * @param token p_token: Cancellation token.
+     */
+    void setCancellationToken(CancellationToken token);
+
+    /**
+     * @brief Gets the cancellation token of the engine.
+     *
+     * @return Cancellation token.
+     */
+    const CancellationToken& getCancellationToken() const;
 
 protected:
+    /**
+     * @brief Checks the cancellation token. Engines call it between chunks
+     * of work, never in the middle of an insertion.
+     *
+     * @return True if the engine must stop.
+     */
+    bool isCancelled() const;
+
+    /**
+     * @brief Sends the progress of a phase to the callback, if there's one.
+     * Safe to call from several threads.
+     *
+     * @param phase p_phase: Name of the phase.
+     * @param processed p_processed: Elements processed so far.
+     * @param total p_total: Elements of the phase.
+     */
+    void reportProgress(const char *phase, unsigned long processed, unsigned long total);
+
+    /**
+     * @brief Forgets the previous changes and marks the current sizes of the
+     * vectors as the start of the new elements.
+     *
+     * @param vertices p_vertices: Vector of vertices.
+     * @param edges p_edges: Vector of edges.
+     * @param triangles p_triangles: Vector of triangles.
+     */
+    void beginChanges(MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles);
+
+    /**
+     * @brief Records an old edge that has been rewritten.
+     *
+     * @param iedge p_iedge: Index of the edge.
+     */
+    void markEdgeChanged(int iedge);
+
+    /**
+     * @brief Records an old triangle that has been rewritten.
+     *
+     * @param itriangle p_itriangle: Index of the triangle.
+     */
+    void markTriangleChanged(int itriangle);
+
+    /**
+     * @brief Sorts the recorded positions and removes duplicates.
+     *
+     */
+    void endChanges();
+
     float m_angle;
+    ChangeSet m_changes;
+    Metrics m_metrics;
+    ProgressCallback m_progress;
+    CancellationToken m_cancellation;
+    std::mutex m_progressMutex;
 };
 
 #endif // ENGINE_H
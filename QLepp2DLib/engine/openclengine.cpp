@@ -18,36 +18,71 @@
  */
 
 #include <QDebug>
-#include <QElapsedTimer>
 #include <QFile>
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <engine/openclengine.h>
 #include <engine/cpuengine.h>
+#include <metrics/scopedtimer.h>
 
-OpenCLEngine::OpenCLEngine()
+namespace
+{
+    /**
+    * @brief Context and compiled program of a platform. OpenCL objects can be
+    * used from any thread, so every engine of the platform shares them, and
+    * only builds the kernels once per process.
+    *
+    */
+    struct PlatformProgram
+    {
+        std::vector<cl::Platform> platforms;
+        std::vector<cl::Device> devices;
+        cl::Context context;
+        cl::Program program;
+    };
+
+    std::mutex programsMutex;
+    std::map<unsigned long, std::shared_ptr<PlatformProgram>> programs;
+}
+
+OpenCLEngine::OpenCLEngine(unsigned long platform_id, unsigned long device_id)
+    : m_deviceId(device_id),
+      m_bytesVertices(0),
+      m_bytesEdges(0),
+      m_bytesTriangles(0)
 {
     m_angle = 0;
-    setup();
+    setup(platform_id, device_id);
 }
 
 bool OpenCLEngine::detectBadTriangles(float angle,
-                                      std::vector<Vertex> &vertices,
-                                      std::vector<Triangle> &triangles)
+                                      MeshVector<Vertex> &vertices,
+                                      MeshVector<Triangle> &triangles)
 {
     qDebug() << "(OpenCL) Angle :" << angle;
 
     m_angle = angle;
+    // Kernels can't be interrupted, so they're only skipped
+    if (isCancelled())
+    {
+        return false;
+    }
     try
     {
-        QElapsedTimer timer;
-        timer.start();
-
-        // Create the memory buffers (Implicit copy to buffers when using iterators)
-        const bool USE_HOST_PTR(true);
+        ScopedTimer timer(m_metrics, "DBT_F");
 
-        // true == CL_MEM_READ_ONLY / false == CL_MEM_READ_WRITE
-        m_bufferTriangles = cl::Buffer(m_context, triangles.begin(), triangles.end(), false, USE_HOST_PTR);
-        m_bufferVertices = cl::Buffer(m_context, vertices.begin(), vertices.end(), false, USE_HOST_PTR);
+        // Create the memory buffers, with explicit copies so they can be profiled
+        {
+            TraceSpan span("upload", "opencl");
+            m_bytesTriangles = triangles.size() * sizeof(Triangle);
+            m_bufferTriangles = write(triangles.data(), m_bytesTriangles, "triangles");
+            m_bytesVertices = vertices.size() * sizeof(Vertex);
+            m_bufferVertices = write(vertices.data(), m_bytesVertices, "vertices");
+        }
 
         // Make kernel
         cl::make_kernel<float&, cl::Buffer&, cl::Buffer&> detect_kernel(m_program, "detectBadTriangles");
@@ -62,20 +97,38 @@ bool OpenCLEngine::detectBadTriangles(float angle,
         cl::EnqueueArgs eargs(m_queue, global/*, local*/);
 
         // Execute the kernel
+        long long enqueued = Tracer::getInstance().now();
         cl::Event event = detect_kernel(eargs, angle, m_bufferTriangles, m_bufferVertices);
-        event.wait();
+        {
+            TraceSpan span("wait", "opencl");
+            event.wait();
+        }
+        traceEvent(event, enqueued, "detectBadTriangles");
+        profile(event, DeviceCommand::Kernel, "detectBadTriangles", 0);
 
         // Copy the output data back to the host
-        cl::copy(m_queue, m_bufferTriangles, triangles.begin(), triangles.end());
-
-        // Get times
-        qint64 elapsed = timer.nsecsElapsed();
-        event.getProfilingInfo(CL_PROFILING_COMMAND_START, &time_start);
-        event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
+        {
+            TraceSpan span("download", "opencl");
+            read(m_bufferTriangles, triangles.data(), m_bytesTriangles, "triangles");
+        }
+        reportProgress("DBT_F", triangles.size(), triangles.size());
 
-        qInfo() << "___";
-        qInfo() << "(OCL) DBT_A :" << (time_end - time_start) << "nanoseconds";
-        qInfo() << "(OCL) DBT_F :" << elapsed << "nanoseconds";
+        // Get times and counts
+        timer.stop();
+        if (m_metrics.isEnabled())
+        {
+            event.getProfilingInfo(CL_PROFILING_COMMAND_START, &time_start);
+            event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
+            m_metrics.addTime("DBT_A", static_cast<long long>(time_end - time_start));
+            collectCommands();
+
+            unsigned long badCount(0);
+            for (const Triangle &t : triangles)
+            {
+                badCount += static_cast<unsigned long>(t.bad != 0);
+            }
+            m_metrics.addCount("bad_triangles", badCount);
+        }
     }
     catch (cl::Error &err)
     {
@@ -86,21 +139,29 @@ bool OpenCLEngine::detectBadTriangles(float angle,
     return true;
 }
 
-bool OpenCLEngine::improveTriangulation(std::vector<Vertex> &vertices,
-                                        std::vector<Edge> &edges,
-                                        std::vector<Triangle> &triangles)
+bool OpenCLEngine::improveTriangulation(MeshVector<Vertex> &vertices,
+                                        MeshVector<Edge> &edges,
+                                        MeshVector<Triangle> &triangles)
 {
     /* We'll do this in 3 phases:
      * Phase 1: Detect the terminal edges for each bad triangle.
      * Phase 2: Insert new triangle(s) at each terminal edge.
      * Phase 3: Recalculate bad triangles.
      */
+
+    // Nothing has changed yet (in case we don't reach Phase 2)
+    beginChanges(vertices, edges, triangles);
+
     try
     {
         // Phase 1
         bool nonBTERemaining = false; // Flag that shows if we still have Non-border Terminal Edges.
         detectTerminalEdges(vertices, edges, triangles, nonBTERemaining);
 
+        if (isCancelled())
+        {
+            return false;
+        }
         if (not nonBTERemaining)
         {
             return true;
@@ -109,8 +170,16 @@ bool OpenCLEngine::improveTriangulation(std::vector<Vertex> &vertices,
         // Phase 2
         insertCentroids(vertices, edges, triangles);
 
+        if (isCancelled())
+        {
+            return false;
+        }
+
         // Phase 3
-        detectBadTriangles(m_angle, vertices, triangles);
+        if (not detectBadTriangles(m_angle, vertices, triangles))
+        {
+            return false;
+        }
 
         /* NOTE: If we get a correct GPU insertion algorithm, we can do this
          * only once instead of copying back the results for each function.
@@ -130,9 +199,9 @@ bool OpenCLEngine::improveTriangulation(std::vector<Vertex> &vertices,
     return true;
 }
 
-void OpenCLEngine::detectTerminalEdges(std::vector<Vertex> &vertices,
-                                       std::vector<Edge> &edges,
-                                       std::vector<Triangle> &triangles,
+void OpenCLEngine::detectTerminalEdges(MeshVector<Vertex> &vertices,
+                                       MeshVector<Edge> &edges,
+                                       MeshVector<Triangle> &triangles,
                                        bool &flag)
 {
     /* As we're using GPU, we can use CRCW in this particular situation,
@@ -148,27 +217,47 @@ void OpenCLEngine::detectTerminalEdges(std::vector<Vertex> &vertices,
      * bad triangles are terminals.
      */
 
-    QElapsedTimer timer;
-    timer.start();
+    ScopedTimer timer(m_metrics, "DTE_F");
 
     cl_ulong time_start(0);
     cl_ulong time_end(0);
 
-    // Create the memory buffers (Implicit copy to buffers when using iterators)
-    const bool USE_HOST_PTR(true);
-
     // Detect number of threads
     unsigned long globalSize(triangles.size());
 
-    // true == CL_MEM_READ_ONLY / false == CL_MEM_READ_WRITE
-    m_bufferTriangles = cl::Buffer(m_context, triangles.begin(), triangles.end(), false, USE_HOST_PTR);
-    m_bufferVertices = cl::Buffer(m_context, vertices.begin(), vertices.end(), false, USE_HOST_PTR);
-    m_bufferEdges = cl::Buffer(m_context, edges.begin(), edges.end(), false, USE_HOST_PTR);
-
     // Hack to allow flag to be modified by kernel
     std::vector<int> flagVector;
     flagVector.push_back(flag);
-    cl::Buffer bufferFlag(m_context, flagVector.begin(), flagVector.end(), false, USE_HOST_PTR);
+    cl::Buffer bufferFlag;
+
+    // Lengths of the Lepps (0 for good triangles), only while collecting metrics
+    int countSteps(m_metrics.isEnabled() ? 1 : 0);
+    std::vector<cl_uint> stepsVector(countSteps ? globalSize : 1, 0);
+    cl::Buffer bufferSteps;
+
+    // Edges marked before this round, so only the new ones are counted (as CPUEngine does)
+    std::vector<bool> wasTerminal;
+    if (countSteps)
+    {
+        wasTerminal.reserve(edges.size());
+        for (const Edge &e : edges)
+        {
+            wasTerminal.push_back(e.isTE != 0);
+        }
+    }
+
+    // Create the memory buffers, with explicit copies so they can be profiled
+    {
+        TraceSpan span("upload", "opencl");
+        m_bytesTriangles = triangles.size() * sizeof(Triangle);
+        m_bufferTriangles = write(triangles.data(), m_bytesTriangles, "triangles");
+        m_bytesVertices = vertices.size() * sizeof(Vertex);
+        m_bufferVertices = write(vertices.data(), m_bytesVertices, "vertices");
+        m_bytesEdges = edges.size() * sizeof(Edge);
+        m_bufferEdges = write(edges.data(), m_bytesEdges, "edges");
+        bufferFlag = write(flagVector.data(), flagVector.size() * sizeof(int), "flag");
+        bufferSteps = write(stepsVector.data(), stepsVector.size() * sizeof(cl_uint), "steps");
+    }
 
     // Set dimensions
     cl::NDRange global(globalSize);
@@ -176,51 +265,205 @@ void OpenCLEngine::detectTerminalEdges(std::vector<Vertex> &vertices,
     cl::EnqueueArgs eargs(m_queue, global/*, local*/);
 
     // Make kernel
-    cl::make_kernel<cl::Buffer&, cl::Buffer&, cl::Buffer&, cl::Buffer&> detect_terminal_edges_kernel(m_program, "detectTerminalEdges");
+    cl::make_kernel<cl::Buffer&, cl::Buffer&, cl::Buffer&, cl::Buffer&, cl::Buffer&, int&> detect_terminal_edges_kernel(m_program, "detectTerminalEdges");
 
     // Execute the kernel
-    cl::Event event = detect_terminal_edges_kernel(eargs, m_bufferTriangles, m_bufferVertices, m_bufferEdges, bufferFlag);
-    event.wait();
+    long long enqueued = Tracer::getInstance().now();
+    cl::Event event = detect_terminal_edges_kernel(eargs, m_bufferTriangles, m_bufferVertices, m_bufferEdges, bufferFlag, bufferSteps, countSteps);
+    {
+        TraceSpan span("wait", "opencl");
+        event.wait();
+    }
+    traceEvent(event, enqueued, "detectTerminalEdges");
+    profile(event, DeviceCommand::Kernel, "detectTerminalEdges", 0);
 
     // Copy the modified edges and the flag back to CPU
-    cl::copy(m_queue, m_bufferEdges, edges.begin(), edges.end());
-    cl::copy(m_queue, bufferFlag, flagVector.begin(), flagVector.end());
+    {
+        TraceSpan span("download", "opencl");
+        read(m_bufferEdges, edges.data(), m_bytesEdges, "edges");
+        read(bufferFlag, flagVector.data(), flagVector.size() * sizeof(int), "flag");
+        if (countSteps)
+        {
+            read(bufferSteps, stepsVector.data(), stepsVector.size() * sizeof(cl_uint), "steps");
+        }
+    }
     flag = (flagVector.at(0) != 0);
+    reportProgress("DTE_F", triangles.size(), triangles.size());
 
-    // Get times
-    qint64 elapsed = timer.nsecsElapsed();
-    event.getProfilingInfo(CL_PROFILING_COMMAND_START, &time_start);
-    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
+    // Get times and counts
+    timer.stop();
+    if (m_metrics.isEnabled())
+    {
+        event.getProfilingInfo(CL_PROFILING_COMMAND_START, &time_start);
+        event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
+        m_metrics.addTime("DTE_A", static_cast<long long>(time_end - time_start));
+        collectCommands();
 
-    qInfo() << "(OCL) DTE_A :" << (time_end - time_start) << "nanoseconds";
-    qInfo() << "(OCL) DTE_F :" << elapsed << "nanoseconds";
+        unsigned long terminalCount(0);
+        for (unsigned long i(0); i < wasTerminal.size(); i++)
+        {
+            terminalCount += static_cast<unsigned long>(edges[i].isTE != 0 and not wasTerminal[i]);
+        }
+        m_metrics.addCount("terminal_edges", terminalCount);
+
+        Histogram walks;
+        for (cl_uint steps : stepsVector)
+        {
+            if (steps > 0)
+            {
+                walks.add(steps);
+            }
+        }
+        m_metrics.addSamples("lepp_steps", walks);
+    }
 }
 
-void OpenCLEngine::insertCentroids(std::vector<Vertex> &vertices,
-                                   std::vector<Edge> &edges,
-                                   std::vector<Triangle> &triangles)
+void OpenCLEngine::insertCentroids(MeshVector<Vertex> &vertices,
+                                   MeshVector<Edge> &edges,
+                                   MeshVector<Triangle> &triangles)
 {
     /* At the moment we'll use a mixed approach.
      * Timing will be done in CPUEngine.
      */
     CPUEngine cpuengine; // Temporarily we'll use this for centroid insertion
+    cpuengine.getMetrics().setEnabled(m_metrics.isEnabled());
+    cpuengine.getMetrics().setHardwareCountersEnabled(m_metrics.hasHardwareCounters());
+    cpuengine.setCancellationToken(m_cancellation);
+    cpuengine.setProgressCallback(m_progress);
     cpuengine.insertCentroids(vertices, edges, triangles);
+    m_changes = cpuengine.getChanges();
+    m_metrics.merge(cpuengine.getMetrics());
 
     // To avoid inconsistencies, we'll update edge information to buffers in GPU
-    const bool USE_HOST_PTR = true;
-    m_bufferEdges = cl::Buffer(m_context, edges.begin(), edges.end(), false, USE_HOST_PTR);
+    TraceSpan span("upload", "opencl");
+    m_bytesEdges = edges.size() * sizeof(Edge);
+    m_bufferEdges = write(edges.data(), m_bytesEdges, "edges");
+    collectCommands();
+}
+
+cl::Buffer OpenCLEngine::write(const void *data, std::size_t bytes, const char *name)
+{
+    cl::Buffer buffer;
+    {
+        ScopedTimer timer(m_metrics, "ALLOC_F", "opencl");
+        buffer = cl::Buffer(m_context, CL_MEM_READ_WRITE, std::max<std::size_t>(bytes, 1));
+    }
+
+    /* Blocking, so the host vectors can grow (and move) right after it. The
+     * kernels wait for their inputs anyway, so nothing runs later than before.
+     */
+    if (bytes > 0)
+    {
+        cl::Event event;
+        m_queue.enqueueWriteBuffer(buffer, CL_TRUE, 0, bytes, data, nullptr, &event);
+        profile(event, DeviceCommand::Write, name, bytes);
+    }
+    return buffer;
+}
+
+void OpenCLEngine::read(const cl::Buffer &buffer, void *data, std::size_t bytes, const char *name)
+{
+    if (bytes > 0)
+    {
+        cl::Event event;
+        m_queue.enqueueReadBuffer(buffer, CL_TRUE, 0, bytes, data, nullptr, &event);
+        profile(event, DeviceCommand::Read, name, bytes);
+    }
+}
+
+void OpenCLEngine::profile(const cl::Event &event,
+                           DeviceCommand::Kind kind,
+                           const char *name,
+                           unsigned long long bytes)
+{
+    if (not m_metrics.isEnabled())
+    {
+        return;
+    }
+    DeviceCommand command;
+    command.name = name;
+    command.kind = kind;
+    command.bytes = bytes;
+    m_pending.push_back(std::make_pair(event, command));
+}
+
+void OpenCLEngine::collectCommands()
+{
+    for (std::pair<cl::Event, DeviceCommand> &pending : m_pending)
+    {
+        // Profiling information is only available once the command is complete
+        pending.first.wait();
+
+        DeviceCommand &command(pending.second);
+        cl_ulong queued(0), submit(0), start(0), end(0);
+        pending.first.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &queued);
+        pending.first.getProfilingInfo(CL_PROFILING_COMMAND_SUBMIT, &submit);
+        pending.first.getProfilingInfo(CL_PROFILING_COMMAND_START, &start);
+        pending.first.getProfilingInfo(CL_PROFILING_COMMAND_END, &end);
+        command.queued = queued;
+        command.submit = submit;
+        command.start = start;
+        command.end = end;
+        m_metrics.addCommand(command);
+
+        // Totals of the transfers, next to the kernel times (DBT_A and DTE_A)
+        if (command.kind == DeviceCommand::Write)
+        {
+            m_metrics.addTime("WRITE_A", command.duration());
+            m_metrics.addCount("bytes_written", command.bytes);
+        }
+        else if (command.kind == DeviceCommand::Read)
+        {
+            m_metrics.addTime("READ_A", command.duration());
+            m_metrics.addCount("bytes_read", command.bytes);
+        }
+    }
+    m_pending.clear();
+}
+
+void OpenCLEngine::traceEvent(const cl::Event &event, long long enqueued, const char *name)
+{
+    Tracer &tracer(Tracer::getInstance());
+    if (not tracer.isEnabled())
+    {
+        return;
+    }
+
+    /* The device has its own clock, so its times are placed relative to the
+     * moment the host enqueued the command.
+     */
+    cl_ulong queued(0), start(0), end(0);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &queued);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_START, &start);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &end);
+    tracer.addSpan(Tracer::DEVICE_TRACK, name, "opencl",
+                   enqueued + static_cast<long long>(start - queued),
+                   enqueued + static_cast<long long>(end - queued));
 }
 
-void OpenCLEngine::setup()
+void OpenCLEngine::setup(unsigned long platform_id, unsigned long device_id)
 {
     qDebug() << "Executing OpenCLEngine::setup";
+
+    // The first engine of a platform builds the program, and the next ones reuse it
+    std::lock_guard<std::mutex> lock(programsMutex);
+    std::shared_ptr<PlatformProgram> &shared(programs[platform_id]);
+    if (shared)
+    {
+        m_platforms = shared->platforms;
+        m_devices = shared->devices;
+        m_context = shared->context;
+        m_program = shared->program;
+
+        // Each engine has its own queue (and buffers), so engines don't wait for each other
+        m_queue = cl::CommandQueue(m_context, m_devices.at(device_id), CL_QUEUE_PROFILING_ENABLE);
+        return;
+    }
+
     try
     {
         // Platform = Vendor (Intel, Nvidia, AMD, etc).
-        unsigned long platform_id(0);
-
-        // Device = Card identifier. If you have only one graphic card from a vendor, leave this at 0.
-        unsigned long device_id(0);
+        // Device = Card identifier. If you have only one graphic card from a vendor, use 0.
 
         // Query for platforms
         cl::Platform::get(&m_platforms);
@@ -257,6 +500,12 @@ void OpenCLEngine::setup()
 
         // Build the program for the devices
         m_program.build(m_devices);
+
+        shared = std::make_shared<PlatformProgram>();
+        shared->platforms = m_platforms;
+        shared->devices = m_devices;
+        shared->context = m_context;
+        shared->program = m_program;
     }
     catch (cl::Error &e)
     {
@@ -357,3 +606,17 @@ std::vector<std::string> OpenCLEngine::getOpenCLData(unsigned long platform_id,
 
     return vec;
 }
+
+std::vector<DeviceMemory> OpenCLEngine::getDeviceMemory() const
+{
+    DeviceMemory memory;
+    if (m_deviceId < m_devices.size())
+    {
+        cl_ulong capacity(0);
+        m_devices.at(m_deviceId).getInfo(CL_DEVICE_NAME, &memory.device);
+        m_devices.at(m_deviceId).getInfo(CL_DEVICE_GLOBAL_MEM_SIZE, &capacity);
+        memory.capacity = capacity;
+    }
+    memory.bytes = m_bytesVertices + m_bytesEdges + m_bytesTriangles;
+    return std::vector<DeviceMemory>(1, memory);
+}
@@ -27,7 +27,11 @@
 # include <CL/cl.hpp>
 #endif
 
+#include <utility>
+#include <vector>
+
 #include <engine/engine.h>
+#include <metrics/devicecommand.h>
 
 /**
  * @brief OpenCL Implementation of the Engine.
@@ -39,8 +43,10 @@ public:
     /**
      * @brief OpenCLEngine constructor.
      *
+     * @param platform_id p_platform_id: Index of the OpenCL platform (vendor).
+     * @param device_id p_device_id: Index of the device in that platform.
      */
-    OpenCLEngine();
+    OpenCLEngine(unsigned long platform_id = 0, unsigned long device_id = 0);
 
     /**
      * @brief Detects every bad triangle in the vector of triangles. Overriden method.
@@ -51,8 +57,8 @@ public:
      * @return True if detected without issues.
      */
     virtual bool detectBadTriangles(float angle,
-                                    std::vector<Vertex> &vertices,
-                                    std::vector<Triangle> &triangles) override;
+                                    MeshVector<Vertex> &vertices,
+                                    MeshVector<Triangle> &triangles) override;
 
     /**
      * @brief Improves the actual triangulation from the vector of triangles. Overridden method.
@@ -62,9 +68,9 @@ public:
      * @param triangles p_triangles: Vector of triangles.
      * @return True if improved without issues.
      */
-    virtual bool improveTriangulation(std::vector<Vertex> &vertices,
-                                      std::vector<Edge> &edges,
-                                      std::vector<Triangle> &triangles) override;
+    virtual bool improveTriangulation(MeshVector<Vertex> &vertices,
+                                      MeshVector<Edge> &edges,
+                                      MeshVector<Triangle> &triangles) override;
 
     /**
      * @brief Detects terminal edges for each bad triangle in the "triangles"
@@ -76,9 +82,9 @@ public:
      * @param flag p_flag: Flag that marks if a non-border terminal edge still
      * exists.
      */
-    virtual void detectTerminalEdges(std::vector<Vertex> &vertices,
-                                     std::vector<Edge> &edges,
-                                     std::vector<Triangle> &triangles,
+    virtual void detectTerminalEdges(MeshVector<Vertex> &vertices,
+                                     MeshVector<Edge> &edges,
+                                     MeshVector<Triangle> &triangles,
                                      bool &flag) override;
 
     /**
@@ -88,16 +94,26 @@ public:
      * @param edges p_edges: Vector of edges.
      * @param triangles p_triangles: Vector of triangles.
      */
-    virtual void insertCentroids(std::vector<Vertex> &vertices,
-                                 std::vector<Edge> &edges,
-                                 std::vector<Triangle> &triangles) override;
+    virtual void insertCentroids(MeshVector<Vertex> &vertices,
+                                 MeshVector<Edge> &edges,
+                                 MeshVector<Triangle> &triangles) override;
+
+    /**
+     * @brief Gets the memory of the vertex, edge and triangle buffers in the
+     * device of the queue.
+     *
+     * @return The device of the engine.
+     */
+    std::vector<DeviceMemory> getDeviceMemory() const override;
 
 protected:
     /**
      * @brief Convenience method that sets variables up before work.
      *
+     * @param platform_id p_platform_id: Index of the OpenCL platform (vendor).
+     * @param device_id p_device_id: Index of the device in that platform.
      */
-    void setup();
+    void setup(unsigned long platform_id, unsigned long device_id);
 
     /**
      * @brief Retrieves data from the current OpenCL Implementation.
@@ -108,6 +124,54 @@ protected:
     std::vector<std::string> getOpenCLData(unsigned long platform_id,
                                            unsigned long device_id) const;
 
+    /**
+     * @brief Adds the execution of a command on the device to the trace.
+     *
+     * @param event p_event: Finished event of the command.
+     * @param enqueued p_enqueued: Time of the trace when it was enqueued.
+     * @param name p_name: Name of the span. Must be a string literal.
+     */
+    void traceEvent(const cl::Event &event, long long enqueued, const char *name);
+
+    /**
+     * @brief Creates a device buffer and copies host data to it.
+     *
+     * @param data p_data: Host data.
+     * @param bytes p_bytes: Size of the data.
+     * @param name p_name: Name of the transfer in the metrics. Must be a string literal.
+     * @return The buffer.
+     */
+    cl::Buffer write(const void *data, std::size_t bytes, const char *name);
+
+    /**
+     * @brief Copies a device buffer to the host. Blocks until it's done.
+     *
+     * @param buffer p_buffer: Device buffer.
+     * @param data p_data: Host destination.
+     * @param bytes p_bytes: Size of the data.
+     * @param name p_name: Name of the transfer in the metrics. Must be a string literal.
+     */
+    void read(const cl::Buffer &buffer, void *data, std::size_t bytes, const char *name);
+
+    /**
+     * @brief Keeps a command to be profiled by collectCommands(), while
+     * collecting metrics.
+     *
+     * @param event p_event: Event of the command.
+     * @param kind p_kind: Kind of the command.
+     * @param name p_name: Name of the command.
+     * @param bytes p_bytes: Transferred bytes. 0 for kernels.
+     */
+    void profile(const cl::Event &event, DeviceCommand::Kind kind, const char *name, unsigned long long bytes);
+
+    /**
+     * @brief Waits for the kept commands and adds their queued, submit, start
+     * and end times to the metrics, plus the totals of the transfers
+     * (WRITE_A, READ_A, bytes_written and bytes_read).
+     *
+     */
+    void collectCommands();
+
 private:
     std::vector<cl::Platform> m_platforms;
     std::vector<cl::Device> m_devices;
@@ -118,6 +182,13 @@ private:
     cl::Buffer m_bufferVertices;
     cl::Buffer m_bufferEdges;
     cl::Buffer m_bufferTriangles;
+
+    unsigned long m_deviceId;
+    unsigned long long m_bytesVertices;
+    unsigned long long m_bytesEdges;
+    unsigned long long m_bytesTriangles;
+
+    std::vector<std::pair<cl::Event, DeviceCommand>> m_pending;
 };
 
 #endif // OPENCLENGINE_H
@@ -0,0 +1,94 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Progress of a phase of the engine, or of a file load.
+ *
+ * Phases are named like their timers (DBT_F, DTE_F and IC_F), and count
+ * triangles (DBT_F, DTE_F) or edges (IC_F). "total" may grow during IC_F, as
+ * each insertion adds new edges.
+ * Loads count the vertices (LOAD_V) and triangles (LOAD_T) read, and the
+ * triangles linked to their edges (LOAD_E). "total" is 0 when unknown
+ * (e.g. the points of an XYZ file).
+ *
+ */
+struct Progress
+{
+    std::string phase;
+    unsigned long processed = 0;
+    unsigned long total = 0;
+};
+
+/**
+ * @brief Receives the progress of the engine. It may be called from the
+ * worker threads of the engine (never concurrently), so it should only store
+ * or forward the progress.
+ *
+ */
+typedef std::function<void(const Progress &progress)> ProgressCallback;
+
+/**
+ * @brief Shared flag that asks an engine to stop.
+ *
+ * Copies share the same flag, so the caller keeps a copy and cancels it from
+ * any thread. Engines check it between chunks of work, and always leave the
+ * mesh consistent (although bad triangles may need to be detected again).
+ *
+ */
+class CancellationToken
+{
+public:
+    /**
+     * @brief Creates a new, non-cancelled flag.
+     *
+     */
+    CancellationToken();
+
+    /**
+     * @brief Asks every holder of the flag to stop.
+     *
+     */
+    void cancel();
+
+    /**
+     * @brief Clears the flag, so it can be used again.
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Checks the flag.
+     *
+     * @return True if it has been cancelled.
+     */
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+#endif // PROGRESS_H
@@ -0,0 +1,60 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <filehandlers/filehandler.h>
+
+void FileHandler::setProgressCallback(ProgressCallback callback)
+{
+    m_progress = callback;
+}
+
+void FileHandler::setCancellationToken(CancellationToken token)
+{
+    m_cancellation = token;
+}
+
+void FileHandler::setChunkCallback(ChunkCallback callback)
+{
+    m_chunks = callback;
+}
+
+bool FileHandler::isCancelled() const
+{
+    return m_cancellation.isCancelled();
+}
+
+void FileHandler::reportProgress(const char *phase, unsigned long processed, unsigned long total)
+{
+    if (m_progress)
+    {
+        Progress progress;
+        progress.phase = phase;
+        progress.processed = processed;
+        progress.total = total;
+        m_progress(progress);
+    }
+}
+
+void FileHandler::reportChunk(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles)
+{
+    if (m_chunks)
+    {
+        m_chunks(vertices, triangles);
+    }
+}
@@ -20,12 +20,25 @@
 #ifndef FILEHANDLER_H
 #define FILEHANDLER_H
 
+#include <functional>
 #include <string>
 #include <vector>
 
+#include <engine/progress.h>
 #include <structs/triangle.h>
 #include <structs/vertex.h>
 #include <structs/edge.h>
+#include <structs/meshvector.h>
+
+/**
+ * @brief Receives the vertices and triangles parsed so far, while a file is
+ * being loaded (before its edges are built). It's called from the loading
+ * thread, and the vectors only grow between calls, so it can copy the new
+ * elements to show a partial mesh.
+ *
+ */
+typedef std::function<void(const MeshVector<Vertex> &vertices,
+                           const MeshVector<Triangle> &triangles)> ChunkCallback;
 
 /**
 * @brief Interface for files handling module.
@@ -57,9 +70,9 @@ public:
     * @return True if correctly loaded.
     */
     virtual bool load(std::string filepath,
-                      std::vector<Vertex> &vertices,
-                      std::vector<Edge> &edges,
-                      std::vector<Triangle> &triangles) = 0;
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles) = 0;
 
     /**
     * @brief Method that saves an OFF file according to the actual parameters.
@@ -71,9 +84,73 @@ public:
     * @return True if correctly saved.
     */
     virtual bool save(std::string filepath,
-                      std::vector<Vertex> &vertices,
-                      std::vector<Edge> &edges,
-                      std::vector<Triangle> &triangles) = 0;
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles) = 0;
+
+    /**
+    * @brief Gets an estimate of the temporary heap memory of the last load,
+    * at its peak, besides the vectors themselves.
+    *
+    * @return Bytes. 0 if the handler doesn't estimate them.
+    */
+    virtual unsigned long long getTransientBytes() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Sets the function that receives the progress of the next loads
+     * (phases LOAD_V, LOAD_T and LOAD_E). An empty function disables the reports.
+     *
+     * @param callback p_callback: Receiver of the progress.
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Sets the token that stops the next loads. A cancelled load
+     * returns false.
+     *
+     * @param token p_token: Cancellation token.
+     */
+    void setCancellationToken(CancellationToken token);
+
+    /**
+     * @brief Sets the function that receives the partial mesh of the next
+     * loads. An empty function disables it.
+     *
+     * @param callback p_callback: Receiver of the chunks.
+     */
+    void setChunkCallback(ChunkCallback callback);
+
+protected:
+    /**
+     * @brief Checks the cancellation token. Handlers call it between chunks of lines.
+     *
+     * @return True if the load must stop.
+     */
+    bool isCancelled() const;
+
+    /**
+     * @brief Sends the progress of a phase to the callback, if there's one.
+     *
+     * @param phase p_phase: Name of the phase.
+     * @param processed p_processed: Elements processed so far.
+     * @param total p_total: Elements of the phase (0 if unknown).
+     */
+    void reportProgress(const char *phase, unsigned long processed, unsigned long total);
+
+    /**
+     * @brief Sends the partial mesh to the chunk callback, if there's one.
+     *
+     * @param vertices p_vertices: Vertices parsed so far.
+     * @param triangles p_triangles: Triangles parsed so far.
+     */
+    void reportChunk(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles);
+
+    ProgressCallback m_progress;
+    CancellationToken m_cancellation;
+    ChunkCallback m_chunks;
 };
 
 #endif // FILEHANDLER_H
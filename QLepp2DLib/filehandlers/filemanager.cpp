@@ -17,14 +17,32 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 
 #include <filehandlers/filemanager.h>
 #include <filehandlers/offhandler.h>
+#include <filehandlers/xyzhandler.h>
+#include <filehandlers/rawio.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+
+namespace
+{
+    const quint32 CACHE_MAGIC(0x514c4331);      // "QLC1"
+}
 
 FileManager::FileManager()
+    : m_cacheEnabled(false),
+      m_transientBytes(0)
 {
     addFileHandler(new OFFHandler, "off");
+    addFileHandler(new XYZHandler, "xyz");
 }
 
 FileManager::~FileManager()
@@ -46,25 +64,278 @@ bool FileManager::addFileHandler(FileHandler *handler, std::string extension)
 }
 
 bool FileManager::load(std::string filepath,
-                       std::vector<Vertex> &vertices,
-                       std::vector<Edge> &edges,
-                       std::vector<Triangle> &triangles)
+                       MeshVector<Vertex> &vertices,
+                       MeshVector<Edge> &edges,
+                       MeshVector<Triangle> &triangles)
 {
-    QFileInfo fileinfo(QString::fromStdString(filepath));
-    QString ext = fileinfo.suffix();
+    TraceSpan span("load", "io");
+    AllocationScope allocations("load");
+    FileHandler *handler = m_handlers.value(extension(filepath));
+    if (handler == nullptr)
+    {
+        return false;
+    }
+    m_transientBytes = 0;
+
+    // The standard input can't be hashed or read twice, so it's never cached.
+    bool cacheable = (m_cacheEnabled and filepath != "-");
 
-    FileHandler *handler = m_handlers.value(ext);
-    return (handler != nullptr and handler->load(filepath, vertices, edges, triangles));
+    QString qfilepath(QString::fromStdString(filepath));
+    QByteArray hash;
+    if (cacheable)
+    {
+        TraceSpan cacheSpan("loadCache", "io");
+        if (loadCache(qfilepath, vertices, edges, triangles, hash))
+        {
+            reportCachedLoad(vertices, triangles);
+            return true;
+        }
+    }
+
+    if (not handler->load(filepath, vertices, edges, triangles))
+    {
+        return false;
+    }
+    m_transientBytes = handler->getTransientBytes();
+
+    // A failed cache only costs the next load, so it doesn't fail this one.
+    if (cacheable)
+    {
+        TraceSpan cacheSpan("saveCache", "io");
+        saveCache(qfilepath, vertices, edges, triangles, hash);
+    }
+    return true;
 }
 
 bool FileManager::save(std::string filepath,
-                       std::vector<Vertex> &vertices,
-                       std::vector<Edge> &edges,
-                       std::vector<Triangle> &triangles)
+                       MeshVector<Vertex> &vertices,
+                       MeshVector<Edge> &edges,
+                       MeshVector<Triangle> &triangles)
 {
-    QFileInfo fileinfo(QString::fromStdString(filepath));
-    QString ext = fileinfo.suffix();
-
-    FileHandler *handler = m_handlers.value(ext);
+    TraceSpan span("save", "io");
+    AllocationScope allocations("save");
+    FileHandler *handler = m_handlers.value(extension(filepath));
     return (handler != nullptr and handler->save(filepath, vertices, edges, triangles));
 }
+
+unsigned long long FileManager::getTransientBytes() const
+{
+    return m_transientBytes;
+}
+
+void FileManager::setCacheEnabled(bool enabled)
+{
+    m_cacheEnabled = enabled;
+}
+
+void FileManager::setProgressCallback(ProgressCallback callback)
+{
+    m_progress = callback;
+    for (FileHandler *handler : m_handlers)
+    {
+        handler->setProgressCallback(callback);
+    }
+}
+
+void FileManager::setCancellationToken(CancellationToken token)
+{
+    for (FileHandler *handler : m_handlers)
+    {
+        handler->setCancellationToken(token);
+    }
+}
+
+void FileManager::setChunkCallback(ChunkCallback callback)
+{
+    m_chunks = callback;
+    for (FileHandler *handler : m_handlers)
+    {
+        handler->setChunkCallback(callback);
+    }
+}
+
+bool FileManager::purgeCache(std::string filepath)
+{
+    QFile sidecar(cachePath(QString::fromStdString(filepath)));
+    return (not sidecar.exists() or sidecar.remove());
+}
+
+bool FileManager::loadCache(QString filepath,
+                            MeshVector<Vertex> &vertices,
+                            MeshVector<Edge> &edges,
+                            MeshVector<Triangle> &triangles,
+                            QByteArray &hash)
+{
+    QFile sidecar(cachePath(filepath));
+    if (not sidecar.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&sidecar);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, vertexSize, edgeSize, triangleSize;
+    qint64 size, mtime;
+    QByteArray cachedHash;
+    quint64 numVertices, numEdges, numTriangles;
+
+    in >> magic >> vertexSize >> edgeSize >> triangleSize;
+    in >> size >> mtime >> cachedHash;
+    in >> numVertices >> numEdges >> numTriangles;
+
+    if (in.status() != QDataStream::Ok or magic != CACHE_MAGIC or
+        vertexSize != sizeof(Vertex) or edgeSize != sizeof(Edge) or triangleSize != sizeof(Triangle))
+    {
+        return false;
+    }
+
+    // The counts must describe exactly the rest of the sidecar; anything else is a damaged cache.
+    quint64 remaining(static_cast<quint64>(sidecar.size() - sidecar.pos()));
+    if (numVertices > remaining / sizeof(Vertex) or
+        numEdges > remaining / sizeof(Edge) or
+        numTriangles > remaining / sizeof(Triangle) or
+        numVertices * sizeof(Vertex) + numEdges * sizeof(Edge) + numTriangles * sizeof(Triangle) != remaining)
+    {
+        qWarning() << "Damaged cache for" << filepath;
+        return false;
+    }
+
+    // Cheap checks first, then the content itself (kept for saveCache if it doesn't match).
+    QFileInfo fileinfo(filepath);
+    if (size != fileinfo.size() or mtime != fileinfo.lastModified().toMSecsSinceEpoch())
+    {
+        qDebug() << "Stale cache for" << filepath;
+        return false;
+    }
+    hash = contentHash(filepath);
+    if (hash != cachedHash)
+    {
+        qDebug() << "Stale cache for" << filepath;
+        return false;
+    }
+
+    // Same storage as the vectors they replace
+    MeshVector<Vertex> cachedVertices(vertices.get_allocator());
+    MeshVector<Edge> cachedEdges(edges.get_allocator());
+    MeshVector<Triangle> cachedTriangles(triangles.get_allocator());
+
+    if (not (RawIO::read(in, cachedVertices, numVertices) and
+             RawIO::read(in, cachedEdges, numEdges) and
+             RawIO::read(in, cachedTriangles, numTriangles)))
+    {
+        qWarning() << "Truncated cache for" << filepath;
+        return false;
+    }
+
+    vertices.swap(cachedVertices);
+    edges.swap(cachedEdges);
+    triangles.swap(cachedTriangles);
+
+    qInfo() << "Cached Vertices  :" << numVertices;
+    qInfo() << "Cached Edges     :" << numEdges;
+    qInfo() << "Cached Triangles :" << numTriangles;
+
+    return true;
+}
+
+bool FileManager::saveCache(QString filepath,
+                            MeshVector<Vertex> &vertices,
+                            MeshVector<Edge> &edges,
+                            MeshVector<Triangle> &triangles,
+                            QByteArray hash)
+{
+    if (hash.isEmpty())
+    {
+        hash = contentHash(filepath);
+    }
+    if (hash.isEmpty())
+    {
+        return false;
+    }
+
+    // QSaveFile replaces the old sidecar only when the new one is complete.
+    QSaveFile sidecar(cachePath(filepath));
+    if (not sidecar.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Could not create cache for" << filepath;
+        return false;
+    }
+
+    QDataStream out(&sidecar);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    QFileInfo fileinfo(filepath);
+    out << CACHE_MAGIC;
+    out << static_cast<quint32>(sizeof(Vertex));
+    out << static_cast<quint32>(sizeof(Edge));
+    out << static_cast<quint32>(sizeof(Triangle));
+    out << fileinfo.size();
+    out << fileinfo.lastModified().toMSecsSinceEpoch();
+    out << hash;
+    out << static_cast<quint64>(vertices.size());
+    out << static_cast<quint64>(edges.size());
+    out << static_cast<quint64>(triangles.size());
+
+    RawIO::write(out, vertices.data(), vertices.size());
+    RawIO::write(out, edges.data(), edges.size());
+    RawIO::write(out, triangles.data(), triangles.size());
+
+    return (out.status() == QDataStream::Ok and sidecar.commit());
+}
+
+void FileManager::reportCachedLoad(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles)
+{
+    if (m_progress)
+    {
+        Progress progress;
+        progress.phase = "LOAD_T";
+        progress.processed = triangles.size();
+        progress.total = triangles.size();
+        m_progress(progress);
+    }
+    if (m_chunks)
+    {
+        m_chunks(vertices, triangles);
+    }
+    if (m_progress)
+    {
+        Progress progress;
+        progress.phase = "LOAD_E";
+        progress.processed = triangles.size();
+        progress.total = triangles.size();
+        m_progress(progress);
+    }
+}
+
+QString FileManager::extension(std::string filepath) const
+{
+    // The standard streams carry OFF meshes
+    if (filepath == "-")
+    {
+        return "off";
+    }
+    return QFileInfo(QString::fromStdString(filepath)).suffix();
+}
+
+QString FileManager::cachePath(QString filepath) const
+{
+    return filepath + ".qlcache";
+}
+
+QByteArray FileManager::contentHash(QString filepath) const
+{
+    QFile file(filepath);
+    if (not file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    // Not used for security, only to detect modified files.
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (not hash.addData(&file))
+    {
+        return QByteArray();
+    }
+    return hash.result();
+}
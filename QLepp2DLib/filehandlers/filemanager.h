@@ -20,6 +20,7 @@
 #ifndef FILEMANAGER_H
 #define FILEMANAGER_H
 
+#include <QByteArray>
 #include <QMap>
 #include <QString>
 
@@ -31,6 +32,7 @@
 #include <structs/triangle.h>
 #include <structs/vertex.h>
 #include <structs/edge.h>
+#include <structs/meshvector.h>
 
 /**
 * @brief Factory class for the file managing module.
@@ -70,9 +72,9 @@ public:
     * @return True if correctly loaded.
     */
     bool load(std::string filepath,
-              std::vector<Vertex> &vertices,
-              std::vector<Edge> &edges,
-              std::vector<Triangle> &triangles);
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles);
 
     /**
     * @brief Method that calls a FileHandler to save a mesh file.
@@ -84,12 +86,116 @@ public:
     * @return True if correctly saved.
     */
     bool save(std::string filepath,
-              std::vector<Vertex> &vertices,
-              std::vector<Edge> &edges,
-              std::vector<Triangle> &triangles);
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles);
+
+    /**
+    * @brief Enables or disables the topology cache. When enabled, the parsed
+    * vertices, triangles and built edges of each loaded file are stored in a
+    * binary sidecar file (same path plus ".qlcache"), and the next loads of
+    * the unchanged file are read from there.
+    *
+    * @param enabled p_enabled: True to use the cache.
+    */
+    void setCacheEnabled(bool enabled);
+
+    /**
+    * @brief Sets the receiver of the progress of the next loads, in every handler.
+    *
+    * @param callback p_callback: Receiver of the progress. Empty to disable it.
+    */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+    * @brief Sets the token that stops the next loads, in every handler.
+    *
+    * @param token p_token: Cancellation token.
+    */
+    void setCancellationToken(CancellationToken token);
+
+    /**
+    * @brief Sets the receiver of the partial meshes of the next loads, in
+    * every handler. Loads from the cache send the whole mesh at once.
+    *
+    * @param callback p_callback: Receiver of the chunks. Empty to disable it.
+    */
+    void setChunkCallback(ChunkCallback callback);
+
+    /**
+    * @brief Removes the sidecar cache file of a mesh file, if it exists.
+    *
+    * @param filepath p_filepath: Path of the mesh file (not the sidecar).
+    * @return True if there's no sidecar file anymore.
+    */
+    bool purgeCache(std::string filepath);
+
+    /**
+    * @brief Gets an estimate of the temporary heap memory of the last load
+    * (besides the vectors), as reported by its handler.
+    *
+    * @return Bytes. 0 for loads from the cache.
+    */
+    unsigned long long getTransientBytes() const;
 
 private:
+    /**
+    * @brief Loads the sidecar of a mesh file, only if it still matches the size,
+    * modification time and content hash of the mesh file. The content is only
+    * hashed when the size and modification time match.
+    *
+    * @param hash p_hash: Content hash of the mesh file, if it had to be computed.
+    * @return True if correctly loaded from the cache.
+    */
+    bool loadCache(QString filepath,
+                   MeshVector<Vertex> &vertices,
+                   MeshVector<Edge> &edges,
+                   MeshVector<Triangle> &triangles,
+                   QByteArray &hash);
+
+    /**
+    * @brief Stores the sidecar of a mesh file that has just been loaded.
+    *
+    * @param hash p_hash: Content hash of the mesh file. Computed if empty.
+    * @return True if correctly stored.
+    */
+    bool saveCache(QString filepath,
+                   MeshVector<Vertex> &vertices,
+                   MeshVector<Edge> &edges,
+                   MeshVector<Triangle> &triangles,
+                   QByteArray hash);
+
+    /**
+    * @brief Sends the progress and the mesh of a load from the cache, as a
+    * single chunk, so receivers see the same end of a load as with a handler.
+    *
+    */
+    void reportCachedLoad(const MeshVector<Vertex> &vertices, const MeshVector<Triangle> &triangles);
+
+    /**
+    * @brief Extension used to choose the handler of a file. "-" (standard streams) uses "off".
+    *
+    */
+    QString extension(std::string filepath) const;
+
+    /**
+    * @brief Path of the sidecar file of a mesh file.
+    *
+    */
+    QString cachePath(QString filepath) const;
+
+    /**
+    * @brief Hash of the contents of a file.
+    *
+    * @return Hash. Empty on error.
+    */
+    QByteArray contentHash(QString filepath) const;
+
     QMap<QString, FileHandler*> m_handlers;
+    bool m_cacheEnabled;
+    unsigned long long m_transientBytes;
+    ProgressCallback m_progress;
+    ChunkCallback m_chunks;
 
 };
 
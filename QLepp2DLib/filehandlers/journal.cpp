@@ -0,0 +1,357 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QtGlobal>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include <filehandlers/journal.h>
+#include <filehandlers/rawio.h>
+
+namespace
+{
+    const quint32 JOURNAL_MAGIC(0x514c4a32);    // "QLJ2"
+    const quint32 RECORD_MAGIC(0x52454331);     // "REC1"
+    const quint32 TRAILER_MAGIC(0x454e4431);    // "END1"
+
+    // QCryptographicHash only accepts int lengths, so big blocks go in pieces.
+    template <typename T>
+    void addElements(QCryptographicHash &hash, const MeshVector<T> &data)
+    {
+        const char *bytes(reinterpret_cast<const char *>(data.data()));
+        quint64 remaining(data.size() * sizeof(T));
+        while (remaining > 0)
+        {
+            int len(static_cast<int>(std::min(remaining, RawIO::CHUNK)));
+            hash.addData(bytes, len);
+            bytes += len;
+            remaining -= static_cast<quint64>(len);
+        }
+    }
+
+    /* Counts alone would accept any mesh of the same size (e.g. the same file
+     * in another element order), and the records would patch the wrong slots.
+     */
+    QByteArray meshHash(const MeshVector<Vertex> &vertices,
+                        const MeshVector<Edge> &edges,
+                        const MeshVector<Triangle> &triangles)
+    {
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        addElements(hash, vertices);
+        addElements(hash, edges);
+        addElements(hash, triangles);
+        return hash.result();
+    }
+}
+
+Journal::~Journal()
+{
+    close();
+}
+
+bool Journal::create(std::string filepath,
+                     MeshVector<Vertex> &vertices,
+                     MeshVector<Edge> &edges,
+                     MeshVector<Triangle> &triangles)
+{
+    close();
+    m_file.setFileName(QString::fromStdString(filepath));
+
+    if (not m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        qWarning() << "Could not create journal" << m_file.fileName();
+        return false;
+    }
+
+    QDataStream out(&m_file);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    // Header: the base mesh must match when replaying
+    out << JOURNAL_MAGIC;
+    out << static_cast<quint32>(sizeof(Vertex));
+    out << static_cast<quint32>(sizeof(Edge));
+    out << static_cast<quint32>(sizeof(Triangle));
+    out << static_cast<quint64>(vertices.size());
+    out << static_cast<quint64>(edges.size());
+    out << static_cast<quint64>(triangles.size());
+    out << meshHash(vertices, edges, triangles);
+
+    sync();
+    return out.status() == QDataStream::Ok;
+}
+
+int Journal::resume(std::string filepath,
+                    MeshVector<Vertex> &vertices,
+                    MeshVector<Edge> &edges,
+                    MeshVector<Triangle> &triangles,
+                    float &angle)
+{
+    close();
+    m_file.setFileName(QString::fromStdString(filepath));
+
+    if (not m_file.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "Could not open journal" << m_file.fileName();
+        return -1;
+    }
+
+    QDataStream in(&m_file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, vertexSize, edgeSize, triangleSize;
+    quint64 numVertices, numEdges, numTriangles;
+    QByteArray hash;
+    in >> magic >> vertexSize >> edgeSize >> triangleSize;
+    in >> numVertices >> numEdges >> numTriangles;
+    in >> hash;
+
+    if (in.status() != QDataStream::Ok or magic != JOURNAL_MAGIC or
+        vertexSize != sizeof(Vertex) or edgeSize != sizeof(Edge) or triangleSize != sizeof(Triangle))
+    {
+        qCritical("Not a QLepp2D journal");
+        close();
+        return -1;
+    }
+
+    if (numVertices != vertices.size() or numEdges != edges.size() or numTriangles != triangles.size() or
+        hash != meshHash(vertices, edges, triangles))
+    {
+        qCritical("The journal doesn't belong to the loaded triangulation");
+        close();
+        return -1;
+    }
+
+    // Apply every complete record, and forget a torn one after the last.
+    int records(0);
+    qint64 lastComplete(m_file.pos());
+    Status status;
+    while ((status = replayRecord(vertices, edges, triangles, angle)) == Applied)
+    {
+        records++;
+        lastComplete = m_file.pos();
+    }
+
+    // The records after a corrupt one may still be valuable, so they're kept.
+    if (status == Corrupt)
+    {
+        qCritical() << "Corrupt journal record at byte" << lastComplete;
+        close();
+        return -1;
+    }
+
+    if (lastComplete != m_file.size())
+    {
+        qWarning() << "Discarding incomplete journal record at byte" << lastComplete;
+        m_file.resize(lastComplete);
+    }
+    m_file.seek(lastComplete);
+
+    qInfo() << "Replayed records :" << records;
+
+    return records;
+}
+
+Journal::Status Journal::replayRecord(MeshVector<Vertex> &vertices,
+                           MeshVector<Edge> &edges,
+                           MeshVector<Triangle> &triangles,
+                           float &angle)
+{
+    QDataStream in(&m_file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic;
+    double recordAngle;
+    quint64 firstVertex, firstEdge, firstTriangle;
+    quint64 numVertices, numEdges, numTriangles;
+    quint64 numEdgeSlots, numTriangleSlots;
+
+    in >> magic >> recordAngle;
+    in >> firstVertex >> firstEdge >> firstTriangle;
+    in >> numVertices >> numEdges >> numTriangles;
+    in >> numEdgeSlots >> numTriangleSlots;
+
+    if (in.status() != QDataStream::Ok)
+    {
+        return Incomplete;
+    }
+
+    // Records are consecutive, so they must start where the mesh ends.
+    if (magic != RECORD_MAGIC or
+        firstVertex != vertices.size() or firstEdge != edges.size() or firstTriangle != triangles.size())
+    {
+        qCritical("Inconsistent journal record!");
+        return Corrupt;
+    }
+
+    // Read everything before touching the mesh, so incomplete records are harmless.
+    MeshVector<Vertex> newVertices;
+    MeshVector<Edge> newEdges;
+    MeshVector<Triangle> newTriangles;
+    std::vector<qint32> edgeSlots;
+    std::vector<Edge> slotEdges;
+    std::vector<qint32> triangleSlots;
+    std::vector<Triangle> slotTriangles;
+
+    quint32 trailer(0);
+    if (not (RawIO::read(in, newVertices, numVertices) and
+             RawIO::read(in, newEdges, numEdges) and
+             RawIO::read(in, newTriangles, numTriangles) and
+             RawIO::read(in, edgeSlots, numEdgeSlots) and
+             RawIO::read(in, slotEdges, numEdgeSlots) and
+             RawIO::read(in, triangleSlots, numTriangleSlots) and
+             RawIO::read(in, slotTriangles, numTriangleSlots)))
+    {
+        return Incomplete;
+    }
+
+    in >> trailer;
+    if (in.status() != QDataStream::Ok)
+    {
+        return Incomplete;
+    }
+    if (trailer != TRAILER_MAGIC)
+    {
+        qCritical("Journal record without trailer!");
+        return Corrupt;
+    }
+
+    // Only old elements are rewritten, so any other slot means a corrupt record.
+    for (qint32 ie : edgeSlots)
+    {
+        if (ie < 0 or static_cast<quint64>(ie) >= firstEdge)
+        {
+            qCritical("Journal record with an invalid edge!");
+            return Corrupt;
+        }
+    }
+    for (qint32 it : triangleSlots)
+    {
+        if (it < 0 or static_cast<quint64>(it) >= firstTriangle)
+        {
+            qCritical("Journal record with an invalid triangle!");
+            return Corrupt;
+        }
+    }
+
+    for (quint64 i(0); i < numEdgeSlots; i++)
+    {
+        edges.at(static_cast<unsigned long>(edgeSlots.at(i))) = slotEdges.at(i);
+    }
+    for (quint64 i(0); i < numTriangleSlots; i++)
+    {
+        triangles.at(static_cast<unsigned long>(triangleSlots.at(i))) = slotTriangles.at(i);
+    }
+    vertices.insert(vertices.end(), newVertices.begin(), newVertices.end());
+    edges.insert(edges.end(), newEdges.begin(), newEdges.end());
+    triangles.insert(triangles.end(), newTriangles.begin(), newTriangles.end());
+
+    angle = static_cast<float>(recordAngle);
+    return Applied;
+}
+
+bool Journal::append(float angle,
+                     const ChangeSet &changes,
+                     MeshVector<Vertex> &vertices,
+                     MeshVector<Edge> &edges,
+                     MeshVector<Triangle> &triangles)
+{
+    if (not isOpen())
+    {
+        return false;
+    }
+
+    quint64 numVertices(vertices.size() - changes.firstVertex);
+    quint64 numEdges(edges.size() - changes.firstEdge);
+    quint64 numTriangles(triangles.size() - changes.firstTriangle);
+
+    // Gather the rewritten elements (cost depends on the insertions only)
+    std::vector<qint32> edgeSlots(changes.edges.begin(), changes.edges.end());
+    std::vector<Edge> slotEdges;
+    slotEdges.reserve(edgeSlots.size());
+    for (int ie : changes.edges)
+    {
+        slotEdges.push_back(edges.at(static_cast<unsigned long>(ie)));
+    }
+
+    std::vector<qint32> triangleSlots(changes.triangles.begin(), changes.triangles.end());
+    std::vector<Triangle> slotTriangles;
+    slotTriangles.reserve(triangleSlots.size());
+    for (int it : changes.triangles)
+    {
+        slotTriangles.push_back(triangles.at(static_cast<unsigned long>(it)));
+    }
+
+    QDataStream out(&m_file);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out << RECORD_MAGIC << static_cast<double>(angle);
+    out << static_cast<quint64>(changes.firstVertex);
+    out << static_cast<quint64>(changes.firstEdge);
+    out << static_cast<quint64>(changes.firstTriangle);
+    out << numVertices << numEdges << numTriangles;
+    out << static_cast<quint64>(edgeSlots.size());
+    out << static_cast<quint64>(triangleSlots.size());
+
+    RawIO::write(out, vertices.data() + changes.firstVertex, numVertices);
+    RawIO::write(out, edges.data() + changes.firstEdge, numEdges);
+    RawIO::write(out, triangles.data() + changes.firstTriangle, numTriangles);
+    RawIO::write(out, edgeSlots.data(), edgeSlots.size());
+    RawIO::write(out, slotEdges.data(), slotEdges.size());
+    RawIO::write(out, triangleSlots.data(), triangleSlots.size());
+    RawIO::write(out, slotTriangles.data(), slotTriangles.size());
+
+    // Written last, so a record without it is known to be incomplete.
+    out << TRAILER_MAGIC;
+
+    sync();
+
+    if (out.status() != QDataStream::Ok)
+    {
+        qWarning() << "Could not write journal record to" << m_file.fileName();
+        return false;
+    }
+    return true;
+}
+
+void Journal::close()
+{
+    if (m_file.isOpen())
+    {
+        m_file.close();
+    }
+}
+
+bool Journal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void Journal::sync()
+{
+    m_file.flush();
+#ifdef Q_OS_UNIX
+    // Survive a crash of the whole node, not only of this process.
+    ::fsync(m_file.handle());
+#endif
+}
@@ -0,0 +1,156 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QFile>
+
+#include <string>
+#include <vector>
+
+#include <engine/changeset.h>
+
+#include <structs/triangle.h>
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Append-only binary journal of the improvements of a triangulation.
+*
+* The journal starts with the sizes and a hash of the base mesh, followed by one record
+* per improvement. Each record only holds the new elements and the rewritten
+* ones (see ChangeSet), so its size depends on the number of insertions,
+* not on the size of the mesh. A record is only considered complete when its
+* trailer has been written, so an interrupted run can be resumed from the
+* last complete improvement.
+*
+*/
+class Journal
+{
+public:
+    /**
+    * @brief Constructor of Journal.
+    *
+    */
+    Journal() = default;
+
+    /**
+    * @brief Destructor of Journal. Closes the file if needed.
+    *
+    */
+    ~Journal();
+
+    /**
+    * @brief Creates a new journal for the actual triangulation (base mesh),
+    * replacing any previous file.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @param vertices p_vertices: Vector of vertices.
+    * @param edges p_edges: Vector of edges.
+    * @param triangles p_triangles: Vector of triangles.
+    * @return True if correctly created.
+    */
+    bool create(std::string filepath,
+                MeshVector<Vertex> &vertices,
+                MeshVector<Edge> &edges,
+                MeshVector<Triangle> &triangles);
+
+    /**
+    * @brief Replays every complete record of an existing journal onto the base
+    * mesh, and keeps the journal open so new records are appended after the
+    * last complete one (an incomplete last record is discarded). A corrupt
+    * record is an error: the file is left untouched, and the mesh keeps the
+    * records replayed before it.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @param vertices p_vertices: Vector of vertices of the base mesh.
+    * @param edges p_edges: Vector of edges of the base mesh.
+    * @param triangles p_triangles: Vector of triangles of the base mesh.
+    * @param angle p_angle: Angle used by the last replayed record (unchanged if none).
+    * @return Number of replayed records. -1 on error.
+    */
+    int resume(std::string filepath,
+               MeshVector<Vertex> &vertices,
+               MeshVector<Edge> &edges,
+               MeshVector<Triangle> &triangles,
+               float &angle);
+
+    /**
+    * @brief Appends a record with the changes of the last improvement.
+    *
+    * @param angle p_angle: Angle used to detect bad triangles.
+    * @param changes p_changes: Changes of the last improvement.
+    * @param vertices p_vertices: Vector of vertices.
+    * @param edges p_edges: Vector of edges.
+    * @param triangles p_triangles: Vector of triangles.
+    * @return True if correctly written.
+    */
+    bool append(float angle,
+                const ChangeSet &changes,
+                MeshVector<Vertex> &vertices,
+                MeshVector<Edge> &edges,
+                MeshVector<Triangle> &triangles);
+
+    /**
+    * @brief Closes the journal.
+    *
+    */
+    void close();
+
+    /**
+    * @brief Checks if there's a journal being written.
+    *
+    * @return True if open.
+    */
+    bool isOpen() const;
+
+private:
+    /**
+    * @brief Result of replaying a record.
+    *
+    */
+    enum Status
+    {
+        Applied,
+        Incomplete, // The file ends before the record does
+        Corrupt     // Nothing of the record has been applied
+    };
+
+    /**
+    * @brief Reads and applies the next record of the journal.
+    *
+    * @return Applied if a complete and valid record has been applied.
+    */
+    Status replayRecord(MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles,
+                      float &angle);
+
+    /**
+    * @brief Pushes the written records to the disk.
+    *
+    */
+    void sync();
+
+    QFile m_file;
+};
+
+#endif // JOURNAL_H
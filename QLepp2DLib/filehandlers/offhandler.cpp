@@ -19,20 +19,40 @@
 
 #include <QDebug>
 #include <QFile>
-#include <QMap>
+
+#include <cstdio>
+
 #include <filehandlers/offhandler.h>
+#include <filehandlers/topologybuilder.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+
+// Lines between two reports of the progress (and of the partial mesh)
+static const int LOAD_CHUNK = 65536;
+
+OFFHandler::OFFHandler()
+    : m_transientBytes(0)
+{
+}
 
 bool OFFHandler::load(std::string filepath,
-                      std::vector<Vertex> &vertices,
-                      std::vector<Edge> &edges,
-                      std::vector<Triangle> &triangles)
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles)
 {
+    TraceSpan span("readOFF", "io");
+    AllocationScope allocations("readOFF");
     QString qfilepath = QString::fromStdString(filepath);
     qDebug() << "Loading OFF file from" << QString(qfilepath) << endl;
 
     QFile inputFile(qfilepath);
 
-    if (inputFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    // "-" reads from the standard input, so the file can be piped
+    bool opened = (filepath == "-") ?
+        inputFile.open(stdin, QIODevice::ReadOnly | QIODevice::Text) :
+        inputFile.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    if (opened)
     {
         QTextStream in(&inputFile);
 
@@ -56,17 +76,41 @@ bool OFFHandler::load(std::string filepath,
         } while (line.contains("#") or line.size() == 0);
 
         // Read file metadata (vertices, faces, edges)
-        QStringList parsedmetadata = line.split(" ");
+        QStringList parsedmetadata = line.split(" ", QString::SkipEmptyParts);
+        if (parsedmetadata.size() < 3)
+        {
+            qCritical("Invalid OFF header");
+            return false;
+        }
 
         int numVertices = parsedmetadata.at(0).toInt();
         int numTriangles = parsedmetadata.at(1).toInt();
         int numEdges = parsedmetadata.at(2).toInt();
+        if (numVertices < 0 or numTriangles < 0)
+        {
+            qCritical("Invalid OFF header");
+            return false;
+        }
 
         // Read vertices data
+        vertices.reserve(static_cast<unsigned long>(numVertices));
         for (int i(0); i < numVertices; i++)
         {
+            if (i % LOAD_CHUNK == 0)
+            {
+                if (isCancelled())
+                {
+                    return false;
+                }
+                reportProgress("LOAD_V", static_cast<unsigned long>(i), static_cast<unsigned long>(numVertices));
+            }
             line = in.readLine();
             QStringList coordinates = line.split(" ", QString::SkipEmptyParts);
+            if (coordinates.size() < 3)
+            {
+                qCritical() << "Invalid OFF vertex" << i;
+                return false;
+            }
             // We push the coordinates (x, y, z)
             Vertex v;
             v.x = coordinates.at(0).toFloat();
@@ -74,125 +118,65 @@ bool OFFHandler::load(std::string filepath,
             v.z = coordinates.at(2).toFloat();
             vertices.push_back(v);
         }
+        reportProgress("LOAD_V", vertices.size(), vertices.size());
 
-        /* From here we create our structures in 4 phases:
-         * Phase 1: Add triangles with incomplete data (only indices to vertices).
-         * Phase 2: Create a temporal QMap that can detect neighbors of each
-         * parsed triangle.
-         * Phase 3: Use the temporal QMap to update the "edges" vector.
-         * Phase 4: Update incomplete data of triangles with info from phase 3.
-         */
-
-        // Create QMap.
-        QMap<QString, Edge> map;
-
-        // Read faces data (indices)
+        // Read faces data (indices only, the rest is built by TopologyBuilder)
+        triangles.reserve(static_cast<unsigned long>(numTriangles));
         for (int i(0); i < numTriangles; i++)
         {
+            // Every vertex is already read, so the triangles so far can be drawn
+            if (i % LOAD_CHUNK == 0)
+            {
+                if (isCancelled())
+                {
+                    return false;
+                }
+                reportProgress("LOAD_T", static_cast<unsigned long>(i), static_cast<unsigned long>(numTriangles));
+                reportChunk(vertices, triangles);
+            }
             line = in.readLine();
             QStringList mappedIndices = line.split(" ", QString::SkipEmptyParts);
             // We check and skip the first one, because it marks the amount of indices, not the index itself.
+            if (mappedIndices.size() < 4 or mappedIndices.at(0).toInt() != 3)
+            {
+                qCritical() << "OFF face" << i << "isn't a triangle";
+                return false;
+            }
             Triangle t;
-
-            // Phase 1
-            t.iv1 = mappedIndices.at(1).toInt();
-            t.iv2 = mappedIndices.at(2).toInt();
-            t.iv3 = mappedIndices.at(3).toInt();
+            bool ok1(false), ok2(false), ok3(false);
+            t.iv1 = mappedIndices.at(1).toInt(&ok1);
+            t.iv2 = mappedIndices.at(2).toInt(&ok2);
+            t.iv3 = mappedIndices.at(3).toInt(&ok3);
+
+            // Engines index the vertices without checking, so a bad face must fail the load here
+            if (not (ok1 and ok2 and ok3) or
+                t.iv1 < 0 or t.iv1 >= numVertices or
+                t.iv2 < 0 or t.iv2 >= numVertices or
+                t.iv3 < 0 or t.iv3 >= numVertices or
+                t.iv1 == t.iv2 or t.iv2 == t.iv3 or t.iv1 == t.iv3)
+            {
+                qCritical() << "Invalid vertex indices in OFF face" << i;
+                return false;
+            }
             t.ie1 = -1;
             t.ie2 = -1;
             t.ie3 = -1;
             t.bad = 0;
             triangles.push_back(t);
-
-            // Phase 2
-            QVector<int> tmpIV; // Temporal vertices
-            tmpIV.append(t.iv1);
-            tmpIV.append(t.iv2);
-            tmpIV.append(t.iv3);
-
-            for (int j(0); j < 3; j++)
-            {
-                QString key = QString("%1-%2")
-                        .arg(std::min(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3)))
-                        .arg(std::max(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3)));
-                Edge ed;
-
-                if (map.contains(key))
-                {
-                    ed = map.value(key);
-                    ed.itb = i; // Index of current triangle, neighbour of earlier triangle in "map"
-                }
-                else
-                {
-                    ed.iv1 = std::min(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3));
-                    ed.iv2 = std::max(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3));
-                    ed.ita = i; // Index of current triangle
-                    ed.itb = -1; // Index of neighbour triangle not (yet) found
-                    ed.isTE = 0;
-                }
-
-                map.insert(key, ed);
-            }
         }
 
-        // Phase 3
-        int k = 0; // Current pointer of edges
-        for (QMap<QString, Edge>::iterator i(map.begin()); i != map.end(); i++, k++)
-        {
-            Edge e(i.value());
-            edges.push_back(e);
-
-            // Phase 4
-            // Triangle A
-            unsigned long e_ita(static_cast<unsigned long>(e.ita));
-            Triangle &ta = triangles.at(e_ita);
-            /* If the Vertex "a" from the triangle is not in e.iv1 or e.iv2,
-             * then this Vertex "a" is the opposite of the current Edge.
-             */
-            if (ta.iv1 != e.iv1 and ta.iv1 != e.iv2)
-            {
-                ta.ie1 = k;
-            }
-            else if (ta.iv2 != e.iv1 and ta.iv2 != e.iv2)
-            {
-                ta.ie2 = k;
-            }
-            else if (ta.iv3 != e.iv1 and ta.iv3 != e.iv2)
-            {
-                ta.ie3 = k;
-            }
-            else
-            {
-                qCritical("Inconsistent data (A)!");
-            }
-
-            // Triangle B
-            if (e.itb < 0)
-            {
-                continue; // Maybe there isn't a neighbour triangle.
-            }
-
-            unsigned long e_itb(static_cast<unsigned long>(e.itb));
-            Triangle &tb = triangles.at(e_itb);
+        reportProgress("LOAD_T", triangles.size(), triangles.size());
+        reportChunk(vertices, triangles);
 
-            if (tb.iv1 != e.iv1 and tb.iv1 != e.iv2)
-            {
-                tb.ie1 = k;
-            }
-            else if (tb.iv2 != e.iv1 and tb.iv2 != e.iv2)
-            {
-                tb.ie2 = k;
-            }
-            else if (tb.iv3 != e.iv1 and tb.iv3 != e.iv2)
-            {
-                tb.ie3 = k;
-            }
-            else
-            {
-                qCritical("Inconsistent data (B)!");
-            }
+        TopologyBuilder builder;
+        if (not builder.build(edges, triangles, m_progress, m_cancellation))
+        {
+            return false;
         }
 
+        // Lines are parsed one at a time, so only the map of edges adds up
+        m_transientBytes = builder.getTransientBytes();
+
         inputFile.close();
 
         qInfo() << "Loaded Vertices  :" << numVertices;
@@ -204,11 +188,18 @@ bool OFFHandler::load(std::string filepath,
     return false;
 }
 
+unsigned long long OFFHandler::getTransientBytes() const
+{
+    return m_transientBytes;
+}
+
 bool OFFHandler::save(std::string filepath,
-                      std::vector<Vertex> &vertices,
-                      std::vector<Edge> &edges,
-                      std::vector<Triangle> &triangles)
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles)
 {
+    TraceSpan span("writeOFF", "io");
+    AllocationScope allocations("writeOFF");
     unsigned long numVertices(vertices.size());
     unsigned long numTriangles(triangles.size());
     unsigned long numEdges(edges.size());
@@ -218,7 +209,12 @@ bool OFFHandler::save(std::string filepath,
 
     QFile outputFile(qfilepath);
 
-    if (outputFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    // "-" writes to the standard output, so the file can be piped
+    bool opened = (filepath == "-") ?
+        outputFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text) :
+        outputFile.open(QIODevice::WriteOnly | QIODevice::Text);
+
+    if (opened)
     {
         QTextStream out(&outputFile);
         out << "OFF" << endl;
@@ -36,7 +36,7 @@ public:
     * @brief Constructor of OFFHandler.
     *
     */
-    OFFHandler() = default;
+    OFFHandler();
 
     /**
     * @brief Method that loads an OFF file and modifies the parameters according to the loaded triangulation.
@@ -48,9 +48,9 @@ public:
     * @return True if correctly loaded.
     */
     bool load(std::string filepath,
-              std::vector<Vertex> &vertices,
-              std::vector<Edge> &edges,
-              std::vector<Triangle> &triangles) override;
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles) override;
 
     /**
     * @brief Method that saves an OFF file according to the actual parameters.
@@ -62,9 +62,20 @@ public:
     * @return True if correctly saved.
     */
     bool save(std::string filepath,
-              std::vector<Vertex> &vertices,
-              std::vector<Edge> &edges,
-              std::vector<Triangle> &triangles) override;
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles) override;
+
+    /**
+    * @brief Gets an estimate of the temporary memory of the last load. It's
+    * dominated by the map of edges used to build the topology.
+    *
+    * @return Bytes.
+    */
+    unsigned long long getTransientBytes() const override;
+
+private:
+    unsigned long long m_transientBytes;
 };
 
 #endif // OFFHANDLER_H
@@ -0,0 +1,95 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RAWIO_H
+#define RAWIO_H
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <vector>
+
+/**
+* @brief Helpers to dump vectors of plain structs into binary files.
+* Data is stored in the byte order of the host.
+*
+*/
+namespace RawIO
+{
+    // QDataStream only accepts int lengths, so big blocks go in pieces.
+    const quint64 CHUNK(1 << 30);
+
+    /**
+    * @brief Writes "count" elements starting at "data".
+    *
+    * @param out p_out: Output stream.
+    * @param data p_data: First element.
+    * @param count p_count: Number of elements.
+    */
+    template <typename T>
+    void write(QDataStream &out, const T *data, quint64 count)
+    {
+        const char *bytes(reinterpret_cast<const char *>(data));
+        quint64 remaining(count * sizeof(T));
+        while (remaining > 0)
+        {
+            int len(static_cast<int>(std::min(remaining, CHUNK)));
+            out.writeRawData(bytes, len);
+            bytes += len;
+            remaining -= static_cast<quint64>(len);
+        }
+    }
+
+    /**
+    * @brief Reads "count" elements, replacing the contents of "data".
+    *
+    * @param in p_in: Input stream.
+    * @param data p_data: Vector that receives the elements.
+    * @param count p_count: Number of elements.
+    * @return True if every element could be read (false, without allocating,
+    * if the stream doesn't have that many).
+    */
+    template <typename T, typename Allocator>
+    bool read(QDataStream &in, std::vector<T, Allocator> &data, quint64 count)
+    {
+        // "count" usually comes from the same file, so it can't be trusted
+        if (in.device() == nullptr or
+            count > static_cast<quint64>(in.device()->bytesAvailable()) / sizeof(T))
+        {
+            return false;
+        }
+
+        data.resize(count);
+        char *bytes(reinterpret_cast<char *>(data.data()));
+        quint64 remaining(count * sizeof(T));
+        while (remaining > 0)
+        {
+            int len(static_cast<int>(std::min(remaining, CHUNK)));
+            if (in.readRawData(bytes, len) != len)
+            {
+                return false;
+            }
+            bytes += len;
+            remaining -= static_cast<quint64>(len);
+        }
+        return true;
+    }
+}
+
+#endif // RAWIO_H
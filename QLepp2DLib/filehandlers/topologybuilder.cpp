@@ -0,0 +1,194 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QMap>
+#include <QVector>
+
+#include <algorithm>
+
+#include <filehandlers/topologybuilder.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+
+namespace
+{
+    // Heap blocks are rounded to 16 bytes, with 8 more of bookkeeping (glibc)
+    unsigned long long heapBlock(unsigned long long bytes)
+    {
+        return (bytes + 8 + 15) / 16 * 16;
+    }
+
+    // Triangles between two reports of the progress
+    const unsigned long PROGRESS_CHUNK = 65536;
+}
+
+TopologyBuilder::TopologyBuilder()
+    : m_transientBytes(0)
+{
+}
+
+unsigned long long TopologyBuilder::getTransientBytes() const
+{
+    return m_transientBytes;
+}
+
+bool TopologyBuilder::build(MeshVector<Edge> &edges,
+                            MeshVector<Triangle> &triangles,
+                            ProgressCallback progress,
+                            CancellationToken token)
+{
+    TraceSpan span("buildTopology", "io");
+    AllocationScope allocations("buildTopology");
+
+    /* We create our structures in 3 phases:
+     * Phase 1: Create a temporal QMap that can detect neighbors of each
+     * triangle.
+     * Phase 2: Use the temporal QMap to update the "edges" vector.
+     * Phase 3: Update incomplete data of triangles with info from phase 2.
+     */
+
+    // Create QMap.
+    QMap<QString, Edge> map;
+    m_transientBytes = 0;
+
+    Progress current;
+    current.phase = "LOAD_E";
+    current.total = triangles.size();
+    for (unsigned long idx(0); idx < triangles.size(); idx++)
+    {
+        // The vectors aren't modified until phase 2, so it can stop here
+        if (idx % PROGRESS_CHUNK == 0)
+        {
+            if (token.isCancelled())
+            {
+                return false;
+            }
+            if (progress)
+            {
+                current.processed = idx;
+                progress(current);
+            }
+        }
+
+        int i(static_cast<int>(idx));
+        const Triangle &t = triangles.at(idx);
+
+        // Phase 1
+        QVector<int> tmpIV; // Temporal vertices
+        tmpIV.append(t.iv1);
+        tmpIV.append(t.iv2);
+        tmpIV.append(t.iv3);
+
+        for (int j(0); j < 3; j++)
+        {
+            QString key = QString("%1-%2")
+                    .arg(std::min(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3)))
+                    .arg(std::max(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3)));
+            Edge ed;
+
+            if (map.contains(key))
+            {
+                ed = map.value(key);
+                ed.itb = i; // Index of current triangle, neighbour of earlier triangle in "map"
+            }
+            else
+            {
+                ed.iv1 = std::min(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3));
+                ed.iv2 = std::max(tmpIV.at(j % 3), tmpIV.at((j + 1) % 3));
+                ed.ita = i; // Index of current triangle
+                ed.itb = -1; // Index of neighbour triangle not (yet) found
+                ed.isTE = 0;
+
+                // Node (3 links, key and value) and UTF-16 data of the key
+                m_transientBytes += heapBlock(3 * sizeof(void*) + sizeof(QString) + sizeof(Edge));
+                m_transientBytes += heapBlock(24 + 2 * (static_cast<unsigned long long>(key.size()) + 1));
+            }
+
+            map.insert(key, ed);
+        }
+    }
+
+    // Phase 2
+    edges.clear();
+    edges.reserve(static_cast<unsigned long>(map.size()));
+    int k = 0; // Current pointer of edges
+    for (QMap<QString, Edge>::iterator i(map.begin()); i != map.end(); i++, k++)
+    {
+        Edge e(i.value());
+        edges.push_back(e);
+
+        // Phase 3
+        // Triangle A
+        unsigned long e_ita(static_cast<unsigned long>(e.ita));
+        Triangle &ta = triangles.at(e_ita);
+        /* If the Vertex "a" from the triangle is not in e.iv1 or e.iv2,
+         * then this Vertex "a" is the opposite of the current Edge.
+         */
+        if (ta.iv1 != e.iv1 and ta.iv1 != e.iv2)
+        {
+            ta.ie1 = k;
+        }
+        else if (ta.iv2 != e.iv1 and ta.iv2 != e.iv2)
+        {
+            ta.ie2 = k;
+        }
+        else if (ta.iv3 != e.iv1 and ta.iv3 != e.iv2)
+        {
+            ta.ie3 = k;
+        }
+        else
+        {
+            qCritical("Inconsistent data (A)!");
+        }
+
+        // Triangle B
+        if (e.itb < 0)
+        {
+            continue; // Maybe there isn't a neighbour triangle.
+        }
+
+        unsigned long e_itb(static_cast<unsigned long>(e.itb));
+        Triangle &tb = triangles.at(e_itb);
+
+        if (tb.iv1 != e.iv1 and tb.iv1 != e.iv2)
+        {
+            tb.ie1 = k;
+        }
+        else if (tb.iv2 != e.iv1 and tb.iv2 != e.iv2)
+        {
+            tb.ie2 = k;
+        }
+        else if (tb.iv3 != e.iv1 and tb.iv3 != e.iv2)
+        {
+            tb.ie3 = k;
+        }
+        else
+        {
+            qCritical("Inconsistent data (B)!");
+        }
+    }
+
+    if (progress)
+    {
+        current.processed = triangles.size();
+        progress(current);
+    }
+    return true;
+}
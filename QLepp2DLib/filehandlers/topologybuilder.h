@@ -0,0 +1,69 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOPOLOGYBUILDER_H
+#define TOPOLOGYBUILDER_H
+
+#include <engine/progress.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Builds the edges of a triangulation, and links them with their
+* triangles, from triangles that only know their vertices.
+*
+*/
+class TopologyBuilder
+{
+public:
+    /**
+    * @brief Constructor of TopologyBuilder.
+    *
+    */
+    TopologyBuilder();
+
+    /**
+    * @brief Replaces the edges with the ones of the triangles, and updates
+    * the edge indices (ie1, ie2, ie3) of every triangle.
+    *
+    * @param edges p_edges: Vector of edges. Old data is removed.
+    * @param triangles p_triangles: Vector of triangles with valid vertex indices.
+    * @param progress p_progress: Receiver of the triangles processed (phase LOAD_E).
+    * @param token p_token: Token that stops the build before the vectors are modified.
+    * @return False if cancelled.
+    */
+    bool build(MeshVector<Edge> &edges,
+               MeshVector<Triangle> &triangles,
+               ProgressCallback progress = ProgressCallback(),
+               CancellationToken token = CancellationToken());
+
+    /**
+    * @brief Gets an estimate of the temporary memory (the map of edges and
+    * its keys) of the last build, at its peak.
+    *
+    * @return Bytes in the heap.
+    */
+    unsigned long long getTransientBytes() const;
+
+private:
+    unsigned long long m_transientBytes;
+};
+
+#endif // TOPOLOGYBUILDER_H
@@ -0,0 +1,146 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <cstdio>
+
+#include <filehandlers/xyzhandler.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+#include <triangulation/delaunaytriangulator.h>
+
+// Lines between two reports of the progress
+static const unsigned long LOAD_CHUNK = 65536;
+
+bool XYZHandler::load(std::string filepath,
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &edges,
+                      MeshVector<Triangle> &triangles)
+{
+    TraceSpan span("readXYZ", "io");
+    AllocationScope allocations("readXYZ");
+    QString qfilepath = QString::fromStdString(filepath);
+    qDebug() << "Loading XYZ file from" << qfilepath << endl;
+
+    QFile inputFile(qfilepath);
+
+    // "-" reads from the standard input, as in OFFHandler
+    bool opened = (filepath == "-") ?
+        inputFile.open(stdin, QIODevice::ReadOnly | QIODevice::Text) :
+        inputFile.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    if (not opened)
+    {
+        return false;
+    }
+
+    MeshVector<Vertex> points(vertices.get_allocator());
+    QTextStream in(&inputFile);
+    QString line;
+    unsigned long lines(0);
+    while (in.readLineInto(&line))
+    {
+        // The number of points isn't known until the end
+        if (lines++ % LOAD_CHUNK == 0)
+        {
+            if (isCancelled())
+            {
+                return false;
+            }
+            reportProgress("LOAD_V", points.size(), 0);
+        }
+
+        line = line.trimmed();
+        if (line.isEmpty() or line.startsWith("#"))
+        {
+            continue;
+        }
+
+        QStringList coordinates = line.split(" ", QString::SkipEmptyParts);
+        bool okX(false), okY(false), okZ(true);
+        Vertex v;
+        v.x = coordinates.at(0).toFloat(&okX);
+        v.y = (coordinates.size() > 1) ? coordinates.at(1).toFloat(&okY) : 0;
+        v.z = (coordinates.size() > 2) ? coordinates.at(2).toFloat(&okZ) : 0;
+        if (not (okX and okY and okZ))
+        {
+            qCritical("Not an XYZ file");
+            return false;
+        }
+        points.push_back(v);
+    }
+    inputFile.close();
+
+    MeshVector<Edge> newEdges(edges.get_allocator());
+    MeshVector<Triangle> newTriangles(triangles.get_allocator());
+    DelaunayTriangulator triangulator;
+    if (not triangulator.triangulate(points, newEdges, newTriangles))
+    {
+        qCritical("Not enough non-collinear points to triangulate");
+        return false;
+    }
+
+    // Old data is only replaced by a valid triangulation
+    vertices.swap(points);
+    edges.swap(newEdges);
+    triangles.swap(newTriangles);
+
+    qInfo() << "Loaded Vertices  :" << vertices.size();
+    qInfo() << "Loaded Edges     :" << edges.size();
+    qInfo() << "Loaded Triangles :" << triangles.size();
+
+    return true;
+}
+
+bool XYZHandler::save(std::string filepath,
+                      MeshVector<Vertex> &vertices,
+                      MeshVector<Edge> &,
+                      MeshVector<Triangle> &)
+{
+    TraceSpan span("writeXYZ", "io");
+    AllocationScope allocations("writeXYZ");
+    QString qfilepath = QString::fromStdString(filepath);
+    qDebug() << "Saving XYZ file to" << qfilepath << endl;
+
+    QFile outputFile(qfilepath);
+
+    bool opened = (filepath == "-") ?
+        outputFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text) :
+        outputFile.open(QIODevice::WriteOnly | QIODevice::Text);
+
+    if (not opened)
+    {
+        return false;
+    }
+
+    QTextStream out(&outputFile);
+    for (Vertex &v : vertices)
+    {
+        out << v.x << " " << v.y << " " << v.z << endl;
+    }
+    outputFile.close();
+
+    qInfo() << "Saved Vertices  :" << vertices.size();
+
+    return true;
+}
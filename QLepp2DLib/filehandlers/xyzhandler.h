@@ -0,0 +1,72 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XYZHANDLER_H
+#define XYZHANDLER_H
+
+#include <string>
+
+#include <filehandlers/filehandler.h>
+
+/**
+* @brief XYZ (point cloud) files handling module. Each line has the "x y z"
+* (or "x y") coordinates of a point, and lines starting with "#" are
+* comments. Loaded points are Delaunay-triangulated.
+*
+*/
+class XYZHandler : public FileHandler
+{
+public:
+    /**
+    * @brief Constructor of XYZHandler.
+    *
+    */
+    XYZHandler() = default;
+
+    /**
+    * @brief Method that loads an XYZ file and triangulates its points.
+    *
+    * @param filepath p_filepath: Path of the XYZ file.
+    * @param vertices p_vertices: Vector of vertices.
+    * @param edges p_edges: Vector of edges.
+    * @param triangles p_triangles: Vector of triangles.
+    * @return True if correctly loaded and triangulated.
+    */
+    bool load(std::string filepath,
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles) override;
+
+    /**
+    * @brief Method that saves the vertices as an XYZ file. The triangles are
+    * not saved.
+    *
+    * @param filepath p_filepath: Path of the XYZ file.
+    * @param vertices p_vertices: Vector of vertices.
+    * @param edges p_edges: Vector of edges.
+    * @param indices p_triangles: Vector of triangles.
+    * @return True if correctly saved.
+    */
+    bool save(std::string filepath,
+              MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles) override;
+};
+
+#endif // XYZHANDLER_H
@@ -0,0 +1,143 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <metrics/allocationtracker.h>
+
+namespace
+{
+    /* A fixed table, as it's filled from inside the allocator. Slot 0 is
+     * "other", and the rest are claimed by the phases as they allocate.
+     */
+    const unsigned int MAX_PHASES = 64;
+
+    std::atomic<const char*> phaseNames[MAX_PHASES];
+    std::atomic<unsigned long long> phaseAllocations[MAX_PHASES];
+    std::atomic<unsigned long long> phaseBytes[MAX_PHASES];
+
+    // Phase of the thread, and its slot once found (-1 until then)
+    thread_local const char *currentPhase = nullptr;
+    thread_local int currentSlot = 0;
+
+    int findSlot(const char *phase)
+    {
+        if (phase == nullptr)
+        {
+            return 0;
+        }
+        for (unsigned int slot(1); slot < MAX_PHASES; slot++)
+        {
+            const char *name = phaseNames[slot].load(std::memory_order_acquire);
+            if (name == nullptr)
+            {
+                // Claims an empty slot, unless another thread claimed it first
+                if (phaseNames[slot].compare_exchange_strong(name, phase, std::memory_order_acq_rel))
+                {
+                    return static_cast<int>(slot);
+                }
+            }
+            if (name == phase)
+            {
+                return static_cast<int>(slot);
+            }
+        }
+        return 0;
+    }
+}
+
+std::atomic<bool> AllocationTracker::s_enabled(false);
+
+void AllocationTracker::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void AllocationTracker::record(std::size_t bytes)
+{
+    if (not isEnabled())
+    {
+        return;
+    }
+    if (currentSlot < 0)
+    {
+        currentSlot = findSlot(currentPhase);
+    }
+    phaseAllocations[currentSlot].fetch_add(1, std::memory_order_relaxed);
+    phaseBytes[currentSlot].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+const char* AllocationTracker::setPhase(const char *phase)
+{
+    const char *previous = currentPhase;
+    if (phase != previous)
+    {
+        currentPhase = phase;
+        currentSlot = (phase == nullptr) ? 0 : -1;
+    }
+    return previous;
+}
+
+std::vector<AllocationTracker::PhaseAllocations> AllocationTracker::getAllocations()
+{
+    // Read first, as building the result allocates too
+    PhaseAllocations counted[MAX_PHASES];
+    unsigned int used(0);
+    for (unsigned int slot(0); slot < MAX_PHASES; slot++)
+    {
+        const char *name = (slot == 0) ? "other" : phaseNames[slot].load(std::memory_order_acquire);
+        unsigned long long allocations = phaseAllocations[slot].load(std::memory_order_relaxed);
+        if (name == nullptr or allocations == 0)
+        {
+            continue;
+        }
+        counted[used].allocations = allocations;
+        counted[used].bytes = phaseBytes[slot].load(std::memory_order_relaxed);
+        counted[used].phase = name;
+        used++;
+    }
+
+    // The same literal can have an address per translation unit, so names are merged
+    std::vector<PhaseAllocations> allocations;
+    for (unsigned int i(0); i < used; i++)
+    {
+        bool merged(false);
+        for (PhaseAllocations &phase : allocations)
+        {
+            if (phase.phase == counted[i].phase)
+            {
+                phase.allocations += counted[i].allocations;
+                phase.bytes += counted[i].bytes;
+                merged = true;
+                break;
+            }
+        }
+        if (not merged)
+        {
+            allocations.push_back(counted[i]);
+        }
+    }
+    return allocations;
+}
+
+void AllocationTracker::reset()
+{
+    for (unsigned int slot(0); slot < MAX_PHASES; slot++)
+    {
+        phaseAllocations[slot].store(0, std::memory_order_relaxed);
+        phaseBytes[slot].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* @brief Attributes the heap allocations of the process to the library phase
+* running in the thread that makes them.
+*
+* The library marks its phases with AllocationScope, but nothing is counted
+* unless a build hooks the allocator and calls record() (like qlepp2d-bench
+* does), and the tracker is enabled. record() doesn't allocate, so it can be
+* called from malloc or operator new.
+*
+*/
+class AllocationTracker
+{
+public:
+    /**
+    * @brief Allocations of a phase.
+    *
+    */
+    struct PhaseAllocations
+    {
+        std::string phase;
+        unsigned long long allocations;
+        unsigned long long bytes;
+    };
+
+    /**
+    * @brief Enables or disables the counting. Counted values are kept.
+    *
+    * @param enabled p_enabled: True to count.
+    */
+    static void setEnabled(bool enabled);
+
+    /**
+    * @brief Checks if allocations are being counted.
+    *
+    * @return True if enabled.
+    */
+    static inline bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * @brief Counts an allocation of the phase of the calling thread.
+    * Allocations outside of every phase go to "other".
+    *
+    * @param bytes p_bytes: Requested bytes.
+    */
+    static void record(std::size_t bytes);
+
+    /**
+    * @brief Sets the phase of the calling thread.
+    *
+    * @param phase p_phase: Name of the phase, or nullptr. Must be a string literal.
+    * @return The previous phase.
+    */
+    static const char* setPhase(const char *phase);
+
+    /**
+    * @brief Gets the allocations counted since the last reset.
+    *
+    * @return Phases with allocations, in the order they first allocated.
+    */
+    static std::vector<PhaseAllocations> getAllocations();
+
+    /**
+    * @brief Sets every count to 0.
+    *
+    */
+    static void reset();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+* @brief Sets the allocation phase of the calling thread while in scope, and
+* then restores the previous one, so phases can be nested.
+*
+*/
+class AllocationScope
+{
+public:
+    /**
+    * @brief Enters a phase.
+    *
+    * @param phase p_phase: Name of the phase. Must be a string literal.
+    */
+    explicit AllocationScope(const char *phase)
+        : m_previous(AllocationTracker::setPhase(phase))
+    {
+    }
+
+    /**
+    * @brief Returns to the previous phase.
+    *
+    */
+    ~AllocationScope()
+    {
+        AllocationTracker::setPhase(m_previous);
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    const char *m_previous;
+};
+
+#endif // ALLOCATIONTRACKER_H
@@ -0,0 +1,92 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DEVICECOMMAND_H
+#define DEVICECOMMAND_H
+
+#include <string>
+
+/**
+* @brief Profiling information of a command run by a device: a transfer
+* between host and device memory, or a kernel. Times are nanoseconds of the
+* clock of the device, so only their differences are meaningful.
+*
+*/
+struct DeviceCommand
+{
+    /**
+    * @brief Kind of the command.
+    *
+    */
+    enum Kind
+    {
+        Write,  // Host to device
+        Kernel,
+        Read    // Device to host
+    };
+
+    std::string name;
+    Kind kind = Kernel;
+    unsigned long long bytes = 0;
+    unsigned long long queued = 0;
+    unsigned long long submit = 0;
+    unsigned long long start = 0;
+    unsigned long long end = 0;
+
+    /**
+    * @brief Gets the time the command spent running on the device.
+    *
+    * @return Nanoseconds from start to end.
+    */
+    inline long long duration() const
+    {
+        return static_cast<long long>(end - start);
+    }
+
+    /**
+    * @brief Gets the time the command waited since it was enqueued.
+    *
+    * @return Nanoseconds from queued to start.
+    */
+    inline long long latency() const
+    {
+        return static_cast<long long>(start - queued);
+    }
+
+    /**
+    * @brief Gets the effective bandwidth of a transfer.
+    *
+    * @return Bytes per nanosecond (GB/s), or 0 for kernels.
+    */
+    inline double bandwidth() const
+    {
+        return (end > start) ? static_cast<double>(bytes) / (end - start) : 0;
+    }
+
+    /**
+    * @brief Gets the name of the kind.
+    *
+    * @return "write", "kernel" or "read".
+    */
+    inline const char* kindName() const
+    {
+        return (kind == Write) ? "write" : ((kind == Read) ? "read" : "kernel");
+    }
+};
+
+#endif // DEVICECOMMAND_H
@@ -0,0 +1,112 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include <metrics/histogram.h>
+
+Histogram::Histogram()
+    : m_count(0),
+      m_sum(0)
+{
+}
+
+void Histogram::add(unsigned long value, unsigned long count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (value >= m_buckets.size())
+    {
+        m_buckets.resize(value + 1, 0);
+    }
+    m_buckets[value] += count;
+    m_count += count;
+    m_sum += static_cast<double>(value) * count;
+}
+
+void Histogram::merge(const Histogram &other)
+{
+    for (unsigned long value(0); value < other.m_buckets.size(); value++)
+    {
+        add(value, other.m_buckets[value]);
+    }
+}
+
+unsigned long Histogram::count() const
+{
+    return m_count;
+}
+
+unsigned long Histogram::min() const
+{
+    for (unsigned long value(0); value < m_buckets.size(); value++)
+    {
+        if (m_buckets[value] > 0)
+        {
+            return value;
+        }
+    }
+    return 0;
+}
+
+unsigned long Histogram::max() const
+{
+    for (unsigned long value(m_buckets.size()); value > 0; value--)
+    {
+        if (m_buckets[value - 1] > 0)
+        {
+            return value - 1;
+        }
+    }
+    return 0;
+}
+
+double Histogram::mean() const
+{
+    return (m_count > 0) ? m_sum / m_count : 0;
+}
+
+unsigned long Histogram::percentile(double percent) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    // Nearest rank: the smallest value with at least percent% of the samples
+    double rank = std::ceil(percent / 100.0 * m_count);
+    unsigned long target = (rank < 1) ? 1 : static_cast<unsigned long>(rank);
+    unsigned long seen(0);
+    for (unsigned long value(0); value < m_buckets.size(); value++)
+    {
+        seen += m_buckets[value];
+        if (seen >= target)
+        {
+            return value;
+        }
+    }
+    return max();
+}
+
+const std::vector<unsigned long>& Histogram::getBuckets() const
+{
+    return m_buckets;
+}
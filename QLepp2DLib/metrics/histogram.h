@@ -0,0 +1,103 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <vector>
+
+/**
+* @brief Exact histogram of small non-negative integers (like the number of
+* steps of a walk), with one bucket per value.
+*
+*/
+class Histogram
+{
+public:
+    /**
+    * @brief Constructor of an empty Histogram.
+    *
+    */
+    Histogram();
+
+    /**
+    * @brief Adds samples of a value.
+    *
+    * @param value p_value: Value of the samples.
+    * @param count p_count: Number of samples.
+    */
+    void add(unsigned long value, unsigned long count = 1);
+
+    /**
+    * @brief Adds the samples of another histogram.
+    *
+    * @param other p_other: Histogram to merge.
+    */
+    void merge(const Histogram &other);
+
+    /**
+    * @brief Gets the number of samples.
+    *
+    * @return Number of samples.
+    */
+    unsigned long count() const;
+
+    /**
+    * @brief Gets the smallest sample.
+    *
+    * @return Smallest sample, or 0 if empty.
+    */
+    unsigned long min() const;
+
+    /**
+    * @brief Gets the largest sample.
+    *
+    * @return Largest sample, or 0 if empty.
+    */
+    unsigned long max() const;
+
+    /**
+    * @brief Gets the mean of the samples.
+    *
+    * @return Mean, or 0 if empty.
+    */
+    double mean() const;
+
+    /**
+    * @brief Gets a percentile (nearest rank) of the samples.
+    *
+    * @param percent p_percent: Percentile, in [0, 100].
+    * @return Value of the percentile, or 0 if empty.
+    */
+    unsigned long percentile(double percent) const;
+
+    /**
+    * @brief Gets the samples of each value.
+    *
+    * @return Vector where position i has the number of samples of value i.
+    */
+    const std::vector<unsigned long>& getBuckets() const;
+
+private:
+    std::vector<unsigned long> m_buckets;
+    unsigned long m_count;
+    double m_sum;
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,292 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+
+#include <metrics/metrics.h>
+
+Metrics::Metrics()
+    : m_enabled(false),
+      m_hardwareCounters(false)
+{
+}
+
+void Metrics::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+void Metrics::setHardwareCountersEnabled(bool enabled)
+{
+    m_hardwareCounters = enabled;
+}
+
+void Metrics::merge(const Metrics &other)
+{
+    if (not isEnabled())
+    {
+        return;
+    }
+    m_timings.insert(m_timings.end(), other.m_timings.begin(), other.m_timings.end());
+    for (const std::pair<std::string, unsigned long> &counter : other.m_counters)
+    {
+        add(m_counters, counter.first.c_str(), counter.second);
+    }
+    for (const std::pair<std::string, double> &gauge : other.m_gauges)
+    {
+        set(m_gauges, gauge.first.c_str(), gauge.second);
+    }
+    for (const std::pair<std::string, Histogram> &histogram : other.m_histograms)
+    {
+        merge(m_histograms, histogram.first.c_str(), histogram.second);
+    }
+    m_commands.insert(m_commands.end(), other.m_commands.begin(), other.m_commands.end());
+    m_hardware.insert(m_hardware.end(), other.m_hardware.begin(), other.m_hardware.end());
+}
+
+void Metrics::clear()
+{
+    m_timings.clear();
+    m_counters.clear();
+    m_gauges.clear();
+    m_histograms.clear();
+    m_commands.clear();
+    m_hardware.clear();
+}
+
+const std::vector<std::pair<std::string, long long>>& Metrics::getTimings() const
+{
+    return m_timings;
+}
+
+const std::vector<std::pair<std::string, unsigned long>>& Metrics::getCounters() const
+{
+    return m_counters;
+}
+
+const std::vector<std::pair<std::string, double>>& Metrics::getGauges() const
+{
+    return m_gauges;
+}
+
+const std::vector<std::pair<std::string, Histogram>>& Metrics::getHistograms() const
+{
+    return m_histograms;
+}
+
+const std::vector<DeviceCommand>& Metrics::getCommands() const
+{
+    return m_commands;
+}
+
+const std::vector<Metrics::PhaseCounters>& Metrics::getHardwareCounters() const
+{
+    return m_hardware;
+}
+
+HardwareCounters Metrics::getHardwareCounters(const std::string &phase) const
+{
+    HardwareCounters total;
+    for (const PhaseCounters &value : m_hardware)
+    {
+        if (value.phase == phase)
+        {
+            total.add(value.counters);
+        }
+    }
+    return total;
+}
+
+Histogram Metrics::getHistogram(const std::string &histogram) const
+{
+    for (const std::pair<std::string, Histogram> &value : m_histograms)
+    {
+        if (value.first == histogram)
+        {
+            return value.second;
+        }
+    }
+    return Histogram();
+}
+
+unsigned long Metrics::getCount(const std::string &counter) const
+{
+    for (const std::pair<std::string, unsigned long> &value : m_counters)
+    {
+        if (value.first == counter)
+        {
+            return value.second;
+        }
+    }
+    return 0;
+}
+
+std::string Metrics::toJson() const
+{
+    QJsonObject timers;
+    for (const std::pair<std::string, long long> &timing : m_timings)
+    {
+        QString phase(QString::fromStdString(timing.first));
+        timers.insert(phase, timers.value(phase).toDouble() + timing.second);
+    }
+
+    QJsonObject counters;
+    for (const std::pair<std::string, unsigned long> &counter : m_counters)
+    {
+        counters.insert(QString::fromStdString(counter.first), static_cast<double>(counter.second));
+    }
+
+    QJsonObject gauges;
+    for (const std::pair<std::string, double> &gauge : m_gauges)
+    {
+        gauges.insert(QString::fromStdString(gauge.first), gauge.second);
+    }
+
+    QJsonObject histograms;
+    for (const std::pair<std::string, Histogram> &histogram : m_histograms)
+    {
+        const Histogram &h(histogram.second);
+        QJsonObject summary;
+        summary.insert("count", static_cast<double>(h.count()));
+        summary.insert("min", static_cast<double>(h.min()));
+        summary.insert("mean", h.mean());
+        summary.insert("p50", static_cast<double>(h.percentile(50)));
+        summary.insert("p90", static_cast<double>(h.percentile(90)));
+        summary.insert("p99", static_cast<double>(h.percentile(99)));
+        summary.insert("max", static_cast<double>(h.max()));
+        histograms.insert(QString::fromStdString(histogram.first), summary);
+    }
+
+    QJsonArray commands;
+    for (const DeviceCommand &command : m_commands)
+    {
+        QJsonObject profile;
+        profile.insert("name", QString::fromStdString(command.name));
+        profile.insert("kind", command.kindName());
+        profile.insert("bytes", static_cast<double>(command.bytes));
+        profile.insert("queued", static_cast<double>(command.queued));
+        profile.insert("submit", static_cast<double>(command.submit));
+        profile.insert("start", static_cast<double>(command.start));
+        profile.insert("end", static_cast<double>(command.end));
+        if (command.kind != DeviceCommand::Kernel)
+        {
+            profile.insert("gb_per_s", command.bandwidth());
+        }
+        commands.append(profile);
+    }
+
+    // Phases in the order they ended, each one with its threads
+    QJsonObject hardware;
+    auto countersToJson = [](const HardwareCounters &counters) {
+        QJsonObject values;
+        for (int counter(0); counter < HardwareCounters::Count; counter++)
+        {
+            if (counters.available[counter])
+            {
+                values.insert(HardwareCounters::name(static_cast<HardwareCounters::Counter>(counter)),
+                              static_cast<double>(counters.values[counter]));
+            }
+        }
+        if (counters.ipc() > 0)
+        {
+            values.insert("ipc", counters.ipc());
+        }
+        return values;
+    };
+    for (const PhaseCounters &value : m_hardware)
+    {
+        QString phase(QString::fromStdString(value.phase));
+        if (hardware.contains(phase))
+        {
+            continue;
+        }
+
+        QJsonObject summary(countersToJson(getHardwareCounters(value.phase)));
+        QJsonArray threads;
+        for (const PhaseCounters &thread : m_hardware)
+        {
+            if (thread.phase == value.phase)
+            {
+                QJsonObject values(countersToJson(thread.counters));
+                values.insert("thread", static_cast<double>(thread.thread));
+                threads.append(values);
+            }
+        }
+        summary.insert("threads", threads);
+        hardware.insert(phase, summary);
+    }
+
+    QJsonObject snapshot;
+    snapshot.insert("timers", timers);
+    snapshot.insert("counters", counters);
+    snapshot.insert("gauges", gauges);
+    snapshot.insert("histograms", histograms);
+    snapshot.insert("commands", commands);
+    snapshot.insert("hardware", hardware);
+    return QJsonDocument(snapshot).toJson(QJsonDocument::Compact).toStdString();
+}
+
+void Metrics::add(std::vector<std::pair<std::string, unsigned long>> &values,
+                  const char *name,
+                  unsigned long amount)
+{
+    // There are only a handful of names, so a linear search beats any map
+    for (std::pair<std::string, unsigned long> &value : values)
+    {
+        if (value.first == name)
+        {
+            value.second += amount;
+            return;
+        }
+    }
+    values.push_back(std::make_pair(std::string(name), amount));
+}
+
+void Metrics::set(std::vector<std::pair<std::string, double>> &values,
+                  const char *name,
+                  double value)
+{
+    for (std::pair<std::string, double> &current : values)
+    {
+        if (current.first == name)
+        {
+            current.second = value;
+            return;
+        }
+    }
+    values.push_back(std::make_pair(std::string(name), value));
+}
+
+void Metrics::merge(std::vector<std::pair<std::string, Histogram>> &values,
+                    const char *name,
+                    const Histogram &samples)
+{
+    for (std::pair<std::string, Histogram> &current : values)
+    {
+        if (current.first == name)
+        {
+            current.second.merge(samples);
+            return;
+        }
+    }
+    values.push_back(std::make_pair(std::string(name), samples));
+}
@@ -0,0 +1,301 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metrics/devicecommand.h>
+#include <metrics/histogram.h>
+#include <metrics/perfcounters.h>
+
+/**
+* @brief Registry of the measurements of an engine: timers (nanoseconds per
+* phase, in the order they were run), counters (accumulated by name), gauges
+* (last value by name), histograms (merged by name), the commands run by a
+* device, in the order they were enqueued, and optionally the hardware
+* counters of each thread of each phase.
+*
+* Nothing is recorded until it's enabled, and every method returns right away
+* while it's disabled. Building with QLEPP2D_NO_METRICS turns isEnabled()
+* into a constant, so the compiler removes the collection altogether.
+*
+*/
+class Metrics
+{
+public:
+    /**
+    * @brief Constructor of Metrics. It starts disabled.
+    *
+    */
+    Metrics();
+
+    /**
+    * @brief Enables or disables the collection. Already collected values are kept.
+    *
+    * @param enabled p_enabled: True to collect.
+    */
+    void setEnabled(bool enabled);
+
+    /**
+    * @brief Checks if values are being collected.
+    *
+    * @return True if enabled.
+    */
+    inline bool isEnabled() const
+    {
+#ifdef QLEPP2D_NO_METRICS
+        return false;
+#else
+        return m_enabled;
+#endif
+    }
+
+    /**
+    * @brief Enables or disables the hardware counters of the phases. They're
+    * only collected while the metrics are enabled too.
+    *
+    * @param enabled p_enabled: True to count.
+    */
+    void setHardwareCountersEnabled(bool enabled);
+
+    /**
+    * @brief Checks if hardware counters are being collected.
+    *
+    * @return True if enabled, along with the metrics.
+    */
+    inline bool hasHardwareCounters() const
+    {
+        return isEnabled() and m_hardwareCounters;
+    }
+
+    /**
+    * @brief Records the time of a phase.
+    *
+    * @param phase p_phase: Name of the phase.
+    * @param nanoseconds p_nanoseconds: Elapsed time.
+    */
+    inline void addTime(const char *phase, long long nanoseconds)
+    {
+        if (isEnabled())
+        {
+            m_timings.push_back(std::make_pair(std::string(phase), nanoseconds));
+        }
+    }
+
+    /**
+    * @brief Adds to a counter.
+    *
+    * @param counter p_counter: Name of the counter.
+    * @param amount p_amount: Amount to add.
+    */
+    inline void addCount(const char *counter, unsigned long amount)
+    {
+        if (isEnabled())
+        {
+            add(m_counters, counter, amount);
+        }
+    }
+
+    /**
+    * @brief Sets the value of a gauge.
+    *
+    * @param gauge p_gauge: Name of the gauge.
+    * @param value p_value: New value.
+    */
+    inline void setGauge(const char *gauge, double value)
+    {
+        if (isEnabled())
+        {
+            set(m_gauges, gauge, value);
+        }
+    }
+
+    /**
+    * @brief Adds samples to a histogram.
+    *
+    * @param histogram p_histogram: Name of the histogram.
+    * @param samples p_samples: Samples to add.
+    */
+    inline void addSamples(const char *histogram, const Histogram &samples)
+    {
+        if (isEnabled())
+        {
+            merge(m_histograms, histogram, samples);
+        }
+    }
+
+    /**
+    * @brief Records a command run by a device.
+    *
+    * @param command p_command: Profiled command.
+    */
+    inline void addCommand(const DeviceCommand &command)
+    {
+        if (isEnabled())
+        {
+            m_commands.push_back(command);
+        }
+    }
+
+    /**
+    * @brief Hardware counters of a thread during a phase.
+    *
+    */
+    struct PhaseCounters
+    {
+        std::string phase;
+        unsigned int thread;
+        HardwareCounters counters;
+    };
+
+    /**
+    * @brief Records the hardware counters of a thread during a phase.
+    *
+    * @param phase p_phase: Name of the phase, like its timer.
+    * @param thread p_thread: Index of the thread in the phase.
+    * @param counters p_counters: Counted values.
+    */
+    inline void addHardwareCounters(const char *phase, unsigned int thread, const HardwareCounters &counters)
+    {
+        if (hasHardwareCounters())
+        {
+            m_hardware.push_back(PhaseCounters{std::string(phase), thread, counters});
+        }
+    }
+
+    /**
+    * @brief Adds the timers, counters, histograms, commands and hardware
+    * counters of other metrics, and takes its gauges.
+    *
+    * @param other p_other: Metrics to merge.
+    */
+    void merge(const Metrics &other);
+
+    /**
+    * @brief Forgets every collected value.
+    *
+    */
+    void clear();
+
+    /**
+    * @brief Gets the timers.
+    *
+    * @return Vector of pairs (name of the phase, nanoseconds), in the order they were run.
+    */
+    const std::vector<std::pair<std::string, long long>>& getTimings() const;
+
+    /**
+    * @brief Gets the counters.
+    *
+    * @return Vector of pairs (name of the counter, value), in the order they were created.
+    */
+    const std::vector<std::pair<std::string, unsigned long>>& getCounters() const;
+
+    /**
+    * @brief Gets the gauges.
+    *
+    * @return Vector of pairs (name of the gauge, value), in the order they were created.
+    */
+    const std::vector<std::pair<std::string, double>>& getGauges() const;
+
+    /**
+    * @brief Gets the histograms.
+    *
+    * @return Vector of pairs (name of the histogram, histogram), in the order they were created.
+    */
+    const std::vector<std::pair<std::string, Histogram>>& getHistograms() const;
+
+    /**
+    * @brief Gets the commands run by a device.
+    *
+    * @return Vector of commands, in the order they were enqueued.
+    */
+    const std::vector<DeviceCommand>& getCommands() const;
+
+    /**
+    * @brief Gets the hardware counters of every thread of every phase.
+    *
+    * @return Vector of counters, in the order the phases ended.
+    */
+    const std::vector<PhaseCounters>& getHardwareCounters() const;
+
+    /**
+    * @brief Gets the hardware counters of a phase, added over its threads
+    * (and its runs).
+    *
+    * @param phase p_phase: Name of the phase.
+    * @return The sum. Nothing is available if the phase wasn't counted.
+    */
+    HardwareCounters getHardwareCounters(const std::string &phase) const;
+
+    /**
+    * @brief Gets a histogram.
+    *
+    * @param histogram p_histogram: Name of the histogram.
+    * @return The histogram, or an empty one if it doesn't exist.
+    */
+    Histogram getHistogram(const std::string &histogram) const;
+
+    /**
+    * @brief Gets the value of a counter.
+    *
+    * @param counter p_counter: Name of the counter.
+    * @return Value of the counter, or 0 if it doesn't exist.
+    */
+    unsigned long getCount(const std::string &counter) const;
+
+    /**
+    * @brief Exports the collected values as a JSON object with "timers"
+    * (total nanoseconds of each phase), "counters", "gauges", "histograms"
+    * (count, min, mean, p50, p90, p99 and max of each one) and "commands"
+    * (name, kind, bytes, queued, submit, start and end of each one, plus the
+    * bandwidth of transfers in GB/s). Hardware counters go in "hardware", by
+    * phase: the available counters added over the threads, the IPC, and the
+    * same for each thread in "threads".
+    *
+    * @return Compact JSON text.
+    */
+    std::string toJson() const;
+
+private:
+    static void add(std::vector<std::pair<std::string, unsigned long>> &values,
+                    const char *name,
+                    unsigned long amount);
+    static void set(std::vector<std::pair<std::string, double>> &values,
+                    const char *name,
+                    double value);
+    static void merge(std::vector<std::pair<std::string, Histogram>> &values,
+                      const char *name,
+                      const Histogram &samples);
+
+    bool m_enabled;
+    bool m_hardwareCounters;
+    std::vector<std::pair<std::string, long long>> m_timings;
+    std::vector<std::pair<std::string, unsigned long>> m_counters;
+    std::vector<std::pair<std::string, double>> m_gauges;
+    std::vector<std::pair<std::string, Histogram>> m_histograms;
+    std::vector<DeviceCommand> m_commands;
+    std::vector<PhaseCounters> m_hardware;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,206 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtGlobal>
+
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <metrics/perfcounters.h>
+
+namespace
+{
+#ifdef Q_OS_LINUX
+    /**
+    * @brief Opens a disabled counter of the calling thread, on any CPU.
+    *
+    * @return File descriptor, or -1 if it isn't available.
+    */
+    int openCounter(HardwareCounters::Counter counter)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const unsigned long long readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (counter)
+        {
+        case HardwareCounters::Cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case HardwareCounters::Instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case HardwareCounters::LLCMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | readMiss;
+            break;
+        case HardwareCounters::DTLBMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+            break;
+        case HardwareCounters::BranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            return -1;
+        }
+
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return static_cast<int>(fd);
+    }
+#endif
+}
+
+const char* HardwareCounters::name(Counter counter)
+{
+    switch (counter)
+    {
+    case Cycles:
+        return "cycles";
+    case Instructions:
+        return "instructions";
+    case LLCMisses:
+        return "llc_misses";
+    case DTLBMisses:
+        return "dtlb_misses";
+    case BranchMisses:
+        return "branch_misses";
+    default:
+        return "";
+    }
+}
+
+void HardwareCounters::add(const HardwareCounters &other)
+{
+    for (int counter(0); counter < Count; counter++)
+    {
+        values[counter] += other.values[counter];
+        available[counter] = (available[counter] or other.available[counter]);
+    }
+}
+
+double HardwareCounters::ipc() const
+{
+    if (not available[Cycles] or not available[Instructions] or values[Cycles] == 0)
+    {
+        return 0;
+    }
+    return static_cast<double>(values[Instructions]) / values[Cycles];
+}
+
+PerfCounters::PerfCounters()
+{
+    for (int counter(0); counter < HardwareCounters::Count; counter++)
+    {
+        m_fds[counter] = -1;
+#ifdef Q_OS_LINUX
+        m_fds[counter] = openCounter(static_cast<HardwareCounters::Counter>(counter));
+#endif
+    }
+
+    // Started together, after every open, so they measure the same interval
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+HardwareCounters PerfCounters::stop()
+{
+    HardwareCounters counters;
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (int counter(0); counter < HardwareCounters::Count; counter++)
+    {
+        int &fd(m_fds[counter]);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        // Value, time enabled and time running
+        unsigned long long data[3] = {0, 0, 0};
+        if (read(fd, data, sizeof(data)) == static_cast<ssize_t>(sizeof(data)) and data[2] > 0)
+        {
+            double scale = static_cast<double>(data[1]) / data[2];
+            counters.values[counter] = static_cast<unsigned long long>(data[0] * scale);
+            counters.available[counter] = true;
+        }
+        close(fd);
+        fd = -1;
+    }
+#endif
+    return counters;
+}
+
+bool PerfCounters::isSupported()
+{
+    static const bool supported = []() {
+        PerfCounters probe;
+        for (int fd : probe.m_fds)
+        {
+            if (fd >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+}
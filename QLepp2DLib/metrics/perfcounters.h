@@ -0,0 +1,116 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+/**
+* @brief Values of the hardware performance counters of a thread (or the sum
+* of several threads) during a phase.
+*
+*/
+struct HardwareCounters
+{
+    /**
+    * @brief Counted hardware events.
+    *
+    */
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        LLCMisses,      // Last level cache read misses
+        DTLBMisses,     // Data TLB read misses
+        BranchMisses,
+        Count
+    };
+
+    unsigned long long values[Count] = {};
+    bool available[Count] = {};
+
+    /**
+    * @brief Gets the name of a counter.
+    *
+    * @param counter p_counter: Counter.
+    * @return "cycles", "instructions", "llc_misses", "dtlb_misses" or "branch_misses".
+    */
+    static const char* name(Counter counter);
+
+    /**
+    * @brief Adds the values of another thread. A counter is available if it
+    * was available in any of them.
+    *
+    * @param other p_other: Counters to add.
+    */
+    void add(const HardwareCounters &other);
+
+    /**
+    * @brief Gets the instructions per cycle.
+    *
+    * @return IPC, or 0 if cycles or instructions aren't available.
+    */
+    double ipc() const;
+};
+
+/**
+* @brief Counts hardware events of the calling thread, from its construction
+* until stop(), with Linux perf_event_open (user space only).
+*
+* Every counter is opened on its own, so the ones the CPU, the kernel
+* (perf_event_paranoid) or a container don't allow are just unavailable, and
+* the others are still counted. Counters multiplexed by the kernel are scaled
+* to the whole interval. Nothing is counted on other systems.
+*
+*/
+class PerfCounters
+{
+public:
+    /**
+    * @brief Opens and starts the counters of the calling thread.
+    *
+    */
+    PerfCounters();
+
+    /**
+    * @brief Closes the counters.
+    *
+    */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+    * @brief Stops counting and reads the counters.
+    *
+    * @return Values of the available counters.
+    */
+    HardwareCounters stop();
+
+    /**
+    * @brief Checks (once) if any counter can be opened in this system.
+    *
+    * @return True if at least one counter is available.
+    */
+    static bool isSupported();
+
+private:
+    int m_fds[HardwareCounters::Count];
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,102 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPEDTIMER_H
+#define SCOPEDTIMER_H
+
+#include <QElapsedTimer>
+
+#include <metrics/allocationtracker.h>
+#include <metrics/metrics.h>
+#include <metrics/tracer.h>
+
+/**
+* @brief Records the time of a scope (a phase) in a Metrics registry when it
+* ends, and as a span of the trace while tracing. The clock isn't even read
+* while both are disabled. The phase is also the allocation phase of the
+* thread while in scope.
+*
+*/
+class ScopedTimer
+{
+public:
+    /**
+    * @brief Starts timing a phase.
+    *
+    * @param metrics p_metrics: Registry of the time.
+    * @param phase p_phase: Name of the phase. Must be a string literal.
+    * @param category p_category: Category of the span in the trace. Must be a string literal.
+    */
+    ScopedTimer(Metrics &metrics, const char *phase, const char *category = "engine")
+        : m_metrics(metrics),
+          m_phase(phase),
+          m_category(category),
+          m_enabled(metrics.isEnabled()),
+          m_traceBegin(Tracer::getInstance().isEnabled() ? Tracer::getInstance().now() : -1),
+          m_allocations(phase)
+    {
+        if (m_enabled)
+        {
+            m_timer.start();
+        }
+    }
+
+    /**
+    * @brief Records the elapsed time.
+    *
+    */
+    ~ScopedTimer()
+    {
+        stop();
+    }
+
+    /**
+    * @brief Records the elapsed time before the scope ends. Later calls (and
+    * the destructor) don't record anything else.
+    *
+    */
+    void stop()
+    {
+        if (m_enabled)
+        {
+            m_metrics.addTime(m_phase, m_timer.nsecsElapsed());
+            m_enabled = false;
+        }
+        if (m_traceBegin >= 0)
+        {
+            Tracer &tracer(Tracer::getInstance());
+            tracer.addSpan(m_phase, m_category, m_traceBegin, tracer.now());
+            m_traceBegin = -1;
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer& operator=(const ScopedTimer &) = delete;
+
+private:
+    Metrics &m_metrics;
+    const char *m_phase;
+    const char *m_category;
+    bool m_enabled;
+    long long m_traceBegin;
+    QElapsedTimer m_timer;
+    AllocationScope m_allocations;
+};
+
+#endif // SCOPEDTIMER_H
@@ -0,0 +1,149 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QTextStream>
+
+#include <chrono>
+
+#include <metrics/tracer.h>
+
+namespace
+{
+    long long steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+Tracer& Tracer::getInstance()
+{
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer()
+    : m_enabled(false),
+      m_nextTrack(1),
+      m_origin(steadyNanoseconds())
+{
+}
+
+bool Tracer::start(std::string filepath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_enabled.load())
+    {
+        return false;
+    }
+    m_filepath = filepath;
+    m_spans.clear();
+    m_origin.store(steadyNanoseconds());
+    m_enabled.store(true);
+    return true;
+}
+
+bool Tracer::stop()
+{
+    std::vector<Span> spans;
+    std::string filepath;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (not m_enabled.load())
+        {
+            return false;
+        }
+        m_enabled.store(false);
+        spans.swap(m_spans);
+        filepath = m_filepath;
+    }
+
+    QFile file(QString::fromStdString(filepath));
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        return false;
+    }
+
+    // Complete events ("X"), with times in microseconds
+    QTextStream out(&file);
+    out.setRealNumberPrecision(15);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << endl;
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"QLepp2D\"}}";
+
+    // Names of the tracks
+    std::set<int> tracks;
+    for (const Span &span : spans)
+    {
+        tracks.insert(span.track);
+    }
+    for (int track : tracks)
+    {
+        QString name = (track == DEVICE_TRACK) ? QString("OpenCL device") :
+                       (track >= WORKER_TRACK) ? QString("CPU worker %1").arg(track - WORKER_TRACK) :
+                                                 QString("Thread %1").arg(track);
+        out << "," << endl
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+            << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+
+    for (const Span &span : spans)
+    {
+        out << "," << endl
+            << "{\"name\":\"" << span.name
+            << "\",\"cat\":\"" << span.category
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.track
+            << ",\"ts\":" << span.begin / 1000.0
+            << ",\"dur\":" << (span.end - span.begin) / 1000.0 << "}";
+    }
+    out << endl << "]}" << endl;
+
+    file.close();
+    return true;
+}
+
+long long Tracer::now() const
+{
+    return steadyNanoseconds() - m_origin.load();
+}
+
+void Tracer::addSpan(const char *name, const char *category, long long begin, long long end)
+{
+    addSpan(currentTrack(), name, category, begin, end);
+}
+
+void Tracer::addSpan(int track, const char *name, const char *category, long long begin, long long end)
+{
+    if (not isEnabled())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_spans.push_back(Span{name, category, begin, end, track});
+}
+
+int Tracer::currentTrack()
+{
+    thread_local int track(0);
+    if (track == 0)
+    {
+        track = m_nextTrack.fetch_add(1);
+    }
+    return track;
+}
@@ -0,0 +1,186 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+* @brief Process-wide timeline of the library, written as a Chrome trace
+* (JSON) that opens in chrome://tracing or in Perfetto.
+*
+* Spans are recorded per thread while tracing is started. Device intervals
+* (OpenCL profiling events) go to their own track. While stopped, spans only
+* cost a relaxed atomic load.
+*
+*/
+class Tracer
+{
+public:
+    /**
+    * @brief Track of the spans measured by the OpenCL device.
+    *
+    */
+    static const int DEVICE_TRACK = 0;
+
+    /**
+    * @brief First track of the workers of a parallel phase. Workers are
+    * short-lived threads, so they use the track of their index instead of
+    * getting a new one each time.
+    *
+    */
+    static const int WORKER_TRACK = 1000;
+
+    /**
+    * @brief Gets the tracer of the process.
+    *
+    * @return Tracer instance.
+    */
+    static Tracer& getInstance();
+
+    /**
+    * @brief Starts recording spans. Spans of a previous trace are discarded.
+    *
+    * @param filepath p_filepath: Path of the trace written by stop().
+    * @return True if started (false if it was already running).
+    */
+    bool start(std::string filepath);
+
+    /**
+    * @brief Stops recording and writes the trace.
+    *
+    * @return True if correctly written.
+    */
+    bool stop();
+
+    /**
+    * @brief Checks if spans are being recorded.
+    *
+    * @return True if tracing.
+    */
+    inline bool isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * @brief Gets the time since the start of the trace.
+    *
+    * @return Nanoseconds.
+    */
+    long long now() const;
+
+    /**
+    * @brief Records a span of the calling thread.
+    *
+    * @param name p_name: Name of the span. Must be a string literal.
+    * @param category p_category: Category (cpu, opencl, io). Must be a string literal.
+    * @param begin p_begin: Start, as given by now().
+    * @param end p_end: End, as given by now().
+    */
+    void addSpan(const char *name, const char *category, long long begin, long long end);
+
+    /**
+    * @brief Records a span of a given track.
+    *
+    * @param track p_track: Track of the span, like DEVICE_TRACK.
+    * @param name p_name: Name of the span. Must be a string literal.
+    * @param category p_category: Category. Must be a string literal.
+    * @param begin p_begin: Start, as given by now().
+    * @param end p_end: End, as given by now().
+    */
+    void addSpan(int track, const char *name, const char *category, long long begin, long long end);
+
+private:
+    struct Span
+    {
+        const char *name;
+        const char *category;
+        long long begin;
+        long long end;
+        int track;
+    };
+
+    Tracer();
+
+    /**
+    * @brief Gets the track of the calling thread. Threads are numbered from 1
+    * in the order they record their first span.
+    *
+    * @return Track of the thread.
+    */
+    int currentTrack();
+
+    std::atomic<bool> m_enabled;
+    std::atomic<int> m_nextTrack;
+    std::mutex m_mutex;
+    std::string m_filepath;
+    std::vector<Span> m_spans;
+    std::atomic<long long> m_origin;   // Read without the lock by now()
+};
+
+/**
+* @brief Records a span of the calling thread from its construction to the end
+* of its scope.
+*
+*/
+class TraceSpan
+{
+public:
+    /**
+    * @brief Starts the span.
+    *
+    * @param name p_name: Name of the span. Must be a string literal.
+    * @param category p_category: Category. Must be a string literal.
+    */
+    TraceSpan(const char *name, const char *category)
+        : m_name(name),
+          m_category(category),
+          m_begin(Tracer::getInstance().isEnabled() ? Tracer::getInstance().now() : -1)
+    {
+    }
+
+    /**
+    * @brief Ends the span.
+    *
+    */
+    ~TraceSpan()
+    {
+        if (m_begin >= 0)
+        {
+            Tracer &tracer(Tracer::getInstance());
+            tracer.addSpan(m_name, m_category, m_begin, tracer.now());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan& operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    const char *m_category;
+    long long m_begin;
+};
+
+#endif // TRACER_H
@@ -21,17 +21,22 @@
 #include <model_impl.h>
 
 Model::Model()
-    : m_impl(&ModelImpl::getInstance())
+    : m_impl(new ModelImpl)
 {
 }
 
+Model::~Model()
+{
+    delete m_impl;
+}
+
 bool Model::setCPUEngine()
 {
     return m_impl->setCPUEngine();
 }
-bool Model::setOpenCLEngine()
+bool Model::setOpenCLEngine(unsigned long platform_id, unsigned long device_id)
 {
-    return m_impl->setOpenCLEngine();
+    return m_impl->setOpenCLEngine(platform_id, device_id);
 }
 
 bool Model::loadFile(std::string filepath)
@@ -39,22 +44,53 @@ bool Model::loadFile(std::string filepath)
     return m_impl->loadFile(filepath);
 }
 
+bool Model::loadPoints(const Vertex *points, unsigned long count)
+{
+    return m_impl->loadPoints(points, count);
+}
+
+bool Model::generateRandomMesh(unsigned long points, unsigned long seed)
+{
+    return m_impl->generateRandomMesh(points, seed);
+}
+
 bool Model::saveFile(std::string filepath)
 {
     return m_impl->saveFile(filepath);
 }
 
-std::vector<Vertex>& Model::getVertices()
+std::shared_future<bool> Model::loadFileAsync(std::string filepath,
+                                              ProgressCallback progress,
+                                              CancellationToken token,
+                                              ChunkCallback chunks)
+{
+    return m_impl->loadFileAsync(filepath, progress, token, chunks);
+}
+
+std::shared_future<bool> Model::saveFileAsync(std::string filepath)
+{
+    return m_impl->saveFileAsync(filepath);
+}
+
+BatchReport Model::processBatch(const std::vector<BatchJob> &jobs,
+                                float angle,
+                                unsigned long rounds,
+                                unsigned int concurrency)
+{
+    return m_impl->processBatch(jobs, angle, rounds, concurrency);
+}
+
+MeshVector<Vertex>& Model::getVertices()
 {
     return m_impl->getVertices();
 }
 
-std::vector<Edge>& Model::getEdges()
+MeshVector<Edge>& Model::getEdges()
 {
     return m_impl->getEdges();
 }
 
-std::vector<Triangle>& Model::getTriangles()
+MeshVector<Triangle>& Model::getTriangles()
 {
     return m_impl->getTriangles();
 }
@@ -68,3 +104,86 @@ bool Model::improveTriangulation()
 {
     return m_impl->improveTriangulation();
 }
+
+std::shared_future<bool> Model::detectBadTrianglesAsync(float angle,
+                                                        ProgressCallback progress,
+                                                        CancellationToken token)
+{
+    return m_impl->detectBadTrianglesAsync(angle, progress, token);
+}
+
+std::shared_future<bool> Model::improveTriangulationAsync(ProgressCallback progress,
+                                                          CancellationToken token)
+{
+    return m_impl->improveTriangulationAsync(progress, token);
+}
+
+bool Model::setOutOfCore(std::string directory)
+{
+    return m_impl->setOutOfCore(directory);
+}
+
+void Model::setCacheEnabled(bool enabled)
+{
+    m_impl->setCacheEnabled(enabled);
+}
+
+bool Model::purgeCache(std::string filepath)
+{
+    return m_impl->purgeCache(filepath);
+}
+
+unsigned long Model::getInsertionCount() const
+{
+    return m_impl->getInsertionCount();
+}
+
+const ChangeSet& Model::getChanges() const
+{
+    return m_impl->getChanges();
+}
+
+MemoryReport Model::getMemoryReport() const
+{
+    return m_impl->getMemoryReport();
+}
+
+void Model::setMetricsEnabled(bool enabled)
+{
+    m_impl->setMetricsEnabled(enabled);
+}
+
+bool Model::setHardwareCountersEnabled(bool enabled)
+{
+    return m_impl->setHardwareCountersEnabled(enabled);
+}
+
+const Metrics& Model::getMetrics() const
+{
+    return m_impl->getMetrics();
+}
+
+bool Model::startTrace(std::string filepath)
+{
+    return m_impl->startTrace(filepath);
+}
+
+bool Model::stopTrace()
+{
+    return m_impl->stopTrace();
+}
+
+bool Model::startJournal(std::string filepath)
+{
+    return m_impl->startJournal(filepath);
+}
+
+bool Model::resumeJournal(std::string filepath)
+{
+    return m_impl->resumeJournal(filepath);
+}
+
+void Model::stopJournal()
+{
+    m_impl->stopJournal();
+}
@@ -21,18 +21,32 @@
 #define MODEL_H
 
 //#include <qlepp2dlib_global.h>
+#include <future>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <structs/vertex.h>
 #include <structs/edge.h>
 #include <structs/triangle.h>
+#include <structs/meshvector.h>
+#include <structs/batch.h>
+#include <structs/memoryreport.h>
+#include <engine/changeset.h>
+#include <engine/progress.h>
+#include <filehandlers/filehandler.h>
+#include <metrics/metrics.h>
 
 class ModelImpl;
 
 /**
 * @brief API for QLepp2D.
 *
+* Every Model has its own mesh and engine, so different instances can be used
+* concurrently from different threads (each instance by one thread at a
+* time). Only thread-safe resources are shared: the compiled OpenCL program
+* of each platform and the trace.
+*
 */
 //class QLEPP2DLIBSHARED_EXPORT Model
 class Model
@@ -44,6 +58,15 @@ public:
      */
     Model();
 
+    /**
+     * @brief Model Destructor. Waits for the saves that are still running.
+     *
+     */
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     /**
     * @brief Convenience method that sets the CPU Engine.
     *
@@ -54,46 +77,122 @@ public:
     /**
      * @brief Convenience method that sets the OpenCL Engine.
      *
+     * @param platform_id p_platform_id: Index of the OpenCL platform (vendor).
+     * @param device_id p_device_id: Index of the device in that platform.
      * @return True if correctly set.
      */
-    bool setOpenCLEngine();
+    bool setOpenCLEngine(unsigned long platform_id = 0, unsigned long device_id = 0);
 
     /**
     * @brief Loads a mesh file so the inner implementation can receive the triangles.
     *
-    * @param filepath p_filepath: Path of the file.
+    * @param filepath p_filepath: Path of the file. "-" reads an OFF mesh from the standard input.
     * @return True if correctly loaded.
     */
     bool loadFile(std::string filepath);
 
     /**
-    * @brief Saves a mesh file in the provided filepath.
+    * @brief Runs loadFile in a background thread. The Model must not be used
+    * until the future is ready.
+    * Progress is reported for each phase (LOAD_V, LOAD_T and LOAD_E), and the
+    * partial mesh after each chunk of triangles, so it can be shown before
+    * its edges are built. A failed or cancelled load returns false, and keeps
+    * the previous triangulation.
     *
     * @param filepath p_filepath: Path of the file.
+    * @param progress p_progress: Receiver of the progress.
+    * @param token p_token: Copy of a token that the caller may cancel.
+    * @param chunks p_chunks: Receiver of the vertices and triangles parsed so
+    * far (loads from the cache and XYZ files only send the progress).
+    * @return Future that becomes true if correctly loaded.
+    */
+    std::shared_future<bool> loadFileAsync(std::string filepath,
+                                           ProgressCallback progress = ProgressCallback(),
+                                           CancellationToken token = CancellationToken(),
+                                           ChunkCallback chunks = ChunkCallback());
+
+    /**
+    * @brief Replaces the triangulation with the Delaunay mesh of an in-memory
+    * point cloud. Duplicated points are dropped, and the z coordinate is kept
+    * but ignored by the triangulation.
+    *
+    * @param points p_points: Array of points.
+    * @param count p_count: Number of points in the array.
+    * @return True if correctly triangulated (at least 3 non-collinear points).
+    */
+    bool loadPoints(const Vertex *points, unsigned long count);
+
+    /**
+    * @brief Replaces the triangulation with the Delaunay mesh of uniformly random
+    * points in [-1, 1] x [-1, 1]. The same seed always gives the same mesh.
+    *
+    * @param points p_points: Number of random points. The mesh has about twice as many triangles.
+    * @param seed p_seed: Seed of the generator.
+    * @return True if correctly generated.
+    */
+    bool generateRandomMesh(unsigned long points, unsigned long seed = 1);
+
+    /**
+    * @brief Saves a mesh file in the provided filepath.
+    *
+    * @param filepath p_filepath: Path of the file. "-" writes an OFF mesh to the standard output.
     * @return True if correctly saved.
     */
     bool saveFile(std::string filepath);
 
+    /**
+    * @brief Saves a snapshot of the actual triangulation in a background thread.
+    * The triangulation can keep being improved while the file is written.
+    * Errors are reported as a false result, or as the exception thrown by get().
+    * The snapshot is a full copy of the vectors, taken after any pending
+    * asynchronous refinement: it needs as much memory (or disk, out-of-core)
+    * as the mesh until the file is written.
+    *
+    * @param filepath p_filepath: Path of the file.
+    * @return Future that becomes true if correctly saved.
+    */
+    std::shared_future<bool> saveFileAsync(std::string filepath);
+
+    /**
+    * @brief Refines many mesh files with the actual engine. Files are parsed
+    * and written by other threads while the engine refines, so the engine is
+    * set up only once and is never idle waiting for the disk.
+    * The loaded triangulation isn't modified, but bad triangles must be
+    * detected again before improving it.
+    *
+    * @param jobs p_jobs: Input and output path of each mesh.
+    * @param angle p_angle: Minimum angle of a good triangle.
+    * @param rounds p_rounds: Maximum improvement rounds per mesh. 0 refines
+    * until no centroid can be inserted.
+    * @param concurrency p_concurrency: Number of parsing threads, of writing
+    * threads, and of meshes that can wait between stages.
+    * @return Outcome of each job, plus meshes/s and triangles/s of the batch.
+    */
+    BatchReport processBatch(const std::vector<BatchJob> &jobs,
+                             float angle,
+                             unsigned long rounds = 0,
+                             unsigned int concurrency = 1);
+
     /**
     * @brief Gets a vector of Vertex which are being used by the implementation.
     *
-    * @return std::vector< Vertex >& Reference to the actual vector of vertices.
+    * @return MeshVector< Vertex >& Reference to the actual vector of vertices.
     */
-    std::vector<Vertex>& getVertices();
+    MeshVector<Vertex>& getVertices();
 
     /**
     * @brief Gets a vector of Edges which are being used by the implementation.
     *
-    * @return std::vector< Edge >& Reference to the actual vector of edges.
+    * @return MeshVector< Edge >& Reference to the actual vector of edges.
     */
-    std::vector<Edge>& getEdges();
+    MeshVector<Edge>& getEdges();
 
     /**
     * @brief Gets a vector of Triangles which are being used by the implementation.
     *
-    * @return std::vector< Triangle >& Reference to the actual vector of triangles.
+    * @return MeshVector< Triangle >& Reference to the actual vector of triangles.
     */
-    std::vector<Triangle>& getTriangles();
+    MeshVector<Triangle>& getTriangles();
 
     /**
     * @brief Detects every triangle in the vector of triangles whose minimum angle is lesser than the provided angle.
@@ -110,6 +209,177 @@ public:
     */
     bool improveTriangulation();
 
+    /**
+    * @brief Runs detectBadTriangles in a background thread. The Model must not
+    * be used until the future is ready.
+    * Progress is reported after each chunk of triangles (phase DBT_F).
+    * A cancelled detection returns false, and leaves some bad flags stale, so
+    * the next improvement detects them again before starting.
+    *
+    * @param angle p_angle: Provided angle.
+    * @param progress p_progress: Receiver of the progress. It may be called
+    * from the worker threads of the engine.
+    * @param token p_token: Copy of a token that the caller may cancel.
+    * @return Future that becomes true if the detection completed.
+    */
+    std::shared_future<bool> detectBadTrianglesAsync(float angle,
+                                                     ProgressCallback progress = ProgressCallback(),
+                                                     CancellationToken token = CancellationToken());
+
+    /**
+    * @brief Runs improveTriangulation in a background thread. The Model must
+    * not be used until the future is ready.
+    * Progress is reported for each phase (DTE_F, IC_F and DBT_F).
+    * A cancelled improvement returns false, but the mesh stays consistent: the
+    * centroids inserted so far are kept (and journaled), and the bad
+    * triangles are detected again by the next improvement.
+    *
+    * @param progress p_progress: Receiver of the progress. It may be called
+    * from the worker threads of the engine.
+    * @param token p_token: Copy of a token that the caller may cancel.
+    * @return Future that becomes true if the improvement completed.
+    */
+    std::shared_future<bool> improveTriangulationAsync(ProgressCallback progress = ProgressCallback(),
+                                                       CancellationToken token = CancellationToken());
+
+    /**
+    * @brief Gets the number of centroids inserted by the last improvement.
+    *
+    * @return Number of insertions. 0 means the triangulation can't be improved
+    * anymore for the actual angle.
+    */
+    unsigned long getInsertionCount() const;
+
+    /**
+    * @brief Gets the positions of the vectors modified by the last improvement:
+    * the old edges and triangles that were rewritten, plus the new elements
+    * (every position from the "first" indices onwards). Views can refresh only
+    * those positions instead of the whole mesh.
+    *
+    * @return Changes of the last improvement.
+    */
+    const ChangeSet& getChanges() const;
+
+    /**
+    * @brief Gets the memory held by the vectors (size and capacity), by the
+    * buffers of the engine in its device, and by the temporaries of the last
+    * load. It also predicts the memory of the next improvement round, from
+    * the bad triangles (each one leads to one insertion at most), so a round
+    * that won't fit can be skipped before it starts (see nextRoundFits()).
+    *
+    * @return Memory report.
+    */
+    MemoryReport getMemoryReport() const;
+
+    /**
+    * @brief Enables or disables the collection of metrics, for this engine and
+    * the next ones. They're disabled by default, and cost nothing until then.
+    *
+    * @param enabled p_enabled: True to collect them.
+    */
+    void setMetricsEnabled(bool enabled);
+
+    /**
+    * @brief Enables or disables the hardware performance counters (cycles,
+    * instructions, LLC, dTLB and branch misses) of each thread of the CPU
+    * phases, for this engine and the next ones. They're only collected while
+    * the metrics are enabled, and need Linux perf_event_open.
+    *
+    * @param enabled p_enabled: True to count.
+    * @return False if no counter is available (e.g. perf_event_paranoid or a
+    * container forbids them). Metrics keep working without them.
+    */
+    bool setHardwareCountersEnabled(bool enabled);
+
+    /**
+    * @brief Gets the metrics of the last detection or improvement. Timers (in
+    * the order they were run) are DBT_F, DTE_F and IC_F (full time of each
+    * phase), plus DBT_A and DTE_A (OpenCL kernel time). Counters are
+    * bad_triangles, terminal_edges, border_terminal_edges and insertions, and
+    * gauges are the vertices, edges and triangles of the mesh. If the
+    * application counts allocations (see AllocationTracker), the counters
+    * allocations.<phase> and allocated_bytes.<phase> have the heap allocations
+    * of each library phase during the call.
+    *
+    * @return Metrics registry. Its toJson() gives a snapshot.
+    */
+    const Metrics& getMetrics() const;
+
+    /**
+    * @brief Starts recording a timeline of the library: phases of the engines
+    * (and their worker threads), OpenCL copies, waits and kernel executions,
+    * and file I/O. The trace is shared by every Model of the process.
+    *
+    * @param filepath p_filepath: Chrome trace (JSON) written by stopTrace,
+    * which opens in chrome://tracing or Perfetto.
+    * @return True if started (false if a trace is already running).
+    */
+    bool startTrace(std::string filepath);
+
+    /**
+    * @brief Stops recording the timeline and writes the trace.
+    *
+    * @return True if correctly written.
+    */
+    bool stopTrace();
+
+    /**
+    * @brief Keeps the vertices, edges and triangles of the next loaded files in
+    * file-backed memory maps (out-of-core), so the size of the mesh isn't
+    * limited by the RAM. Loaded meshes are reordered along a space-filling
+    * curve, so the engines process them in spatially coherent blocks.
+    * Only this Model (and its batches) is affected.
+    *
+    * @param directory p_directory: Directory of the (already deleted) mapped
+    * files. Empty to keep the mesh in RAM.
+    * @return True if correctly set.
+    */
+    bool setOutOfCore(std::string directory);
+
+    /**
+    * @brief Enables or disables the topology cache (disabled by default).
+    * When enabled, each loaded file gets a binary sidecar file (same path plus
+    * ".qlcache") with its vertices, triangles and edges, and the next loads of
+    * the same unchanged file (size, modification time and contents) skip
+    * the parsing and the building of edges.
+    *
+    * @param enabled p_enabled: True to use the cache.
+    */
+    void setCacheEnabled(bool enabled);
+
+    /**
+    * @brief Removes the topology cache of a mesh file.
+    *
+    * @param filepath p_filepath: Path of the mesh file (not the sidecar).
+    * @return True if there's no cache anymore.
+    */
+    bool purgeCache(std::string filepath);
+
+    /**
+    * @brief Starts an append-only journal of the improvements of the actual
+    * triangulation, so a long refinement can be resumed after a crash.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @return True if the journal has been created.
+    */
+    bool startJournal(std::string filepath);
+
+    /**
+    * @brief Replays the complete improvements of a journal onto the actual
+    * triangulation (the same one that was loaded when the journal was started),
+    * and keeps journaling the next improvements in it.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @return True if the journal has been replayed.
+    */
+    bool resumeJournal(std::string filepath);
+
+    /**
+    * @brief Stops journaling the improvements.
+    *
+    */
+    void stopJournal();
+
 private:
     ModelImpl *m_impl;
 };
@@ -17,35 +17,112 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
 #include <model_impl.h>
+#include <batch/batchprocessor.h>
 #include <engine/cpuengine.h>
 #include <engine/openclengine.h>
 #include <filehandlers/offhandler.h>
+#include <metrics/perfcounters.h>
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+#include <storage/localityorder.h>
+#include <triangulation/delaunaytriangulator.h>
+#include <triangulation/randommeshgenerator.h>
 
-ModelImpl& ModelImpl::getInstance(void)
+namespace
 {
-    static ModelImpl instance;
-    return instance;
+    /* Memory that can be used without swapping (MemAvailable of the kernel).
+     * 0 if unknown.
+     */
+    unsigned long long availableMemory()
+    {
+#ifdef Q_OS_LINUX
+        QFile meminfo("/proc/meminfo");
+        if (meminfo.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream in(&meminfo);
+            QString line;
+            while (in.readLineInto(&line))
+            {
+                // "MemAvailable:   16384000 kB"
+                QStringList fields = line.split(" ", QString::SkipEmptyParts);
+                if (fields.size() > 1 and fields.at(0) == "MemAvailable:")
+                {
+                    return fields.at(1).toULongLong() * 1024;
+                }
+            }
+        }
+#endif
+        return 0;
+    }
+
+    /* Peak bytes that a vector adds to hold "added" more elements. Growing
+     * copies it to a new block (at least twice as large) while the old one
+     * is still alive.
+     */
+    unsigned long long growthBytes(const VectorMemory &memory, unsigned long added)
+    {
+        unsigned long needed = memory.size + added;
+        if (needed <= memory.capacity)
+        {
+            return 0;
+        }
+        unsigned long capacity = std::max(needed, 2 * memory.capacity);
+        return static_cast<unsigned long long>(capacity) * memory.elementBytes;
+    }
 }
 
 ModelImpl::ModelImpl()
-    : m_engine(nullptr)
+    : m_engine(nullptr),
+      m_angle(0),
+      m_metricsEnabled(false),
+      m_hardwareCountersEnabled(false),
+      m_insertions(0),
+      m_detectionStale(false)
 {
     setEngine(new CPUEngine);
 }
 
 ModelImpl::ModelImpl(Engine *engine)
+    : m_engine(nullptr),
+      m_angle(0),
+      m_metricsEnabled(false),
+      m_hardwareCountersEnabled(false),
+      m_insertions(0),
+      m_detectionStale(false)
 {
     setEngine(engine);
 }
 
+ModelImpl::~ModelImpl()
+{
+    waitForRefinement();
+    for (std::shared_future<bool> &pending : m_pendingSaves)
+    {
+        pending.wait();
+    }
+    delete m_engine;
+}
+
 void ModelImpl::setEngine(Engine *engine)
 {
+    waitForRefinement();
     if (m_engine != nullptr)
     {
         delete m_engine;
     }
     m_engine = engine;
+    m_engine->getMetrics().setEnabled(m_metricsEnabled);
+    m_engine->getMetrics().setHardwareCountersEnabled(m_hardwareCountersEnabled);
 }
 
 bool ModelImpl::setCPUEngine()
@@ -60,11 +137,11 @@ bool ModelImpl::setCPUEngine()
         return false;
     }
 }
-bool ModelImpl::setOpenCLEngine()
+bool ModelImpl::setOpenCLEngine(unsigned long platform_id, unsigned long device_id)
 {
     try
     {
-        setEngine(new OpenCLEngine);
+        setEngine(new OpenCLEngine(platform_id, device_id));
         return true;
     }
     catch (...)
@@ -75,35 +152,485 @@ bool ModelImpl::setOpenCLEngine()
 
 bool ModelImpl::loadFile(std::string filepath)
 {
-    return m_fileManager.load(filepath, m_vertices, m_edges, m_triangles);
+    // A failed (or cancelled) load keeps the previous triangulation
+    MeshVector<Vertex> vertices(m_storage);
+    MeshVector<Edge> edges(m_storage);
+    MeshVector<Triangle> triangles(m_storage);
+    if (not m_fileManager.load(filepath, vertices, edges, triangles))
+    {
+        return false;
+    }
+
+    // A journal only makes sense for the triangulation it was started with
+    m_journal.close();
+    m_insertions = 0;
+    m_detectionStale = false;
+    m_vertices.swap(vertices);
+    m_edges.swap(edges);
+    m_triangles.swap(triangles);
+
+    sortForLocality();
+    return true;
+}
+
+std::shared_future<bool> ModelImpl::loadFileAsync(std::string filepath,
+                                                  ProgressCallback progress,
+                                                  CancellationToken token,
+                                                  ChunkCallback chunks)
+{
+    waitForRefinement();
+    m_fileManager.setProgressCallback(progress);
+    m_fileManager.setCancellationToken(token);
+    m_fileManager.setChunkCallback(chunks);
+
+    m_pendingRefinement = std::async(std::launch::async, [this, filepath]() {
+        // Later blocking loads must not report anything, nor be cancelled
+        auto restore = [this]() {
+            m_fileManager.setProgressCallback(ProgressCallback());
+            m_fileManager.setCancellationToken(CancellationToken());
+            m_fileManager.setChunkCallback(ChunkCallback());
+        };
+        try
+        {
+            bool result = loadFile(filepath);
+            restore();
+            return result;
+        }
+        catch (...)
+        {
+            restore();
+            throw;
+        }
+    }).share();
+    return m_pendingRefinement;
+}
+
+bool ModelImpl::loadPoints(const Vertex *points, unsigned long count)
+{
+    MeshVector<Vertex> vertices(points, points + count, m_storage);
+    MeshVector<Edge> edges(m_storage);
+    MeshVector<Triangle> triangles(m_storage);
+    DelaunayTriangulator triangulator;
+    if (not triangulator.triangulate(vertices, edges, triangles))
+    {
+        return false;
+    }
+
+    m_journal.close();
+    m_insertions = 0;
+    m_detectionStale = false;
+    m_vertices.swap(vertices);
+    m_edges.swap(edges);
+    m_triangles.swap(triangles);
+
+    sortForLocality();
+    return true;
+}
+
+bool ModelImpl::generateRandomMesh(unsigned long points, unsigned long seed)
+{
+    MeshVector<Vertex> vertices(m_storage);
+    MeshVector<Edge> edges(m_storage);
+    MeshVector<Triangle> triangles(m_storage);
+    RandomMeshGenerator generator(seed);
+    if (not generator.generate(points, vertices, edges, triangles))
+    {
+        return false;
+    }
+
+    m_journal.close();
+    m_insertions = 0;
+    m_detectionStale = false;
+    m_vertices.swap(vertices);
+    m_edges.swap(edges);
+    m_triangles.swap(triangles);
+
+    sortForLocality();
+    return true;
+}
+
+void ModelImpl::sortForLocality()
+{
+    if (m_vertices.get_allocator().storage.isFileBacked())
+    {
+        // Engines walk the vectors in order, so we want neighbours in the same pages.
+        LocalityOrder order;
+        order.sort(m_vertices, m_edges, m_triangles);
+    }
 }
 
 bool ModelImpl::saveFile(std::string filepath)
 {
+    waitForRefinement();
     return m_fileManager.save(filepath, m_vertices, m_edges, m_triangles);
 }
 
-std::vector<Vertex>& ModelImpl::getVertices()
+std::shared_future<bool> ModelImpl::saveFileAsync(std::string filepath)
+{
+    // Forget the saves that have already finished
+    auto finished = [](std::shared_future<bool> &pending) {
+        return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    m_pendingSaves.erase(std::remove_if(m_pendingSaves.begin(), m_pendingSaves.end(), finished),
+                         m_pendingSaves.end());
+
+    // The snapshot must not be taken while an asynchronous refinement resizes the vectors
+    waitForRefinement();
+
+    /* Plain copies are a consistent snapshot, and they're much cheaper than
+     * the serialization itself, which is what we don't want to wait for.
+     * Copying only the tail of the vectors isn't enough: the next improvements
+     * rewrite old slots in place (see ChangeSet), and the engines don't keep
+     * their previous values, so the save thread would read a mix of rounds.
+     */
+    auto vertices = std::make_shared<MeshVector<Vertex>>(m_vertices);
+    auto edges = std::make_shared<MeshVector<Edge>>(m_edges);
+    auto triangles = std::make_shared<MeshVector<Triangle>>(m_triangles);
+
+    // Handlers are stateless, but we don't share our FileManager with the thread.
+    std::shared_future<bool> result = std::async(std::launch::async, [filepath, vertices, edges, triangles]() {
+        FileManager fileManager;
+        return fileManager.save(filepath, *vertices, *edges, *triangles);
+    }).share();
+
+    m_pendingSaves.push_back(result);
+    return result;
+}
+
+BatchReport ModelImpl::processBatch(const std::vector<BatchJob> &jobs,
+                                    float angle,
+                                    unsigned long rounds,
+                                    unsigned int concurrency)
+{
+    // The batch shares our engine, which a pending refinement may still be using
+    waitForRefinement();
+    BatchProcessor processor(m_engine, concurrency, m_storage);
+    return processor.process(jobs, angle, rounds);
+}
+
+MeshVector<Vertex>& ModelImpl::getVertices()
 {
     return m_vertices;
 }
 
-std::vector<Edge>& ModelImpl::getEdges()
+MeshVector<Edge>& ModelImpl::getEdges()
 {
     return m_edges;
 }
 
-std::vector<Triangle>& ModelImpl::getTriangles()
+MeshVector<Triangle>& ModelImpl::getTriangles()
 {
     return m_triangles;
 }
 
 bool ModelImpl::detectBadTriangles(float angle)
 {
-    return m_engine->detectBadTriangles(angle, m_vertices, m_triangles);
+    TraceSpan span("detectBadTriangles", "model");
+    AllocationScope allocations("detectBadTriangles");
+    std::vector<AllocationTracker::PhaseAllocations> allocationsBefore(countAllocations());
+    m_angle = angle;
+    m_engine->getMetrics().clear();
+    bool detected = m_engine->detectBadTriangles(angle, m_vertices, m_triangles);
+    m_detectionStale = (not detected and m_engine->getCancellationToken().isCancelled());
+    updateGauges();
+    updateAllocations(allocationsBefore);
+    return detected;
 }
 
 bool ModelImpl::improveTriangulation()
 {
-    return m_engine->improveTriangulation(m_vertices, m_edges, m_triangles);
+    TraceSpan span("improveTriangulation", "model");
+    AllocationScope allocations("improveTriangulation");
+    std::vector<AllocationTracker::PhaseAllocations> allocationsBefore(countAllocations());
+    if (m_vertices.get_allocator().storage.isFileBacked())
+    {
+        reserveForImprovement();
+    }
+
+    m_insertions = 0;
+    m_engine->getMetrics().clear();
+    if (m_detectionStale)
+    {
+        if (not m_engine->detectBadTriangles(m_angle, m_vertices, m_triangles))
+        {
+            return false;
+        }
+        m_detectionStale = false;
+    }
+    bool improved = m_engine->improveTriangulation(m_vertices, m_edges, m_triangles);
+    // A cancelled improvement may have inserted centroids, and they're kept
+    bool cancelled = (not improved and m_engine->getCancellationToken().isCancelled());
+    if (not improved and not cancelled)
+    {
+        return false;
+    }
+    m_detectionStale = cancelled;
+    updateGauges();
+    updateAllocations(allocationsBefore);
+
+    // Each insertion adds exactly one vertex (the centroid)
+    m_insertions = m_vertices.size() - m_engine->getChanges().firstVertex;
+
+    if (m_journal.isOpen() and not m_journal.append(m_angle, m_engine->getChanges(), m_vertices, m_edges, m_triangles))
+    {
+        return false;
+    }
+    return improved;
+}
+
+std::shared_future<bool> ModelImpl::detectBadTrianglesAsync(float angle,
+                                                            ProgressCallback progress,
+                                                            CancellationToken token)
+{
+    return runAsync([this, angle]() { return detectBadTriangles(angle); }, progress, token);
+}
+
+std::shared_future<bool> ModelImpl::improveTriangulationAsync(ProgressCallback progress,
+                                                              CancellationToken token)
+{
+    return runAsync([this]() { return improveTriangulation(); }, progress, token);
+}
+
+std::shared_future<bool> ModelImpl::runAsync(std::function<bool()> refinement,
+                                             ProgressCallback progress,
+                                             CancellationToken token)
+{
+    waitForRefinement();
+    m_engine->setProgressCallback(progress);
+    m_engine->setCancellationToken(token);
+
+    Engine *engine(m_engine);
+    m_pendingRefinement = std::async(std::launch::async, [refinement, engine]() {
+        // Later blocking calls must not report progress, nor be cancelled
+        auto restore = [engine]() {
+            engine->setProgressCallback(ProgressCallback());
+            engine->setCancellationToken(CancellationToken());
+        };
+        try
+        {
+            bool result = refinement();
+            restore();
+            return result;
+        }
+        catch (...)
+        {
+            restore();
+            throw;
+        }
+    }).share();
+    return m_pendingRefinement;
+}
+
+void ModelImpl::waitForRefinement() const
+{
+    if (m_pendingRefinement.valid())
+    {
+        m_pendingRefinement.wait();
+    }
+}
+
+bool ModelImpl::setOutOfCore(std::string directory)
+{
+    if (not directory.empty() and not MappedStorage::isSupported())
+    {
+        return false;
+    }
+    m_storage = MappedStorage(directory);
+    return true;
+}
+
+unsigned long ModelImpl::countBadTriangles() const
+{
+    unsigned long bad(0);
+    for (const Triangle &t : m_triangles)
+    {
+        bad += static_cast<unsigned long>(t.bad != 0);
+    }
+    return bad;
+}
+
+void ModelImpl::reserveForImprovement()
+{
+    // Each bad triangle leads to one insertion at most.
+    unsigned long bad(countBadTriangles());
+
+    /* Each insertion does
+     *   +1 to vertices.size()
+     *   +2 to triangles.size()
+     *   +3 to edges.size()
+     * And we keep doubling, so the next improvements don't move them either.
+     */
+    if (m_vertices.size() + bad > m_vertices.capacity())
+    {
+        m_vertices.reserve(2 * (m_vertices.size() + bad));
+    }
+    if (m_triangles.size() + 2 * bad > m_triangles.capacity())
+    {
+        m_triangles.reserve(2 * (m_triangles.size() + 2 * bad));
+    }
+    if (m_edges.size() + 3 * bad > m_edges.capacity())
+    {
+        m_edges.reserve(2 * (m_edges.size() + 3 * bad));
+    }
+}
+
+void ModelImpl::setCacheEnabled(bool enabled)
+{
+    m_fileManager.setCacheEnabled(enabled);
+}
+
+bool ModelImpl::purgeCache(std::string filepath)
+{
+    return m_fileManager.purgeCache(filepath);
+}
+
+MemoryReport ModelImpl::getMemoryReport() const
+{
+    waitForRefinement();
+    MemoryReport report;
+    report.vertices = VectorMemory{m_vertices.size(), m_vertices.capacity(), sizeof(Vertex)};
+    report.edges = VectorMemory{m_edges.size(), m_edges.capacity(), sizeof(Edge)};
+    report.triangles = VectorMemory{m_triangles.size(), m_triangles.capacity(), sizeof(Triangle)};
+    report.devices = m_engine->getDeviceMemory();
+    report.loadTransientBytes = m_fileManager.getTransientBytes();
+    report.availableBytes = availableMemory();
+
+    /* The terminal edges of the next round aren't known until it runs, but
+     * each bad triangle ends in one of them at most (several share one), and
+     * each insertion does +1 vertex, +2 triangles and +3 edges.
+     */
+    unsigned long bad(countBadTriangles());
+    report.pendingInsertions = bad;
+    report.nextRoundHostBytes = growthBytes(report.vertices, bad) +
+                                growthBytes(report.triangles, 2 * bad) +
+                                growthBytes(report.edges, 3 * bad) +
+                                bad * sizeof(int);          // Terminal edges found by the engine
+    if (not report.devices.empty())
+    {
+        // The buffers are rebuilt with the grown vectors
+        report.nextRoundDeviceBytes = (report.vertices.size + bad) * sizeof(Vertex) +
+                                      (report.triangles.size + 2 * bad) * sizeof(Triangle) +
+                                      (report.edges.size + 3 * bad) * sizeof(Edge);
+    }
+    return report;
+}
+
+unsigned long ModelImpl::getInsertionCount() const
+{
+    return m_insertions;
+}
+
+const ChangeSet& ModelImpl::getChanges() const
+{
+    return m_engine->getChanges();
+}
+
+void ModelImpl::setMetricsEnabled(bool enabled)
+{
+    m_metricsEnabled = enabled;
+    m_engine->getMetrics().setEnabled(enabled);
+}
+
+bool ModelImpl::setHardwareCountersEnabled(bool enabled)
+{
+    bool available = (not enabled or PerfCounters::isSupported());
+    if (not available)
+    {
+        qWarning() << "Hardware performance counters are not available";
+    }
+    m_hardwareCountersEnabled = (enabled and available);
+    m_engine->getMetrics().setHardwareCountersEnabled(m_hardwareCountersEnabled);
+    return available;
+}
+
+const Metrics& ModelImpl::getMetrics() const
+{
+    return m_engine->getMetrics();
+}
+
+bool ModelImpl::startTrace(std::string filepath)
+{
+    return Tracer::getInstance().start(filepath);
+}
+
+bool ModelImpl::stopTrace()
+{
+    return Tracer::getInstance().stop();
+}
+
+void ModelImpl::updateGauges()
+{
+    Metrics &metrics(m_engine->getMetrics());
+    metrics.setGauge("vertices", static_cast<double>(m_vertices.size()));
+    metrics.setGauge("edges", static_cast<double>(m_edges.size()));
+    metrics.setGauge("triangles", static_cast<double>(m_triangles.size()));
+}
+
+std::vector<AllocationTracker::PhaseAllocations> ModelImpl::countAllocations() const
+{
+    if (not m_engine->getMetrics().isEnabled() or not AllocationTracker::isEnabled())
+    {
+        return std::vector<AllocationTracker::PhaseAllocations>();
+    }
+
+    // Outside every phase, so the snapshot doesn't count itself
+    AllocationScope untracked(nullptr);
+    return AllocationTracker::getAllocations();
+}
+
+void ModelImpl::updateAllocations(const std::vector<AllocationTracker::PhaseAllocations> &before)
+{
+    std::vector<AllocationTracker::PhaseAllocations> after(countAllocations());
+
+    /* The tracker is shared by the process, so allocations outside every phase
+     * ("other") aren't ours, and the phases of the library also count the
+     * Models refining in other threads at the same time.
+     */
+    AllocationScope untracked(nullptr);
+    Metrics &metrics(m_engine->getMetrics());
+    for (const AllocationTracker::PhaseAllocations &phase : after)
+    {
+        if (phase.phase == "other")
+        {
+            continue;
+        }
+        unsigned long long allocations(phase.allocations);
+        unsigned long long bytes(phase.bytes);
+        for (const AllocationTracker::PhaseAllocations &previous : before)
+        {
+            // Unless the tracker was reset in between, and counting started again
+            if (previous.phase == phase.phase and previous.allocations <= allocations and previous.bytes <= bytes)
+            {
+                allocations -= previous.allocations;
+                bytes -= previous.bytes;
+                break;
+            }
+        }
+        if (allocations > 0)
+        {
+            metrics.addCount(("allocations." + phase.phase).c_str(), static_cast<unsigned long>(allocations));
+            metrics.addCount(("allocated_bytes." + phase.phase).c_str(), static_cast<unsigned long>(bytes));
+        }
+    }
+}
+
+bool ModelImpl::startJournal(std::string filepath)
+{
+    return m_journal.create(filepath, m_vertices, m_edges, m_triangles);
+}
+
+bool ModelImpl::resumeJournal(std::string filepath)
+{
+    if (m_journal.resume(filepath, m_vertices, m_edges, m_triangles, m_angle) < 0)
+    {
+        return false;
+    }
+
+    // Bad triangles aren't journaled for untouched triangles, so we detect them again.
+    return m_engine->detectBadTriangles(m_angle, m_vertices, m_triangles);
+}
+
+void ModelImpl::stopJournal()
+{
+    m_journal.close();
 }
@@ -20,29 +20,53 @@
 #ifndef MODELIMPL_H
 #define MODELIMPL_H
 
+#include <functional>
+#include <future>
 #include <string>
 #include <filehandlers/filemanager.h>
+#include <filehandlers/journal.h>
 
 #include <structs/vertex.h>
 #include <structs/triangle.h>
 #include <structs/edge.h>
+#include <structs/meshvector.h>
+#include <structs/batch.h>
+#include <structs/memoryreport.h>
 
 #include <engine/engine.h>
+#include <metrics/allocationtracker.h>
 
 /**
 * @brief Implementation file of facade class for GUI/Library interaction.
-* Singleton Pattern is used here.
+* Each Model owns its own ModelImpl (mesh, engine, metrics and files), so
+* several of them can be used at the same time from different threads.
 *
 */
 class ModelImpl
 {
 public:
     /**
-     * @brief Gets the actual instance of the Model.
-     *
-     * @return Instance of Model.
-     */
-    static ModelImpl& getInstance();
+    * @brief Basic constructor. Creates a Model instance with the CPU engine.
+    *
+    */
+    ModelImpl();
+
+    /**
+    * @brief Constructor that creates a Model instance with the selected engine.
+    *
+    * @param engine p_engine: Engine used by the Model.
+    */
+    ModelImpl(Engine *engine);
+
+    /**
+    * @brief Destructor. Waits for the saves and the refinement that are still
+    * running.
+    *
+    */
+    ~ModelImpl();
+
+    ModelImpl(const ModelImpl&) = delete;
+    ModelImpl& operator=(const ModelImpl&) = delete;
 
     /**
     * @brief Sets the engine that will be used by the Model.
@@ -61,18 +85,54 @@ public:
     /**
      * @brief Convenience method that sets the OpenCL Engine.
      *
+     * @param platform_id p_platform_id: Index of the OpenCL platform (vendor).
+     * @param device_id p_device_id: Index of the device in that platform.
      * @return True if correctly set.
      */
-    bool setOpenCLEngine();
+    bool setOpenCLEngine(unsigned long platform_id = 0, unsigned long device_id = 0);
 
     /**
     * @brief Loads an OFF file so the inner implementation can receive the triangles.
+    * The actual triangulation is only replaced if the load succeeds.
     *
     * @param filepath p_filepath: Path of the file.
     * @return True if correctly loaded.
     */
     bool loadFile(std::string filepath);
 
+    /**
+    * @brief Runs loadFile in a background thread, with the callbacks and the
+    * token set in the file handlers until it ends.
+    *
+    * @param filepath p_filepath: Path of the file.
+    * @param progress p_progress: Receiver of the progress of the load.
+    * @param token p_token: Token that stops the load.
+    * @param chunks p_chunks: Receiver of the partial mesh.
+    * @return Future with the result of loadFile.
+    */
+    std::shared_future<bool> loadFileAsync(std::string filepath,
+                                           ProgressCallback progress,
+                                           CancellationToken token,
+                                           ChunkCallback chunks);
+
+    /**
+    * @brief Replaces the triangulation with the Delaunay mesh of a point cloud.
+    *
+    * @param points p_points: Array of points.
+    * @param count p_count: Number of points in the array.
+    * @return True if correctly triangulated.
+    */
+    bool loadPoints(const Vertex *points, unsigned long count);
+
+    /**
+    * @brief Replaces the triangulation with the Delaunay mesh of random points.
+    *
+    * @param points p_points: Number of random points.
+    * @param seed p_seed: Seed of the generator.
+    * @return True if correctly generated.
+    */
+    bool generateRandomMesh(unsigned long points, unsigned long seed = 1);
+
     /**
     * @brief Saves an OFF file in the provided filepath.
     *
@@ -81,26 +141,49 @@ public:
     */
     bool saveFile(std::string filepath);
 
+    /**
+    * @brief Saves a snapshot of the actual triangulation in a background thread,
+    * so the triangulation can keep being modified meanwhile.
+    *
+    * @param filepath p_filepath: Path of the file.
+    * @return Future that becomes true if correctly saved.
+    */
+    std::shared_future<bool> saveFileAsync(std::string filepath);
+
+    /**
+    * @brief Refines many mesh files in a pipeline that shares the actual engine.
+    *
+    * @param jobs p_jobs: Input and output path of each mesh.
+    * @param angle p_angle: Minimum angle of a good triangle.
+    * @param rounds p_rounds: Maximum improvement rounds per mesh (0 = until convergence).
+    * @param concurrency p_concurrency: Number of parsing and writing threads.
+    * @return Outcome of each job and aggregate throughput.
+    */
+    BatchReport processBatch(const std::vector<BatchJob> &jobs,
+                             float angle,
+                             unsigned long rounds,
+                             unsigned int concurrency);
+
     /**
     * @brief Gets a vector of Vertex which are being used by the implementation.
     *
-    * @return std::vector< Vertex >& Reference to the actual vector of vertices.
+    * @return MeshVector< Vertex >& Reference to the actual vector of vertices.
     */
-    std::vector<Vertex>& getVertices();
+    MeshVector<Vertex>& getVertices();
 
     /**
     * @brief Gets a vector of Edges which are being used by the implementation.
     *
-    * @return std::vector< Edge >& Reference to the actual vector of edges.
+    * @return MeshVector< Edge >& Reference to the actual vector of edges.
     */
-    std::vector<Edge>& getEdges();
+    MeshVector<Edge>& getEdges();
 
     /**
     * @brief Gets a vector of Triangles which are being used by the implementation.
     *
-    * @return std::vector< Triangle >& Reference to the actual vector of triangles.
+    * @return MeshVector< Triangle >& Reference to the actual vector of triangles.
     */
-    std::vector<Triangle>& getTriangles();
+    MeshVector<Triangle>& getTriangles();
 
     /**
     * @brief Detects every triangle in the vector of triangles whose minimum
@@ -118,25 +201,218 @@ public:
     */
     bool improveTriangulation();
 
+    /**
+    * @brief Runs detectBadTriangles in a background thread.
+    *
+    * @param angle p_angle: Provided angle.
+    * @param progress p_progress: Receiver of the progress of the engine.
+    * @param token p_token: Token that stops the detection.
+    * @return Future with the result of detectBadTriangles.
+    */
+    std::shared_future<bool> detectBadTrianglesAsync(float angle,
+                                                     ProgressCallback progress,
+                                                     CancellationToken token);
+
+    /**
+    * @brief Runs improveTriangulation in a background thread.
+    *
+    * @param progress p_progress: Receiver of the progress of the engine.
+    * @param token p_token: Token that stops the improvement.
+    * @return Future with the result of improveTriangulation.
+    */
+    std::shared_future<bool> improveTriangulationAsync(ProgressCallback progress,
+                                                       CancellationToken token);
+
+    /**
+    * @brief Gets the number of centroids inserted by the last improvement.
+    *
+    * @return Number of insertions. 0 means the triangulation can't be improved anymore.
+    */
+    unsigned long getInsertionCount() const;
+
+    /**
+    * @brief Gets the positions of the vectors modified by the last improvement.
+    *
+    * @return Changes of the last improvement.
+    */
+    const ChangeSet& getChanges() const;
+
+    /**
+    * @brief Gets the memory used by the mesh, the engine and the last load,
+    * and the memory that the next improvement needs.
+    *
+    * @return Memory report.
+    */
+    MemoryReport getMemoryReport() const;
+
+    /**
+    * @brief Enables or disables the metrics of this and the next engines.
+    *
+    * @param enabled p_enabled: True to collect them.
+    */
+    void setMetricsEnabled(bool enabled);
+
+    /**
+    * @brief Enables or disables the hardware counters of the phases, for this
+    * and the next engines.
+    *
+    * @param enabled p_enabled: True to count.
+    * @return False if they're not available in this system.
+    */
+    bool setHardwareCountersEnabled(bool enabled);
+
+    /**
+    * @brief Gets the metrics of the last detection or improvement.
+    *
+    * @return Metrics registry of the engine.
+    */
+    const Metrics& getMetrics() const;
+
+    /**
+    * @brief Starts recording the timeline of the process.
+    *
+    * @param filepath p_filepath: Path of the Chrome trace.
+    * @return True if started.
+    */
+    bool startTrace(std::string filepath);
+
+    /**
+    * @brief Stops recording the timeline and writes the trace.
+    *
+    * @return True if correctly written.
+    */
+    bool stopTrace();
+
+    /**
+    * @brief Keeps the vectors of the next loaded triangulations of this model
+    * in file-backed memory maps (out-of-core) instead of the RAM.
+    *
+    * @param directory p_directory: Directory of the mapped files. Empty to use the RAM.
+    * @return True if correctly set.
+    */
+    bool setOutOfCore(std::string directory);
+
+    /**
+    * @brief Enables or disables the sidecar topology cache of loaded files.
+    *
+    * @param enabled p_enabled: True to use the cache.
+    */
+    void setCacheEnabled(bool enabled);
+
+    /**
+    * @brief Removes the sidecar topology cache of a mesh file.
+    *
+    * @param filepath p_filepath: Path of the mesh file.
+    * @return True if there's no cache anymore.
+    */
+    bool purgeCache(std::string filepath);
+
+    /**
+    * @brief Starts journaling every improvement of the actual triangulation.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @return True if the journal has been created.
+    */
+    bool startJournal(std::string filepath);
+
+    /**
+    * @brief Replays a journal onto the actual (base) triangulation and keeps
+    * journaling the next improvements in it.
+    *
+    * @param filepath p_filepath: Path of the journal file.
+    * @return True if the journal has been replayed.
+    */
+    bool resumeJournal(std::string filepath);
+
+    /**
+    * @brief Stops journaling the improvements.
+    *
+    */
+    void stopJournal();
+
 private:
     /**
-    * @brief Basic constructor. Creates a Model instance with the CPU engine.
+    * @brief Makes sure the vectors can hold the next improvement without being
+    * moved during it. Reserving still copies a vector into a new block (a new
+    * file, out-of-core) when its capacity is too small, but capacity doubles,
+    * so that happens in few rounds. Meanwhile both copies exist, so the disk
+    * peaks at about three times the size of the vector.
     *
     */
-    ModelImpl();
+    void reserveForImprovement();
 
     /**
-    * @brief Constructor that creates a Model instance with the selected engine.
+    * @brief Sorts a freshly loaded mesh so neighbours share memory pages.
+    * Only done when the vectors are file-backed. Elements added by later
+    * improvements are appended, so they aren't sorted.
     *
-    * @param engine p_engine: Engine used by the Model.
     */
-    ModelImpl(Engine *engine);
+    void sortForLocality();
+
+    /**
+    * @brief Counts the triangles marked as bad.
+    *
+    * @return Number of bad triangles.
+    */
+    unsigned long countBadTriangles() const;
+
+    /**
+    * @brief Records the sizes of the vectors as gauges of the metrics.
+    *
+    */
+    void updateGauges();
+
+    /**
+    * @brief Gets the allocations counted so far, to be passed later to
+    * updateAllocations. Empty unless both the metrics and the allocation
+    * tracker are enabled.
+    *
+    * @return Allocations of each phase.
+    */
+    std::vector<AllocationTracker::PhaseAllocations> countAllocations() const;
+
+    /**
+    * @brief Records the allocations of each phase since countAllocations as
+    * the counters allocations.<phase> and allocated_bytes.<phase>.
+    *
+    * @param before p_before: Allocations returned by countAllocations.
+    */
+    void updateAllocations(const std::vector<AllocationTracker::PhaseAllocations> &before);
+
+    /**
+    * @brief Runs a refinement in a background thread, with the progress
+    * callback and the cancellation token set in the engine until it ends.
+    * Waits for the previous refinement first, as both modify the vectors.
+    *
+    * @param refinement p_refinement: Refinement to run.
+    * @param progress p_progress: Receiver of the progress of the engine.
+    * @param token p_token: Token that stops the refinement.
+    * @return Future with the result of the refinement.
+    */
+    std::shared_future<bool> runAsync(std::function<bool()> refinement,
+                                      ProgressCallback progress,
+                                      CancellationToken token);
+
+    /**
+    * @brief Waits for the refinement (or asynchronous load) that is still running, if any.
+    *
+    */
+    void waitForRefinement() const;
 
     FileManager m_fileManager;
+    Journal m_journal;
     Engine *m_engine;
-    std::vector<Vertex> m_vertices;
-    std::vector<Edge> m_edges;
-    std::vector<Triangle> m_triangles;
+    float m_angle;
+    bool m_metricsEnabled;
+    bool m_hardwareCountersEnabled;
+    unsigned long m_insertions;
+    bool m_detectionStale;          // A cancelled call left stale bad flags
+    MappedStorage m_storage;        // Of the next loaded triangulations
+    MeshVector<Vertex> m_vertices;
+    MeshVector<Edge> m_edges;
+    MeshVector<Triangle> m_triangles;
+    std::vector<std::shared_future<bool>> m_pendingSaves;
+    std::shared_future<bool> m_pendingRefinement;   // Or load
 };
 
 #endif // MODELIMPL_H
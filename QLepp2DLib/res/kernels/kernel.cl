@@ -88,7 +88,9 @@ kernel void detectBadTriangles(const float angle, global Triangle *triangles, gl
 kernel void detectTerminalEdges(global Triangle *triangles,
                                 global Vertex *vertices,
                                 global Edge *edges,
-                                global int *flag)
+                                global int *flag,
+                                global uint *steps,
+                                int countSteps)
 {
     int idx = get_global_id(0);
 
@@ -101,6 +103,7 @@ kernel void detectTerminalEdges(global Triangle *triangles,
     Triangle t = triangles[idx];
     int it = idx;
     int k = 0; // Index of triangleHistory
+    uint visited = 0; // Length of the Lepp
 
     if (t.bad)
     {
@@ -108,6 +111,7 @@ kernel void detectTerminalEdges(global Triangle *triangles,
         {
             // Add myself to the history.
             triangleHistory[k] = it;
+            visited++;
 
             // Detect longest edge.
             Vertex A, B, C;
@@ -146,6 +150,10 @@ kernel void detectTerminalEdges(global Triangle *triangles,
             if (neighbourIT < 0)
             {
                 edges[longestIE].isTE = 1;
+                if (countSteps)
+                {
+                    steps[idx] = visited;
+                }
                 return;
             }
 
@@ -154,6 +162,10 @@ kernel void detectTerminalEdges(global Triangle *triangles,
             {
                 edges[longestIE].isTE = 1;
                 flag[0] = 1;
+                if (countSteps)
+                {
+                    steps[idx] = visited - 1; // The last one was visited twice
+                }
                 return;
             }
 
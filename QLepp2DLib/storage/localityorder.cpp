@@ -0,0 +1,180 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <limits>
+
+#include <storage/localityorder.h>
+
+LocalityOrder::LocalityOrder()
+    : m_minX(0),
+      m_minY(0),
+      m_scaleX(0),
+      m_scaleY(0)
+{
+}
+
+void LocalityOrder::sort(MeshVector<Vertex> &vertices,
+                         MeshVector<Edge> &edges,
+                         MeshVector<Triangle> &triangles)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Bounding box, so the 16 bits of each axis cover the whole mesh.
+    float maxX(std::numeric_limits<float>::lowest());
+    float maxY(std::numeric_limits<float>::lowest());
+    m_minX = m_minY = std::numeric_limits<float>::max();
+    for (const Vertex &v : vertices)
+    {
+        m_minX = std::min(m_minX, v.x);
+        m_minY = std::min(m_minY, v.y);
+        maxX = std::max(maxX, v.x);
+        maxY = std::max(maxY, v.y);
+    }
+    m_scaleX = (maxX > m_minX) ? 65535.0f / (maxX - m_minX) : 0.0f;
+    m_scaleY = (maxY > m_minY) ? 65535.0f / (maxY - m_minY) : 0.0f;
+
+    MeshVector<uint64_t> keys;
+    MeshVector<cl_int> newIndices;
+
+    // Phase 1: Vertices. Triangles and edges point to their new indices.
+    keys.reserve(vertices.size());
+    for (unsigned long i(0); i < vertices.size(); i++)
+    {
+        keys.push_back(key(vertices.at(i).x, vertices.at(i).y, i));
+    }
+    order(keys, newIndices);
+    {
+        MeshVector<Vertex> sorted(vertices.get_allocator());
+        sorted.reserve(vertices.capacity());
+        for (uint64_t k : keys)
+        {
+            sorted.push_back(vertices.at(k & 0xffffffff));
+        }
+        vertices.swap(sorted);
+    }
+    for (Triangle &t : triangles)
+    {
+        t.iv1 = newIndices.at(static_cast<unsigned long>(t.iv1));
+        t.iv2 = newIndices.at(static_cast<unsigned long>(t.iv2));
+        t.iv3 = newIndices.at(static_cast<unsigned long>(t.iv3));
+    }
+    for (Edge &e : edges)
+    {
+        // Edges keep their vertices sorted (iv1 < iv2).
+        cl_int iv1(newIndices.at(static_cast<unsigned long>(e.iv1)));
+        cl_int iv2(newIndices.at(static_cast<unsigned long>(e.iv2)));
+        e.iv1 = std::min(iv1, iv2);
+        e.iv2 = std::max(iv1, iv2);
+    }
+
+    // Phase 2: Triangles, by their centroids. Edges point to their new indices.
+    keys.clear();
+    keys.reserve(triangles.size());
+    for (unsigned long i(0); i < triangles.size(); i++)
+    {
+        const Triangle &t(triangles.at(i));
+        const Vertex &A(vertices.at(static_cast<unsigned long>(t.iv1)));
+        const Vertex &B(vertices.at(static_cast<unsigned long>(t.iv2)));
+        const Vertex &C(vertices.at(static_cast<unsigned long>(t.iv3)));
+        keys.push_back(key((A.x + B.x + C.x) / 3.0f, (A.y + B.y + C.y) / 3.0f, i));
+    }
+    order(keys, newIndices);
+    {
+        MeshVector<Triangle> sorted(triangles.get_allocator());
+        sorted.reserve(triangles.capacity());
+        for (uint64_t k : keys)
+        {
+            sorted.push_back(triangles.at(k & 0xffffffff));
+        }
+        triangles.swap(sorted);
+    }
+    for (Edge &e : edges)
+    {
+        e.ita = newIndices.at(static_cast<unsigned long>(e.ita));
+        if (e.itb >= 0)
+        {
+            e.itb = newIndices.at(static_cast<unsigned long>(e.itb));
+        }
+    }
+
+    // Phase 3: Edges, by their midpoints. Triangles point to their new indices.
+    keys.clear();
+    keys.reserve(edges.size());
+    for (unsigned long i(0); i < edges.size(); i++)
+    {
+        const Edge &e(edges.at(i));
+        const Vertex &A(vertices.at(static_cast<unsigned long>(e.iv1)));
+        const Vertex &B(vertices.at(static_cast<unsigned long>(e.iv2)));
+        keys.push_back(key((A.x + B.x) / 2.0f, (A.y + B.y) / 2.0f, i));
+    }
+    order(keys, newIndices);
+    {
+        MeshVector<Edge> sorted(edges.get_allocator());
+        sorted.reserve(edges.capacity());
+        for (uint64_t k : keys)
+        {
+            sorted.push_back(edges.at(k & 0xffffffff));
+        }
+        edges.swap(sorted);
+    }
+    for (Triangle &t : triangles)
+    {
+        t.ie1 = newIndices.at(static_cast<unsigned long>(t.ie1));
+        t.ie2 = newIndices.at(static_cast<unsigned long>(t.ie2));
+        t.ie3 = newIndices.at(static_cast<unsigned long>(t.ie3));
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    qInfo() << "Locality order :" << elapsed << "nanoseconds";
+}
+
+uint64_t LocalityOrder::key(float x, float y, unsigned long index) const
+{
+    uint64_t qx(static_cast<uint64_t>((x - m_minX) * m_scaleX));
+    uint64_t qy(static_cast<uint64_t>((y - m_minY) * m_scaleY));
+
+    // Spread the 16 bits of each coordinate so they can be interleaved.
+    for (uint64_t *q : {&qx, &qy})
+    {
+        *q = (*q | (*q << 8)) & 0x00ff00ff;
+        *q = (*q | (*q << 4)) & 0x0f0f0f0f;
+        *q = (*q | (*q << 2)) & 0x33333333;
+        *q = (*q | (*q << 1)) & 0x55555555;
+    }
+
+    uint64_t code((qy << 1) | qx);
+    return (code << 32) | static_cast<uint64_t>(index);
+}
+
+void LocalityOrder::order(MeshVector<uint64_t> &keys,
+                          MeshVector<cl_int> &newIndices) const
+{
+    std::sort(keys.begin(), keys.end());
+
+    newIndices.resize(keys.size());
+    for (unsigned long i(0); i < keys.size(); i++)
+    {
+        newIndices.at(keys.at(i) & 0xffffffff) = static_cast<cl_int>(i);
+    }
+}
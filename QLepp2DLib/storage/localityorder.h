@@ -0,0 +1,84 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCALITYORDER_H
+#define LOCALITYORDER_H
+
+#include <cstdint>
+
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Reorders a mesh along a Z-order (Morton) curve, so elements that are
+* close in the plane are also close in memory. The engines walk the vectors
+* in order, so they work on spatially coherent blocks and Lepp walks stay
+* among a few pages.
+*
+*/
+class LocalityOrder
+{
+public:
+    /**
+    * @brief Constructor of LocalityOrder.
+    *
+    */
+    LocalityOrder();
+
+    /**
+    * @brief Reorders vertices, triangles and edges, updating every index.
+    *
+    * @param vertices p_vertices: Vector of vertices.
+    * @param edges p_edges: Vector of edges.
+    * @param triangles p_triangles: Vector of triangles.
+    */
+    void sort(MeshVector<Vertex> &vertices,
+              MeshVector<Edge> &edges,
+              MeshVector<Triangle> &triangles);
+
+private:
+    /**
+    * @brief Builds a sorting key for an element: its Morton code (16 bits per
+    * axis, relative to the bounding box of the mesh) followed by its index.
+    *
+    * @param x p_x: X coordinate.
+    * @param y p_y: Y coordinate.
+    * @param index p_index: Index of the element.
+    * @return Key that sorts by position.
+    */
+    uint64_t key(float x, float y, unsigned long index) const;
+
+    /**
+    * @brief Sorts the keys and gets the new position of each old index.
+    *
+    * @param keys p_keys: Keys of every element. Sorted in place.
+    * @param newIndices p_newIndices: New position of each old index.
+    */
+    void order(MeshVector<uint64_t> &keys,
+               MeshVector<cl_int> &newIndices) const;
+
+    float m_minX;
+    float m_minY;
+    float m_scaleX;
+    float m_scaleY;
+};
+
+#endif // LOCALITYORDER_H
@@ -0,0 +1,123 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QtGlobal>
+
+#include <cstddef>
+#include <new>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdlib>
+#endif
+
+#include <structs/meshvector.h>
+
+namespace
+{
+    // Smaller blocks aren't worth a file (and there would be too many of them).
+    const std::size_t MAPPED_THRESHOLD(64 << 20);
+
+    /* Every block starts with a header that tells how it was allocated, so
+     * releasing it needs no lock nor lookup. It keeps the alignment of new.
+     */
+    const std::size_t HEADER(alignof(std::max_align_t));
+    const std::size_t HEAP_BLOCK(0);
+    const std::size_t MAPPED_BLOCK(1);
+
+    void *withHeader(void *block, std::size_t kind)
+    {
+        *static_cast<std::size_t *>(block) = kind;
+        return static_cast<char *>(block) + HEADER;
+    }
+}
+
+MappedStorage::MappedStorage(std::string directory)
+{
+    if (not directory.empty())
+    {
+        m_directory = std::make_shared<const std::string>(directory);
+    }
+}
+
+bool MappedStorage::isSupported()
+{
+#ifdef Q_OS_UNIX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MappedStorage::isFileBacked() const
+{
+    return static_cast<bool>(m_directory);
+}
+
+void *MappedStorage::allocate(std::size_t bytes) const
+{
+#ifdef Q_OS_UNIX
+    if (m_directory and bytes >= MAPPED_THRESHOLD)
+    {
+        std::string pattern(*m_directory + "/qlepp2d-XXXXXX");
+        std::vector<char> filename(pattern.begin(), pattern.end());
+        filename.push_back('\0');
+
+        int fd = ::mkstemp(filename.data());
+        if (fd >= 0)
+        {
+            // The file disappears from the directory, and from the disk when unmapped.
+            ::unlink(filename.data());
+
+            // Sparse file: disk is only used by the pages that are touched.
+            void *block(MAP_FAILED);
+            if (::ftruncate(fd, static_cast<off_t>(bytes + HEADER)) == 0)
+            {
+                block = ::mmap(nullptr, bytes + HEADER, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+
+            if (block != MAP_FAILED)
+            {
+                return withHeader(block, MAPPED_BLOCK);
+            }
+        }
+        qWarning() << "Could not map" << static_cast<qint64>(bytes) << "bytes in"
+                   << QString::fromStdString(*m_directory) << "(falling back to memory)";
+    }
+#endif
+    return withHeader(::operator new(bytes + HEADER), HEAP_BLOCK);
+}
+
+void MappedStorage::deallocate(void *block, std::size_t bytes)
+{
+    void *start(static_cast<char *>(block) - HEADER);
+#ifdef Q_OS_UNIX
+    if (*static_cast<std::size_t *>(start) == MAPPED_BLOCK)
+    {
+        ::munmap(start, bytes + HEADER);
+        return;
+    }
+#else
+    Q_UNUSED(bytes)
+#endif
+    ::operator delete(start);
+}
@@ -0,0 +1,70 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+/**
+* @brief A mesh file to refine in a batch, and where to save the result.
+*
+*/
+typedef struct {
+    std::string input;
+    std::string output;
+} BatchJob;
+
+/**
+* @brief Outcome of one job of a batch.
+*
+*/
+typedef struct {
+    std::string input;
+    std::string output;
+    bool ok;
+    unsigned long rounds;
+    unsigned long triangles;
+} BatchResult;
+
+/**
+* @brief Outcome of a whole batch, with its aggregate throughput.
+*
+*/
+struct BatchReport
+{
+    std::vector<BatchResult> results;
+    unsigned long meshes = 0;               // Successfully refined and saved
+    unsigned long failed = 0;
+    unsigned long long triangles = 0;       // Triangles of the saved meshes
+    double seconds = 0;                     // Wall time of the whole batch
+
+    double meshesPerSecond() const
+    {
+        return (seconds > 0) ? meshes / seconds : 0;
+    }
+
+    double trianglesPerSecond() const
+    {
+        return (seconds > 0) ? triangles / seconds : 0;
+    }
+};
+
+#endif // BATCH_H
@@ -0,0 +1,93 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <string>
+#include <vector>
+
+/**
+* @brief Memory of one of the vectors of the mesh.
+*
+*/
+struct VectorMemory
+{
+    unsigned long size = 0;
+    unsigned long capacity = 0;
+    unsigned long elementBytes = 0;
+
+    unsigned long long usedBytes() const
+    {
+        return static_cast<unsigned long long>(size) * elementBytes;
+    }
+
+    unsigned long long reservedBytes() const
+    {
+        return static_cast<unsigned long long>(capacity) * elementBytes;
+    }
+};
+
+/**
+* @brief Memory of the buffers of an engine in a device.
+*
+*/
+struct DeviceMemory
+{
+    std::string device;
+    unsigned long long bytes = 0;           // Held by the buffers of the engine
+    unsigned long long capacity = 0;        // Global memory of the device
+};
+
+/**
+* @brief Memory used by a model, and the memory its next improvement round
+* needs, so a round that won't fit can be avoided before it starts.
+*
+*/
+struct MemoryReport
+{
+    VectorMemory vertices;
+    VectorMemory edges;
+    VectorMemory triangles;
+    std::vector<DeviceMemory> devices;      // Empty for engines without devices
+    unsigned long long loadTransientBytes = 0;  // Peak temporaries of the last load
+    unsigned long long availableBytes = 0;  // Available in the system (0 if unknown)
+    unsigned long pendingInsertions = 0;    // At most one per bad triangle
+    unsigned long long nextRoundHostBytes = 0;      // Host bytes the next round adds, at its peak
+    unsigned long long nextRoundDeviceBytes = 0;    // Device bytes of the next round
+
+    unsigned long long hostBytes() const
+    {
+        return vertices.reservedBytes() + edges.reservedBytes() + triangles.reservedBytes();
+    }
+
+    bool nextRoundFits() const
+    {
+        for (const DeviceMemory &device : devices)
+        {
+            if (device.capacity > 0 and nextRoundDeviceBytes > device.capacity)
+            {
+                return false;
+            }
+        }
+        return (availableBytes == 0 or nextRoundHostBytes <= availableBytes);
+    }
+};
+
+#endif // MEMORYREPORT_H
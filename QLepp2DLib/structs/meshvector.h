@@ -0,0 +1,146 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MESHVECTOR_H
+#define MESHVECTOR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+* @brief Memory used by the vectors of a mesh.
+* By default it's the usual heap. When it has a directory, big blocks are
+* file-backed memory maps in that directory (out-of-core), so the mesh size
+* isn't limited by the RAM anymore. Copies share the directory.
+*
+*/
+class MappedStorage
+{
+public:
+    /**
+    * @brief Constructor of MappedStorage, that only uses the heap.
+    *
+    */
+    MappedStorage() = default;
+
+    /**
+    * @brief Constructor of MappedStorage.
+    *
+    * @param directory p_directory: Directory of the file-backed blocks. Empty to use only the heap.
+    */
+    explicit MappedStorage(std::string directory);
+
+    /**
+    * @brief Checks if file-backed blocks are supported by the system.
+    *
+    * @return True if supported.
+    */
+    static bool isSupported();
+
+    /**
+    * @brief Checks if big blocks are file-backed.
+    *
+    * @return True if there's a directory.
+    */
+    bool isFileBacked() const;
+
+    /**
+    * @brief Allocates a block of memory.
+    *
+    * @param bytes p_bytes: Size of the block.
+    * @return Pointer to the block.
+    */
+    void *allocate(std::size_t bytes) const;
+
+    /**
+    * @brief Releases a block allocated by any MappedStorage.
+    *
+    * @param block p_block: Pointer to the block.
+    * @param bytes p_bytes: Size of the block.
+    */
+    static void deallocate(void *block, std::size_t bytes);
+
+private:
+    std::shared_ptr<const std::string> m_directory;
+};
+
+/**
+* @brief Allocator that takes its memory from a MappedStorage.
+* The storage moves with the elements of a vector, so a vector swapped into
+* a mesh keeps growing where it was allocated.
+*
+*/
+template <typename T>
+struct MeshAllocator
+{
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    MeshAllocator() = default;
+
+    MeshAllocator(const MappedStorage &storage)
+        : storage(storage)
+    {
+    }
+
+    template <typename U>
+    MeshAllocator(const MeshAllocator<U> &other)
+        : storage(other.storage)
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(storage.allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        MappedStorage::deallocate(p, n * sizeof(T));
+    }
+
+    MappedStorage storage;
+};
+
+// Every block knows how it was allocated, so any allocator can release it.
+template <typename T, typename U>
+bool operator==(const MeshAllocator<T> &, const MeshAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const MeshAllocator<T> &, const MeshAllocator<U> &)
+{
+    return false;
+}
+
+/**
+* @brief Vector used for the vertices, edges and triangles of the mesh.
+* It's a plain std::vector, only its memory may come from a file.
+*
+*/
+template <typename T>
+using MeshVector = std::vector<T, MeshAllocator<T>>;
+
+#endif // MESHVECTOR_H
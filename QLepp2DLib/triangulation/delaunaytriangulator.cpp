@@ -0,0 +1,501 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include <metrics/allocationtracker.h>
+#include <metrics/tracer.h>
+#include <triangulation/delaunaytriangulator.h>
+
+/* Predicates are evaluated in double precision. The coordinates are floats,
+ * so differences and their products are exact and "orient" always has the
+ * right sign for points of similar magnitude. "inCircle" can be wrong for
+ * almost cocircular points; that only gives a slightly non-Delaunay (but
+ * valid) triangulation, because cavities are always kept star-shaped.
+ */
+
+namespace
+{
+    // > 0 if (a, b, c) is counter-clockwise, 0 if collinear.
+    inline double orient(const Vertex &a, const Vertex &b, const Vertex &c)
+    {
+        return (static_cast<double>(a.x) - c.x) * (static_cast<double>(b.y) - c.y) -
+               (static_cast<double>(a.y) - c.y) * (static_cast<double>(b.x) - c.x);
+    }
+
+    // > 0 if d is inside the circumcircle of the counter-clockwise (a, b, c).
+    inline double inCircle(const Vertex &a, const Vertex &b, const Vertex &c, const Vertex &d)
+    {
+        double adx = static_cast<double>(a.x) - d.x;
+        double ady = static_cast<double>(a.y) - d.y;
+        double bdx = static_cast<double>(b.x) - d.x;
+        double bdy = static_cast<double>(b.y) - d.y;
+        double cdx = static_cast<double>(c.x) - d.x;
+        double cdy = static_cast<double>(c.y) - d.y;
+
+        return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) +
+               (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+               (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    }
+
+    // Interleaves the lower 13 bits of x and y.
+    inline uint64_t morton(uint32_t x, uint32_t y)
+    {
+        uint64_t code(0);
+        for (int bit(0); bit < 13; bit++)
+        {
+            code |= static_cast<uint64_t>((x >> bit) & 1) << (2 * bit);
+            code |= static_cast<uint64_t>((y >> bit) & 1) << (2 * bit + 1);
+        }
+        return code;
+    }
+
+    // Index of the edge (a, b) in a triangle (the local index of its opposite vertex).
+    template<typename Cell>
+    inline int edgeIndex(const Cell &c, cl_int a, cl_int b)
+    {
+        for (int i(0); i < 3; i++)
+        {
+            cl_int u(c.v[(i + 1) % 3]);
+            cl_int w(c.v[(i + 2) % 3]);
+            if ((u == a and w == b) or (u == b and w == a))
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+}
+
+DelaunayTriangulator::DelaunayTriangulator(unsigned long seed)
+    : m_seed(seed),
+      m_walkState(0),
+      m_last(0),
+      m_stamp(0)
+{
+}
+
+bool DelaunayTriangulator::triangulate(MeshVector<Vertex> &vertices,
+                                       MeshVector<Edge> &edges,
+                                       MeshVector<Triangle> &triangles)
+{
+    TraceSpan span("triangulate", "triangulation");
+    AllocationScope allocations("triangulate");
+    QElapsedTimer timer;
+    timer.start();
+
+    unsigned long count(vertices.size());
+    if (count < 3 or count > static_cast<unsigned long>(std::numeric_limits<cl_int>::max() - 3))
+    {
+        return false;
+    }
+
+    // Super-triangle, big enough to contain every point well inside it.
+    float minX(std::numeric_limits<float>::max());
+    float minY(std::numeric_limits<float>::max());
+    float maxX(std::numeric_limits<float>::lowest());
+    float maxY(std::numeric_limits<float>::lowest());
+    for (const Vertex &v : vertices)
+    {
+        minX = std::min(minX, v.x);
+        minY = std::min(minY, v.y);
+        maxX = std::max(maxX, v.x);
+        maxY = std::max(maxY, v.y);
+    }
+    float size = std::max(std::max(maxX - minX, maxY - minY), 1e-6f);
+    float cx = (minX + maxX) / 2;
+    float cy = (minY + maxY) / 2;
+
+    std::vector<cl_int> order = insertionOrder(vertices, count);
+
+    const float M(100.0f);
+    vertices.push_back(Vertex{cx - M * size, cy - M * size, 0});
+    vertices.push_back(Vertex{cx + M * size, cy - M * size, 0});
+    vertices.push_back(Vertex{cx, cy + M * size, 0});
+
+    cl_int super(static_cast<cl_int>(count));
+    m_cells.clear();
+    m_marks.clear();
+    m_cells.reserve(2 * count + 1);
+    m_cells.push_back(Cell{{super, super + 1, super + 2}, {-1, -1, -1}});
+    m_marks.push_back(0);
+    m_last = 0;
+    m_stamp = 0;
+    m_walkState = 0x9e3779b97f4a7c15ull ^ m_seed;
+
+    unsigned long repeated(0);
+    for (cl_int ip : order)
+    {
+        if (not insert(vertices, ip))
+        {
+            repeated++;
+        }
+    }
+
+    bool ok = finish(vertices, edges, triangles, count);
+
+    qInfo() << "Delaunay: " << count << "points," << repeated << "repeated," << triangles.size()
+            << "triangles in" << timer.nsecsElapsed() << "nanoseconds";
+    return ok;
+}
+
+std::vector<cl_int> DelaunayTriangulator::insertionOrder(const MeshVector<Vertex> &vertices,
+                                                        unsigned long count) const
+{
+    float minX(std::numeric_limits<float>::max());
+    float minY(std::numeric_limits<float>::max());
+    float maxX(std::numeric_limits<float>::lowest());
+    float maxY(std::numeric_limits<float>::lowest());
+    for (unsigned long i(0); i < count; i++)
+    {
+        minX = std::min(minX, vertices[i].x);
+        minY = std::min(minY, vertices[i].y);
+        maxX = std::max(maxX, vertices[i].x);
+        maxY = std::max(maxY, vertices[i].y);
+    }
+    float scaleX = (maxX > minX) ? 8191.0f / (maxX - minX) : 0.0f;
+    float scaleY = (maxY > minY) ? 8191.0f / (maxY - minY) : 0.0f;
+
+    /* Key: round (5 bits, earlier rounds first) | Z-order (26 bits) | index (32 bits).
+     * A point is in round r with probability 2^-(r+1), so the last round has
+     * half of the points, the previous one a quarter, and so on.
+     */
+    const uint64_t ROUNDS(31);
+    std::mt19937_64 generator(m_seed);
+    std::vector<uint64_t> keys(count);
+    for (unsigned long i(0); i < count; i++)
+    {
+        uint64_t bits = generator();
+        uint64_t round(0);
+        while (round < ROUNDS and (bits & 1))
+        {
+            bits >>= 1;
+            round++;
+        }
+        uint32_t x = static_cast<uint32_t>((vertices[i].x - minX) * scaleX);
+        uint32_t y = static_cast<uint32_t>((vertices[i].y - minY) * scaleY);
+        keys[i] = ((ROUNDS - round) << 58) | (morton(x, y) << 32) | i;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<cl_int> order(count);
+    for (unsigned long i(0); i < count; i++)
+    {
+        order[i] = static_cast<cl_int>(keys[i] & 0xffffffff);
+    }
+    return order;
+}
+
+cl_int DelaunayTriangulator::locate(const MeshVector<Vertex> &vertices, const Vertex &p, cl_int start)
+{
+    // Visibility walk. Starting at a random edge avoids cycles.
+    cl_int t(start);
+    for (unsigned long steps(0); steps <= m_cells.size(); steps++)
+    {
+        const Cell &c(m_cells[t]);
+        m_walkState ^= m_walkState << 13;
+        m_walkState ^= m_walkState >> 7;
+        m_walkState ^= m_walkState << 17;
+        int first(static_cast<int>(m_walkState % 3));
+
+        cl_int next(-1);
+        for (int k(0); k < 3; k++)
+        {
+            int i((first + k) % 3);
+            if (orient(vertices[c.v[(i + 1) % 3]], vertices[c.v[(i + 2) % 3]], p) < 0)
+            {
+                next = c.n[i];
+                break;
+            }
+        }
+        if (next < 0)
+        {
+            return t;
+        }
+        t = next;
+    }
+
+    // Only reached if rounding made the walk loop: look at every triangle.
+    for (cl_int i(0); i < static_cast<cl_int>(m_cells.size()); i++)
+    {
+        const Cell &c(m_cells[i]);
+        if (orient(vertices[c.v[0]], vertices[c.v[1]], p) >= 0 and
+            orient(vertices[c.v[1]], vertices[c.v[2]], p) >= 0 and
+            orient(vertices[c.v[2]], vertices[c.v[0]], p) >= 0)
+        {
+            return i;
+        }
+    }
+    return start;
+}
+
+bool DelaunayTriangulator::insert(const MeshVector<Vertex> &vertices, cl_int ip)
+{
+    const Vertex &p(vertices[ip]);
+    cl_int seed = locate(vertices, p, m_last);
+    cl_int seeds[2] = {seed, -1};
+
+    // A point on an edge also needs the triangle on the other side.
+    int zeros(0);
+    for (int i(0); i < 3; i++)
+    {
+        const Cell &c(m_cells[seed]);
+        if (orient(vertices[c.v[(i + 1) % 3]], vertices[c.v[(i + 2) % 3]], p) == 0)
+        {
+            zeros++;
+            seeds[1] = c.n[i];
+        }
+    }
+    if (zeros > 1)
+    {
+        return false;                                       // Same position as a vertex
+    }
+
+    // Phase 1: Cavity (triangles whose circumcircle contains p), grown from the seeds.
+    m_stamp++;
+    m_cavity.clear();
+    for (cl_int s : seeds)
+    {
+        if (s >= 0)
+        {
+            m_marks[s] = m_stamp;
+            m_cavity.push_back(s);
+        }
+    }
+    for (unsigned long k(0); k < m_cavity.size(); k++)
+    {
+        const Cell &c(m_cells[m_cavity[k]]);
+        for (int i(0); i < 3; i++)
+        {
+            cl_int nb(c.n[i]);
+            if (nb < 0 or m_marks[nb] == m_stamp)
+            {
+                continue;
+            }
+            const Cell &d(m_cells[nb]);
+            if (inCircle(vertices[d.v[0]], vertices[d.v[1]], vertices[d.v[2]], p) > 0)
+            {
+                m_marks[nb] = m_stamp;
+                m_cavity.push_back(nb);
+            }
+        }
+    }
+
+    /* Phase 2: Every boundary edge must see p, or the new triangles would
+     * overlap. Rounding in inCircle can break that, so the offending triangles
+     * leave the cavity until it's star-shaped. The seeds always see p.
+     */
+    struct Boundary
+    {
+        cl_int a;
+        cl_int b;
+        cl_int outside;
+    };
+    std::vector<Boundary> boundary;
+
+    bool starShaped(false);
+    while (not starShaped)
+    {
+        starShaped = true;
+        boundary.clear();
+        for (cl_int t : m_cavity)
+        {
+            const Cell &c(m_cells[t]);
+            for (int i(0); i < 3 and m_marks[t] == m_stamp; i++)
+            {
+                cl_int nb(c.n[i]);
+                if (nb >= 0 and m_marks[nb] == m_stamp)
+                {
+                    continue;
+                }
+                cl_int a(c.v[(i + 1) % 3]);
+                cl_int b(c.v[(i + 2) % 3]);
+                if (orient(vertices[a], vertices[b], p) <= 0 and t != seeds[0] and t != seeds[1])
+                {
+                    m_marks[t] = 0;
+                    starShaped = false;
+                }
+                else
+                {
+                    boundary.push_back(Boundary{a, b, nb});
+                }
+            }
+        }
+        if (not starShaped)
+        {
+            m_cavity.erase(std::remove_if(m_cavity.begin(), m_cavity.end(), [this](cl_int t) {
+                return m_marks[t] != m_stamp;
+            }), m_cavity.end());
+        }
+    }
+
+    // Phase 3: A fan of new triangles (a, b, p), reusing the slots of the cavity.
+    std::vector<cl_int> fan(m_cavity);
+    while (fan.size() < boundary.size())
+    {
+        fan.push_back(static_cast<cl_int>(m_cells.size()));
+        m_cells.push_back(Cell{{-1, -1, -1}, {-1, -1, -1}});
+        m_marks.push_back(0);
+    }
+
+    // New triangle that starts at each boundary vertex, to link the fan.
+    std::vector<std::pair<cl_int, cl_int>> byStart;
+    byStart.reserve(boundary.size());
+    for (unsigned long j(0); j < boundary.size(); j++)
+    {
+        byStart.push_back(std::make_pair(boundary[j].a, fan[j]));
+    }
+    std::sort(byStart.begin(), byStart.end());
+    auto startingAt = [&byStart](cl_int v) {
+        return std::lower_bound(byStart.begin(), byStart.end(), std::make_pair(v, std::numeric_limits<cl_int>::min()))->second;
+    };
+
+    for (unsigned long j(0); j < boundary.size(); j++)
+    {
+        const Boundary &e(boundary[j]);
+        Cell &c(m_cells[fan[j]]);
+        c.v[0] = e.a;
+        c.v[1] = e.b;
+        c.v[2] = ip;
+        c.n[0] = startingAt(e.b);                           // Across (b, p)
+        c.n[2] = e.outside;                                 // Across (a, b)
+        m_marks[fan[j]] = 0;
+
+        if (e.outside >= 0)
+        {
+            Cell &o(m_cells[e.outside]);
+            o.n[edgeIndex(o, e.a, e.b)] = fan[j];
+        }
+    }
+    for (unsigned long j(0); j < boundary.size(); j++)
+    {
+        Cell &c(m_cells[fan[j]]);
+        m_cells[c.n[0]].n[1] = fan[j];                    // Across (p, a) of the next one
+    }
+
+    m_last = fan.front();
+    return true;
+}
+
+bool DelaunayTriangulator::finish(MeshVector<Vertex> &vertices,
+                                  MeshVector<Edge> &edges,
+                                  MeshVector<Triangle> &triangles,
+                                  unsigned long count)
+{
+    cl_int super(static_cast<cl_int>(count));
+
+    // Phase 1: Remove the triangles of the super-triangle.
+    std::vector<cl_int> newCells(m_cells.size(), -1);
+    cl_int kept(0);
+    for (unsigned long t(0); t < m_cells.size(); t++)
+    {
+        const Cell &c(m_cells[t]);
+        if (c.v[0] < super and c.v[1] < super and c.v[2] < super)
+        {
+            newCells[t] = kept++;
+        }
+    }
+
+    // Phase 2: Remove the vertices without triangles (repeated and super).
+    std::vector<cl_int> newVertices(vertices.size(), -1);
+    for (unsigned long t(0); t < m_cells.size(); t++)
+    {
+        if (newCells[t] >= 0)
+        {
+            for (cl_int v : m_cells[t].v)
+            {
+                newVertices[v] = 0;
+            }
+        }
+    }
+    cl_int used(0);
+    for (unsigned long v(0); v < vertices.size(); v++)
+    {
+        if (newVertices[v] == 0)
+        {
+            newVertices[v] = used;
+            vertices[used++] = vertices[v];
+        }
+    }
+    vertices.resize(used);
+
+    // Phase 3: Triangles and edges, as the engines expect them.
+    triangles.clear();
+    edges.clear();
+    triangles.reserve(kept);
+    edges.reserve(static_cast<unsigned long>(kept) * 3 / 2 + 2);
+
+    for (unsigned long t(0); t < m_cells.size(); t++)
+    {
+        if (newCells[t] >= 0)
+        {
+            const Cell &c(m_cells[t]);
+            triangles.push_back(Triangle{newVertices[c.v[0]], newVertices[c.v[1]], newVertices[c.v[2]],
+                                         -1, -1, -1, 0});
+        }
+    }
+
+    for (unsigned long t(0); t < m_cells.size(); t++)
+    {
+        cl_int it(newCells[t]);
+        if (it < 0)
+        {
+            continue;
+        }
+        const Cell &c(m_cells[t]);
+        cl_int *ie[3] = {&triangles[it].ie1, &triangles[it].ie2, &triangles[it].ie3};
+
+        for (int i(0); i < 3; i++)
+        {
+            cl_int nb(c.n[i] >= 0 ? newCells[c.n[i]] : -1);
+
+            // Each inner edge is created by the triangle with the lower index
+            if (nb >= 0 and nb < it)
+            {
+                continue;
+            }
+
+            cl_int iv1(newVertices[c.v[(i + 1) % 3]]);
+            cl_int iv2(newVertices[c.v[(i + 2) % 3]]);
+            cl_int k(static_cast<cl_int>(edges.size()));
+            edges.push_back(Edge{it, nb, std::min(iv1, iv2), std::max(iv1, iv2), 0});
+
+            // ie1 is the edge opposite to iv1, and so on
+            *ie[i] = k;
+            if (nb >= 0)
+            {
+                const Cell &d(m_cells[c.n[i]]);
+                cl_int *je[3] = {&triangles[nb].ie1, &triangles[nb].ie2, &triangles[nb].ie3};
+                *je[edgeIndex(d, c.v[(i + 1) % 3], c.v[(i + 2) % 3])] = k;
+            }
+        }
+    }
+
+    m_cells.clear();
+    m_cells.shrink_to_fit();
+    m_marks.clear();
+    m_marks.shrink_to_fit();
+
+    return not triangles.empty();
+}
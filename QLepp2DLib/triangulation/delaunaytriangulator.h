@@ -0,0 +1,116 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DELAUNAYTRIANGULATOR_H
+#define DELAUNAYTRIANGULATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Builds the 2D Delaunay triangulation (on x, y) of a point cloud, with
+* the complete topology that the engines need.
+*
+* Points are inserted incrementally (Bowyer-Watson) in a Biased Randomized
+* Insertion Order (BRIO): random rounds of doubling size, each one sorted
+* along a Z-order curve. Each point is located by walking from the last new
+* triangle, so the expected cost is linear in practice.
+*
+*/
+class DelaunayTriangulator
+{
+public:
+    /**
+    * @brief Constructor of DelaunayTriangulator.
+    *
+    * @param seed p_seed: Seed of the insertion order. The same points and
+    * seed always give the same triangulation.
+    */
+    explicit DelaunayTriangulator(unsigned long seed = 1);
+
+    /**
+    * @brief Triangulates the vertices. Repeated points, and points that end
+    * up outside of every triangle, are removed from the vertices.
+    *
+    * @param vertices p_vertices: Points to triangulate.
+    * @param edges p_edges: Vector of edges. Old data is removed.
+    * @param triangles p_triangles: Vector of triangles. Old data is removed.
+    * @return False if there aren't 3 non-collinear points.
+    */
+    bool triangulate(MeshVector<Vertex> &vertices,
+                     MeshVector<Edge> &edges,
+                     MeshVector<Triangle> &triangles);
+
+private:
+    /**
+    * @brief Triangle during the construction. Counter-clockwise, and n[i] is
+    * the neighbour opposite to v[i] (-1 if none).
+    *
+    */
+    struct Cell
+    {
+        cl_int v[3];
+        cl_int n[3];
+    };
+
+    /**
+    * @brief Computes the insertion order of the points.
+    *
+    */
+    std::vector<cl_int> insertionOrder(const MeshVector<Vertex> &vertices, unsigned long count) const;
+
+    /**
+    * @brief Finds a triangle that contains the point, walking from "start".
+    *
+    */
+    cl_int locate(const MeshVector<Vertex> &vertices, const Vertex &p, cl_int start);
+
+    /**
+    * @brief Inserts a point, replacing the triangles whose circumcircle
+    * contains it.
+    *
+    * @return False if the point is repeated.
+    */
+    bool insert(const MeshVector<Vertex> &vertices, cl_int ip);
+
+    /**
+    * @brief Removes the triangles of the initial super-triangle and the
+    * unused points, and writes the final vectors.
+    *
+    */
+    bool finish(MeshVector<Vertex> &vertices,
+                MeshVector<Edge> &edges,
+                MeshVector<Triangle> &triangles,
+                unsigned long count);
+
+    unsigned long m_seed;
+    uint64_t m_walkState;
+    cl_int m_last;
+    unsigned int m_stamp;
+    std::vector<Cell> m_cells;
+    std::vector<unsigned int> m_marks;
+    std::vector<cl_int> m_cavity;
+};
+
+#endif // DELAUNAYTRIANGULATOR_H
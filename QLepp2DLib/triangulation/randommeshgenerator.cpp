@@ -0,0 +1,56 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+
+#include <triangulation/randommeshgenerator.h>
+#include <triangulation/delaunaytriangulator.h>
+
+RandomMeshGenerator::RandomMeshGenerator(unsigned long seed)
+    : m_seed(seed)
+{
+}
+
+bool RandomMeshGenerator::generate(unsigned long points,
+                                   MeshVector<Vertex> &vertices,
+                                   MeshVector<Edge> &edges,
+                                   MeshVector<Triangle> &triangles)
+{
+    /* std::mt19937_64 is fully specified by the standard, but the
+     * distributions aren't, so the float is built from its 24 top bits.
+     */
+    std::mt19937_64 generator(m_seed);
+    auto uniform = [&generator]() {
+        return 2.0f * static_cast<float>(generator() >> 40) / 16777216.0f - 1.0f;
+    };
+
+    vertices.clear();
+    vertices.reserve(points + 3);               // + the super-triangle of the triangulator
+    for (unsigned long i(0); i < points; i++)
+    {
+        Vertex v;
+        v.x = uniform();
+        v.y = uniform();
+        v.z = 0;
+        vertices.push_back(v);
+    }
+
+    DelaunayTriangulator triangulator(m_seed);
+    return triangulator.triangulate(vertices, edges, triangles);
+}
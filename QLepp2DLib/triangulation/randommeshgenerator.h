@@ -0,0 +1,62 @@
+/*
+ * QLepp2D is a triangulation improver and visualization program that uses
+ * a Lepp-Delaunay algorithm.
+ * Copyright (C) 2017-2019 Gabriel Sanhueza <gabriel_8032@hotmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RANDOMMESHGENERATOR_H
+#define RANDOMMESHGENERATOR_H
+
+#include <structs/vertex.h>
+#include <structs/edge.h>
+#include <structs/triangle.h>
+#include <structs/meshvector.h>
+
+/**
+* @brief Generates the Delaunay mesh of uniformly random points in the
+* [-1, 1] x [-1, 1] square (with z = 0). The same seed gives the same mesh on
+* every platform, so benchmark inputs can be rebuilt instead of shared.
+*
+*/
+class RandomMeshGenerator
+{
+public:
+    /**
+    * @brief Constructor of RandomMeshGenerator.
+    *
+    * @param seed p_seed: Seed of the points and of the triangulation.
+    */
+    explicit RandomMeshGenerator(unsigned long seed = 1);
+
+    /**
+    * @brief Generates a mesh. It has about 2 * points triangles.
+    *
+    * @param points p_points: Number of random points.
+    * @param vertices p_vertices: Vector of vertices. Old data is removed.
+    * @param edges p_edges: Vector of edges. Old data is removed.
+    * @param triangles p_triangles: Vector of triangles. Old data is removed.
+    * @return True if correctly generated.
+    */
+    bool generate(unsigned long points,
+                  MeshVector<Vertex> &vertices,
+                  MeshVector<Edge> &edges,
+                  MeshVector<Triangle> &triangles);
+
+private:
+    unsigned long m_seed;
+};
+
+#endif // RANDOMMESHGENERATOR_H